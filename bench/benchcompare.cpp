@@ -0,0 +1,446 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "argsparser.h"
+#include "outputsink.h"
+#include "sourcefile.h"
+
+using namespace std;
+using namespace rectangle;
+using namespace rectangle::frontend;
+using namespace rectangle::util;
+
+// Compares the json written by rectangle_bench --benchmark_format=json
+// against a baseline and fails on regressions. With repetitions only the
+// median aggregate of every benchmark is used, whether or not the single
+// runs are reported as well.
+
+namespace {
+
+struct Value {
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+  Type type = Type::Null;
+  bool boolean = false;
+  double number = 0;
+  string str;
+  vector<Value> array;
+  map<string, Value> object;
+
+  const Value *get(const string &key) const {
+    auto it = object.find(key);
+    return it == object.end() ? nullptr : &it->second;
+  }
+};
+
+class JsonReader {
+ public:
+  explicit JsonReader(const string &text) : m_text(text) {}
+
+  bool read(Value &v) {
+    if (!readValue(v)) {
+      return false;
+    }
+    skipSpace();
+    return m_pos == m_text.size();
+  }
+
+ private:
+  void skipSpace() {
+    while (m_pos < m_text.size() && isspace(m_text[m_pos])) {
+      m_pos++;
+    }
+  }
+
+  bool consume(char c) {
+    skipSpace();
+    if (m_pos < m_text.size() && m_text[m_pos] == c) {
+      m_pos++;
+      return true;
+    }
+    return false;
+  }
+
+  bool consumeWord(const char *word) {
+    size_t n = strlen(word);
+    if (m_text.compare(m_pos, n, word) != 0) {
+      return false;
+    }
+    m_pos += n;
+    return true;
+  }
+
+  bool readString(string &s) {
+    if (!consume('"')) {
+      return false;
+    }
+    while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+      char c = m_text[m_pos++];
+      if (c != '\\') {
+        s += c;
+        continue;
+      }
+      if (m_pos >= m_text.size()) {
+        return false;
+      }
+      c = m_text[m_pos++];
+      switch (c) {
+        case 'n':
+          s += '\n';
+          break;
+        case 't':
+          s += '\t';
+          break;
+        case 'r':
+          s += '\r';
+          break;
+        case 'b':
+          s += '\b';
+          break;
+        case 'f':
+          s += '\f';
+          break;
+        case 'u':
+          // names and units are ascii, keep the escape as it is
+          s += "\\u";
+          break;
+        default:
+          s += c;
+          break;
+      }
+    }
+    return consume('"');
+  }
+
+  bool readValue(Value &v) {
+    skipSpace();
+    if (m_pos >= m_text.size()) {
+      return false;
+    }
+    char c = m_text[m_pos];
+    if (c == '{') {
+      m_pos++;
+      v.type = Value::Type::Object;
+      if (consume('}')) {
+        return true;
+      }
+      do {
+        string key;
+        if (!readString(key) || !consume(':') || !readValue(v.object[key])) {
+          return false;
+        }
+      } while (consume(','));
+      return consume('}');
+    }
+    if (c == '[') {
+      m_pos++;
+      v.type = Value::Type::Array;
+      if (consume(']')) {
+        return true;
+      }
+      do {
+        v.array.emplace_back();
+        if (!readValue(v.array.back())) {
+          return false;
+        }
+      } while (consume(','));
+      return consume(']');
+    }
+    if (c == '"') {
+      v.type = Value::Type::String;
+      return readString(v.str);
+    }
+    if (consumeWord("true") || consumeWord("false")) {
+      v.type = Value::Type::Bool;
+      v.boolean = c == 't';
+      return true;
+    }
+    if (consumeWord("null")) {
+      return true;
+    }
+    const char *begin = m_text.c_str() + m_pos;
+    char *end = nullptr;
+    v.number = strtod(begin, &end);
+    if (end == begin) {
+      return false;
+    }
+    v.type = Value::Type::Number;
+    m_pos += static_cast<size_t>(end - begin);
+    return true;
+  }
+
+ private:
+  const string &m_text;
+  size_t m_pos = 0;
+};
+
+struct Result {
+  double timeNs = 0;
+  // allocations per iteration, negative if not counted
+  double allocs = -1;
+};
+
+double nsPerUnit(const string &unit) {
+  if (unit == "us") {
+    return 1e3;
+  } else if (unit == "ms") {
+    return 1e6;
+  } else if (unit == "s") {
+    return 1e9;
+  }
+  return 1;
+}
+
+// benchmarks of the json in path by name, in the order of the file
+bool load(const string &path, vector<pair<string, Result>> &results) {
+  SourceFile file(path);
+  if (!file.valid()) {
+    fprintf(stderr, "error: open %s failed\n", path.c_str());
+    return false;
+  }
+  string text = file.source();
+  Value root;
+  if (!JsonReader(text).read(root) || root.type != Value::Type::Object) {
+    fprintf(stderr, "error: %s is not valid json\n", path.c_str());
+    return false;
+  }
+  const Value *benchmarks = root.get("benchmarks");
+  if (!benchmarks || benchmarks->type != Value::Type::Array) {
+    fprintf(stderr, "error: %s has no benchmarks\n", path.c_str());
+    return false;
+  }
+
+  // with repetitions the runs of a benchmark are followed by aggregates,
+  // its median replaces the run taken first
+  map<string, size_t> index;
+  vector<bool> median;
+  for (auto &b : benchmarks->array) {
+    const Value *runType = b.get("run_type");
+    bool aggregate = runType && runType->str == "aggregate";
+    if (aggregate) {
+      const Value *aggregateName = b.get("aggregate_name");
+      if (!aggregateName || aggregateName->str != "median") {
+        continue;
+      }
+    }
+    const Value *name = b.get("run_name");
+    if (!name) {
+      name = b.get("name");
+    }
+    const Value *time = b.get("real_time");
+    if (!name || !time) {
+      fprintf(stderr, "error: %s has a benchmark without name or time\n",
+              path.c_str());
+      return false;
+    }
+    Result r;
+    const Value *unit = b.get("time_unit");
+    r.timeNs = time->number * nsPerUnit(unit ? unit->str : "ns");
+    const Value *allocs = b.get("allocs");
+    if (allocs) {
+      r.allocs = allocs->number;
+    }
+    auto it = index.find(name->str);
+    if (it == index.end()) {
+      index[name->str] = results.size();
+      results.emplace_back(name->str, r);
+      median.push_back(aggregate);
+    } else if (aggregate && !median[it->second]) {
+      results[it->second].second = r;
+      median[it->second] = true;
+    }
+  }
+  return true;
+}
+
+bool writeBaseline(const string &path,
+                   const vector<pair<string, Result>> &results) {
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp) {
+    fprintf(stderr, "error: open %s failed\n", path.c_str());
+    return false;
+  }
+  bool failed = false;
+  {
+    FileSink sink(fp);
+    sink.write("{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+      const Result &r = results[i].second;
+      sink.write("    {\"name\": ");
+      writeJsonString(sink, results[i].first);
+      sink.print(", \"real_time\": %.1f, \"time_unit\": \"ns\"", r.timeNs);
+      if (r.allocs >= 0) {
+        sink.print(", \"allocs\": %.1f", r.allocs);
+      }
+      sink.write(i + 1 < results.size() ? "},\n" : "}\n");
+    }
+    sink.write("  ]\n}\n");
+    sink.flush();
+    failed = sink.failed();
+  }
+  fclose(fp);
+  if (failed) {
+    fprintf(stderr, "error: write %s failed\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool parseTolerance(const string &s, double &tolerance) {
+  if (s.empty()) {
+    return true;
+  }
+  char *end = nullptr;
+  tolerance = strtod(s.c_str(), &end);
+  if (*end != '\0' || !(tolerance >= 0)) {
+    fprintf(stderr, "error: invalid tolerance %s\n", s.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool update = false;
+  bool allowMissing = false;
+  bool showHelp = false;
+  string timeTolerance;
+  string allocTolerance;
+
+  ArgsParser ap;
+  ap.addOnOffLongOption("update",
+                        "Write the medians of the results as the new "
+                        "baseline instead of comparing",
+                        update);
+  ap.addValueLongOption("time-tolerance",
+                        "Allowed slowdown of the median time, 0.1 is 10% "
+                        "(default 0.1)",
+                        timeTolerance);
+  ap.addValueLongOption("alloc-tolerance",
+                        "Allowed increase of allocations per iteration, "
+                        "0.01 is 1% (default 0.01)",
+                        allocTolerance);
+  ap.addOnOffLongOption("allow-missing",
+                        "Pass when a benchmark of the baseline is not in "
+                        "the results, e.g. when running a filtered suite",
+                        allowMissing);
+  ap.addOnOffLongOption("help", "Show help", showHelp);
+
+  vector<string> files;
+  try {
+    files = ap.parse(argc, argv);
+  } catch (ArgsException &e) {
+    fprintf(stderr, "%s\n", e.what());
+    ap.dumpHelp();
+    return 2;
+  }
+  if (showHelp || files.size() != 2) {
+    fprintf(stderr,
+            "Usage: bench_compare [options] <baseline.json> <results.json>\n"
+            "       bench_compare --update <baseline.json> <results.json>\n");
+    ap.dumpHelp();
+    return showHelp ? EXIT_SUCCESS : 2;
+  }
+
+  double timeTol = 0.1;
+  double allocTol = 0.01;
+  if (!parseTolerance(timeTolerance, timeTol) ||
+      !parseTolerance(allocTolerance, allocTol)) {
+    return 2;
+  }
+
+  vector<pair<string, Result>> results;
+  if (!load(files[1], results)) {
+    return 2;
+  }
+  if (update) {
+    return writeBaseline(files[0], results) ? EXIT_SUCCESS : 2;
+  }
+
+  vector<pair<string, Result>> baseline;
+  if (!load(files[0], baseline)) {
+    return 2;
+  }
+  map<string, Result> current(results.begin(), results.end());
+
+  int regressions = 0;
+  printf("%-64s %12s %12s %8s %10s %10s  %s\n", "benchmark", "base ns",
+         "ns", "time", "base alloc", "allocs", "status");
+  for (auto &pair : baseline) {
+    const string &name = pair.first;
+    const Result &base = pair.second;
+    auto it = current.find(name);
+    if (it == current.end()) {
+      // a renamed or dropped benchmark would pass the gate unnoticed
+      if (!allowMissing) {
+        regressions++;
+      }
+      printf("%-64s %12.0f %12s %8s %10s %10s  %s\n", name.c_str(),
+             base.timeNs, "-", "-", "-", "-",
+             allowMissing ? "missing" : "MISSING");
+      continue;
+    }
+    const Result &cur = it->second;
+    current.erase(it);
+
+    string status = "ok";
+    double ratio = base.timeNs > 0 ? cur.timeNs / base.timeNs : 1;
+    if (ratio > 1 + timeTol) {
+      status = "SLOWER";
+    } else if (ratio < 1 - timeTol) {
+      status = "faster";
+    }
+    // averages over iterations may be off by a fraction of one
+    if (base.allocs >= 0 && cur.allocs >= 0 &&
+        cur.allocs > base.allocs * (1 + allocTol) + 0.5) {
+      status = status == "SLOWER" ? "SLOWER, MORE ALLOCS" : "MORE ALLOCS";
+    }
+    if (status != "ok" && status != "faster") {
+      regressions++;
+    }
+    printf("%-64s %12.0f %12.0f %+7.1f%% %10.0f %10.0f  %s\n", name.c_str(),
+           base.timeNs, cur.timeNs, (ratio - 1) * 100, base.allocs, cur.allocs,
+           status.c_str());
+  }
+  for (auto &pair : results) {
+    if (current.count(pair.first)) {
+      printf("%-64s %12s %12.0f %8s %10s %10.0f  new\n", pair.first.c_str(),
+             "-", pair.second.timeNs, "-", "-", pair.second.allocs);
+    }
+  }
+
+  if (regressions) {
+    printf("\n%d regression%s against %s\n", regressions,
+           regressions > 1 ? "s" : "", files[0].c_str());
+    return EXIT_FAILURE;
+  }
+  printf("\nno regressions against %s\n", files[0].c_str());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "image.h"
+#include "rasterizer.h"
+#include "svgpainter.h"
+#include "threadpool.h"
+#include "tilerenderer.h"
+
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace rectangle::util;
+
+static const int kSize = 2048;
+
+// a poster sized scene of overlapping translucent shapes
+static const SvgPainter &scene() {
+  static SvgPainter painter;
+  static bool ready = false;
+  if (ready) {
+    return painter;
+  }
+  unsigned seed = 1;
+  auto next = [&seed](int n) {
+    seed = seed * 1103515245u + 12345u;
+    return static_cast<int>((seed >> 8) % static_cast<unsigned>(n));
+  };
+  for (int i = 0; i < 20000; i++) {
+    RectangleData r;
+    r.x = next(kSize);
+    r.y = next(kSize);
+    r.width = 4 + next(60);
+    r.height = 4 + next(60);
+    r.fill_color = i % 2 ? "rgba(0,128,255,0.5)" : "#a0a0a0";
+    r.stroke_width = 1;
+    r.stroke_color = "black";
+    r.stroke_dasharray = "";
+    painter.draw(r);
+
+    EllipseData e;
+    e.x = next(kSize);
+    e.y = next(kSize);
+    e.x_radius = 2 + next(30);
+    e.y_radius = 2 + next(30);
+    e.fill_color = "yellow";
+    e.stroke_width = 2;
+    e.stroke_color = "red";
+    e.stroke_dasharray = "";
+    painter.draw(e);
+
+    PolylineData p;
+    p.x = next(kSize);
+    p.y = next(kSize);
+    for (int k = 0; k < 8; k++) {
+      p.points.push_back(next(80));
+      p.points.push_back(next(80));
+    }
+    p.stroke_width = 1 + next(3);
+    p.stroke_color = "green";
+    p.stroke_dasharray = "";
+    painter.draw(p);
+  }
+  ready = true;
+  return painter;
+}
+
+static void BM_Rasterizer(benchmark::State &state) {
+  const DisplayList &list = scene().displayList();
+  for (auto _ : state) {
+    Image image(kSize, kSize);
+    Rasterizer(image).draw(list);
+    benchmark::DoNotOptimize(image.row(0));
+  }
+}
+BENCHMARK(BM_Rasterizer)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// argument is the thread count
+static void BM_TileRenderer(benchmark::State &state) {
+  const DisplayList &list = scene().displayList();
+  ThreadPool pool(static_cast<int>(state.range(0)));
+  TileRenderer renderer;
+  for (auto _ : state) {
+    Image image(kSize, kSize);
+    renderer.render(list, image, pool);
+    benchmark::DoNotOptimize(image.row(0));
+  }
+  state.counters["stolen"] = pool.stolenCount();
+}
+BENCHMARK(BM_TileRenderer)
+    ->DenseRange(1, ThreadPool::defaultThreadCount())
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// argument is the count of opaque rectangles spanning most of the scene,
+// none covering another, the time should grow linearly with it
+static void BM_CullOccludedLarge(benchmark::State &state) {
+  int count = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    SvgPainter painter;
+    for (int i = 0; i < count; i++) {
+      RectangleData r;
+      r.x = i;
+      r.y = i;
+      r.width = count;
+      r.height = count;
+      r.fill_color = "#a0a0a0";
+      r.stroke_width = 1;
+      r.stroke_color = "black";
+      r.stroke_dasharray = "";
+      painter.draw(r);
+    }
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(painter.cullOccluded());
+  }
+  state.SetComplexityN(count);
+}
+BENCHMARK(BM_CullOccludedLarge)
+    ->Arg(1000)
+    ->Arg(4000)
+    ->Arg(16000)
+    ->Arg(64000)
+    ->Complexity()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,264 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asmbin.h"
+#include "asmmachine.h"
+#include "asmvisitor.h"
+#include "ast.h"
+#include "lexer.h"
+#include "option.h"
+#include "outputsink.h"
+#include "parser.h"
+#include "phasetimer.h"
+#include "scenegenerator.h"
+#include "sourcefile.h"
+#include "symbolvisitor.h"
+
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::backend;
+using namespace rectangle::bench;
+using namespace rectangle::frontend;
+using namespace rectangle::runtime;
+using namespace rectangle::util;
+
+struct Source {
+  string path;
+  string code;
+};
+
+// the components of template/ and a generated instance document
+static vector<Source> sources(const SceneParams &p) {
+  static const char *const templates[] = {
+      "Scene", "Rectangle", "Text", "Ellipse", "Polygon", "Line", "Polyline"};
+  vector<Source> result;
+  for (auto name : templates) {
+    string path = string(RECT_TEMPLATE_DIR "/") + name + ".rect";
+    result.push_back({path, SourceFile(path).source()});
+  }
+  result.push_back({"scene.rect", generateScene(p)});
+  return result;
+}
+
+static SceneParams params(const benchmark::State &state) {
+  SceneParams p;
+  p.instances = static_cast<int>(state.range(0));
+  p.depth = static_cast<int>(state.range(1));
+  p.chain = static_cast<int>(state.range(2));
+  p.vertices = static_cast<int>(state.range(3));
+  return p;
+}
+
+static vector<vector<Token>> scan(const vector<Source> &srcs) {
+  vector<vector<Token>> result;
+  for (auto &src : srcs) {
+    result.push_back(Lexer().scan(src.code));
+  }
+  return result;
+}
+
+static unique_ptr<AST> parse(const vector<Source> &srcs,
+                             const vector<vector<Token>> &tokens) {
+  unique_ptr<AST> ast(new AST);
+  for (size_t i = 0; i < srcs.size(); i++) {
+    unique_ptr<DocumentDecl> document = Parser().parse(tokens[i]);
+    document->filepath = srcs[i].path;
+    ast->addDocument(move(document));
+  }
+  return ast;
+}
+
+// the ast after the symbol pass, ready for AsmVisitor
+static unique_ptr<AST> analyze(const vector<Source> &srcs) {
+  unique_ptr<AST> ast = parse(srcs, scan(srcs));
+  SymbolVisitor().visit(ast.get());
+  return ast;
+}
+
+static uint64_t allocations() { return allocStats().count; }
+
+// allocs is the count of allocations made by all iterations
+static void setCounters(benchmark::State &state, const SceneParams &p,
+                        uint64_t allocs) {
+  state.counters["instances"] = sceneInstanceCount(p);
+  state.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+}
+
+static void BM_Lexer(benchmark::State &state) {
+  SceneParams p = params(state);
+  vector<Source> srcs = sources(p);
+  int64_t bytes = 0;
+  for (auto &src : srcs) {
+    bytes += static_cast<int64_t>(src.code.size());
+  }
+  uint64_t start = allocations();
+  for (auto _ : state) {
+    for (auto &src : srcs) {
+      benchmark::DoNotOptimize(Lexer().scan(src.code));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+  setCounters(state, p, allocations() - start);
+}
+
+static void BM_Parser(benchmark::State &state) {
+  SceneParams p = params(state);
+  vector<Source> srcs = sources(p);
+  vector<vector<Token>> tokens = scan(srcs);
+  uint64_t start = allocations();
+  for (auto _ : state) {
+    for (auto &t : tokens) {
+      benchmark::DoNotOptimize(Parser().parse(t));
+    }
+  }
+  setCounters(state, p, allocations() - start);
+}
+
+// the symbol pass annotates the ast, so every iteration parses a new one
+static void BM_SymbolVisitor(benchmark::State &state) {
+  SceneParams p = params(state);
+  vector<Source> srcs = sources(p);
+  vector<vector<Token>> tokens = scan(srcs);
+  uint64_t allocs = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    unique_ptr<AST> ast = parse(srcs, tokens);
+    state.ResumeTiming();
+    uint64_t start = allocations();
+    SymbolVisitor().visit(ast.get());
+    allocs += allocations() - start;
+    state.PauseTiming();
+    ast.reset();
+    state.ResumeTiming();
+  }
+  setCounters(state, p, allocs);
+}
+
+static void BM_AsmVisitor(benchmark::State &state) {
+  SceneParams p = params(state);
+  unique_ptr<AST> ast = analyze(sources(p));
+  uint64_t start = allocations();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(AsmVisitor().visit(ast.get()));
+  }
+  setCounters(state, p, allocations() - start);
+}
+
+static void BM_AsmBin(benchmark::State &state) {
+  SceneParams p = params(state);
+  AsmText txt = AsmVisitor().visit(analyze(sources(p)).get());
+  uint64_t start = allocations();
+  for (auto _ : state) {
+    AsmBin bin(txt);
+    benchmark::DoNotOptimize(bin.codeSize());
+  }
+  setCounters(state, p, allocations() - start);
+}
+
+static void BM_AsmMachine(benchmark::State &state) {
+  SceneParams p = params(state);
+  AsmBin bin(AsmVisitor().visit(analyze(sources(p)).get()));
+  uint64_t start = allocations();
+  for (auto _ : state) {
+    AsmMachine machine;
+    machine.execute(bin, "main");
+    benchmark::DoNotOptimize(machine.painter().displayList().items().size());
+  }
+  setCounters(state, p, allocations() - start);
+}
+
+// with --print-svg-draw every drawn struct is formatted, written to
+// /dev/null here; BM_AsmMachine shows what is left when it is off
+static void BM_AsmMachineTraced(benchmark::State &state) {
+  SceneParams p = params(state);
+  AsmBin bin(AsmVisitor().visit(analyze(sources(p)).get()));
+  fflush(stderr);
+  int savedStderr = dup(STDERR_FILENO);
+  int null = open("/dev/null", O_WRONLY);
+  dup2(null, STDERR_FILENO);
+  close(null);
+  Options options;
+  options.printSvgDraw = true;
+  uint64_t start = allocations();
+  for (auto _ : state) {
+    AsmMachine machine(options);
+    machine.execute(bin, "main");
+    benchmark::DoNotOptimize(machine.painter().displayList().items().size());
+  }
+  setCounters(state, p, allocations() - start);
+  fflush(stderr);
+  dup2(savedStderr, STDERR_FILENO);
+  close(savedStderr);
+}
+
+static void BM_SvgPainter(benchmark::State &state) {
+  SceneParams p = params(state);
+  AsmBin bin(AsmVisitor().visit(analyze(sources(p)).get()));
+  AsmMachine machine;
+  machine.execute(bin, "main");
+  int64_t bytes = 0;
+  uint64_t start = allocations();
+  for (auto _ : state) {
+    string svg;
+    {
+      StringSink sink(svg);
+      machine.painter().generate(sink);
+    }
+    bytes += static_cast<int64_t>(svg.size());
+  }
+  state.SetBytesProcessed(bytes);
+  setCounters(state, p, allocations() - start);
+}
+
+// instances, depth, chain, vertices: a baseline and each parameter scaled
+static void sceneArgs(benchmark::internal::Benchmark *b) {
+  b->ArgNames({"instances", "depth", "chain", "vertices"});
+  b->Args({100, 1, 0, 4});
+  b->Args({1000, 1, 0, 4});
+  b->Args({100, 16, 0, 4});
+  b->Args({100, 1, 16, 4});
+  b->Args({100, 1, 0, 256});
+  b->Unit(benchmark::kMicrosecond);
+}
+
+BENCHMARK(BM_Lexer)->Apply(sceneArgs);
+BENCHMARK(BM_Parser)->Apply(sceneArgs);
+BENCHMARK(BM_SymbolVisitor)->Apply(sceneArgs);
+BENCHMARK(BM_AsmVisitor)->Apply(sceneArgs);
+BENCHMARK(BM_AsmBin)->Apply(sceneArgs);
+BENCHMARK(BM_AsmMachine)->Apply(sceneArgs);
+// the draw heavy scenes only
+BENCHMARK(BM_AsmMachineTraced)
+    ->ArgNames({"instances", "depth", "chain", "vertices"})
+    ->Args({1000, 1, 0, 4})
+    ->Args({100, 1, 0, 256})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SvgPainter)->Apply(sceneArgs);
+
+BENCHMARK_MAIN();
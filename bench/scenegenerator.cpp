@@ -0,0 +1,110 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "scenegenerator.h"
+
+#include <math.h>
+
+using namespace std;
+
+namespace rectangle {
+namespace bench {
+
+static void indent(string &s, int level) { s.append(4 * level, ' '); }
+
+static void appendPolygon(string &s, int level, int vertices) {
+  indent(s, level);
+  s += "Polygon {\n";
+  indent(s, level + 1);
+  s += "fill_color: \"#808080\"\n";
+  indent(s, level + 1);
+  s += "points: {";
+  for (int i = 0; i < vertices; i++) {
+    double a = 2 * M_PI * i / vertices;
+    int x = static_cast<int>(lround(20 + 20 * cos(a)));
+    int y = static_cast<int>(lround(20 + 20 * sin(a)));
+    s += (i ? ", {" : "{") + to_string(x) + ", " + to_string(y) + "}";
+  }
+  s += "}\n";
+  indent(s, level);
+  s += "}\n";
+}
+
+static void appendItem(string &s, const SceneParams &p, int index) {
+  int level = 1;
+  for (int d = 1; d < p.depth; d++, level++) {
+    indent(s, level);
+    s += "Rectangle {\n";
+    indent(s, level + 1);
+    if (d == 1) {
+      s += "x: " + to_string(index % 32 * 60) + "\n";
+      indent(s, level + 1);
+      s += "y: " + to_string(index / 32 * 60) + "\n";
+    } else {
+      s += "x: 1\n";
+    }
+    indent(s, level + 1);
+    s += "width: 50\n";
+    indent(s, level + 1);
+    s += "height: 50\n";
+  }
+  appendPolygon(s, level, p.vertices);
+  for (level--; level >= 1; level--) {
+    indent(s, level);
+    s += "}\n";
+  }
+
+  string prefix = "c" + to_string(index) + "_";
+  for (int k = 0; k < p.chain; k++) {
+    indent(s, 1);
+    s += "Rectangle {\n";
+    indent(s, 2);
+    s += "id: " + prefix + to_string(k) + "\n";
+    indent(s, 2);
+    if (k == 0) {
+      s += "x: " + to_string(index % 32 * 60) + "\n";
+    } else {
+      s += "x: " + prefix + to_string(k - 1) + ".x + 1\n";
+    }
+    indent(s, 2);
+    s += "width: 10\n";
+    indent(s, 2);
+    s += "height: 10\n";
+    indent(s, 1);
+    s += "}\n";
+  }
+}
+
+string generateScene(const SceneParams &p) {
+  string s = "Scene {\n";
+  indent(s, 1);
+  s += "width: 1920\n";
+  indent(s, 1);
+  s += "height: " + to_string((p.instances + 31) / 32 * 60) + "\n";
+  for (int i = 0; i < p.instances; i++) {
+    appendItem(s, p, i);
+  }
+  s += "}\n";
+  return s;
+}
+
+int sceneInstanceCount(const SceneParams &p) {
+  return 1 + p.instances * (p.depth + p.chain);
+}
+
+}  // namespace bench
+}  // namespace rectangle
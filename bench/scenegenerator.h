@@ -0,0 +1,43 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#pragma once
+
+#include <string>
+
+namespace rectangle {
+namespace bench {
+
+struct SceneParams {
+  // top level instances in the scene
+  int instances = 100;
+  // every top level instance is a nest of depth instances
+  int depth = 1;
+  // each top level instance also has chain rectangles, each bound to the
+  // previous one
+  int chain = 0;
+  // of the polygon drawn in the innermost instance
+  int vertices = 4;
+};
+
+// instance document of a scene using the components of template/
+std::string generateScene(const SceneParams &p);
+// instances in the scene generated from p, the scene included
+int sceneInstanceCount(const SceneParams &p);
+
+}  // namespace bench
+}  // namespace rectangle
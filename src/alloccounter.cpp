@@ -0,0 +1,80 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+// Counting replacements of the global allocation functions. Only programs
+// link this file, never librectangle, since an embedding host may bring its
+// own operator new.
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+#include "phasetimer.h"
+
+using namespace std;
+
+namespace {
+
+std::atomic<uint64_t> g_allocCount(0);
+std::atomic<uint64_t> g_allocBytes(0);
+
+void *countedAlloc(size_t size) {
+  g_allocCount.fetch_add(1, memory_order_relaxed);
+  g_allocBytes.fetch_add(size, memory_order_relaxed);
+  return malloc(size > 0 ? size : 1);
+}
+
+rectangle::util::AllocStats countedStats() {
+  return rectangle::util::AllocStats{g_allocCount.load(memory_order_relaxed),
+                                     g_allocBytes.load(memory_order_relaxed)};
+}
+
+const bool g_hookInstalled =
+    (rectangle::util::setAllocStatsHook(countedStats), true);
+
+}  // namespace
+
+void *operator new(size_t size) {
+  void *p = countedAlloc(size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete[](void *p) noexcept { free(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept { free(p); }
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
+
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+void operator delete[](void *p, size_t) noexcept { free(p); }
@@ -44,6 +44,11 @@ void ArgsParser::dumpOpt() const {
     bool *p = pair.second;
     fprintf(stderr, "    --%-20s: %s\n", opt.c_str(), *p ? "true" : "false");
   }
+  for (auto &pair : m_valueLongOpt) {
+    const string &opt = pair.first;
+    string *p = pair.second;
+    fprintf(stderr, "    --%-20s: %s\n", opt.c_str(), p->c_str());
+  }
 }
 
 void ArgsParser::addOnOffLongOption(const std::string &opt,
@@ -52,6 +57,13 @@ void ArgsParser::addOnOffLongOption(const std::string &opt,
   m_onOffLongOpt[opt] = &onoff;
 }
 
+void ArgsParser::addValueLongOption(const std::string &opt,
+                                    const std::string &msg,
+                                    std::string &value) {
+  m_opt2msg[opt] = msg;
+  m_valueLongOpt[opt] = &value;
+}
+
 static bool isLongOpt(const std::string &opt) {
   return opt[0] == '-' && opt[1] == '-';
 }
@@ -82,9 +94,25 @@ std::vector<string> ArgsParser::parse(int argc, char **argv) {
     string s(argv[i]);
     if (isLongOpt(s)) {
       string opt = longOpt(s);
+      string value;
+      bool hasValue = false;
+      size_t pos = opt.find('=');
+      if (pos != string::npos) {
+        value = opt.substr(pos + 1);
+        opt = opt.substr(0, pos);
+        hasValue = true;
+      }
       if (m_opt2msg.count(opt) == 0) {
         throw ArgsException("Unknown option: " + s);
+      } else if (m_valueLongOpt.count(opt) != 0) {
+        if (!hasValue) {
+          throw ArgsException("Option requires a value: " + s);
+        }
+        *(m_valueLongOpt[opt]) = value;
       } else {
+        if (hasValue) {
+          throw ArgsException("Option takes no value: " + s);
+        }
         *(m_onOffLongOpt[opt]) = true;
       }
     } else if (isShortOpt(s)) {
@@ -101,6 +129,9 @@ void ArgsParser::initDefaultValue() {
   for (auto &pair : m_onOffLongOpt) {
     *(pair.second) = false;
   }
+  for (auto &pair : m_valueLongOpt) {
+    pair.second->clear();
+  }
 }
 
 }  // namespace util
@@ -39,6 +39,9 @@ class ArgsParser {
 
   void addOnOffLongOption(const std::string &opt, const std::string &msg,
                           bool &onoff);
+  // --opt=value
+  void addValueLongOption(const std::string &opt, const std::string &msg,
+                          std::string &value);
   std::vector<std::string> parse(int argc, char **argv);
 
  private:
@@ -47,6 +50,7 @@ class ArgsParser {
  private:
   std::map<std::string, std::string> m_opt2msg;
   std::map<std::string, bool *> m_onOffLongOpt;
+  std::map<std::string, std::string *> m_valueLongOpt;
 };
 
 }  // namespace util
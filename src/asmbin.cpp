@@ -17,11 +17,11 @@
 
 #include "asmbin.h"
 
+#include <algorithm>
 #include <map>
 #include <set>
 
 #include "asminstruction.h"
-#include "option.h"
 #include "util.h"
 
 using namespace std;
@@ -31,7 +31,10 @@ using namespace rectangle::runtime;
 namespace rectangle {
 namespace backend {
 
-AsmBin::AsmBin(const AsmText &t) { assemble(t); }
+AsmBin::AsmBin(const AsmText &t, const Options &options)
+    : m_printAssemble(options.printAssemble) {
+  assemble(t);
+}
 
 AsmBin::~AsmBin() {}
 
@@ -49,6 +52,33 @@ void AsmBin::assemble(const AsmText &t) {
       int args = atoi(line[2].c_str());
       int locals = atoi(line[3].c_str());
       defineFunction(funcName, m_offset, args, locals);
+      m_nextLocation = SourceLocation();
+    } else if (firstWord == ".loc") {
+      assert(line.size() == 4);
+      auto it = find(m_sourceFiles.begin(), m_sourceFiles.end(), line[1]);
+      int file = static_cast<int>(it - m_sourceFiles.begin());
+      if (it == m_sourceFiles.end()) {
+        m_sourceFiles.push_back(line[1]);
+      }
+      m_nextLocation = SourceLocation(-1, file, atoi(line[2].c_str()),
+                                      atoi(line[3].c_str()));
+    } else if (firstWord == ".binding") {
+      assert(line.size() >= 4);
+      m_bindings.emplace_back(atoi(line[1].c_str()), atoi(line[2].c_str()),
+                              line[3], m_offset);
+      for (size_t i = 4; i < line.size(); i++) {
+        m_bindings.back().deps.push_back(atoi(line[i].c_str()));
+      }
+    } else if (firstWord == ".endbinding") {
+      assert(m_bindings.size() > 0);
+      m_bindings.back().endAddr = m_offset;
+    } else if (firstWord == ".instance") {
+      assert(line.size() == 4);
+      m_instances.emplace_back(atoi(line[1].c_str()), atoi(line[2].c_str()),
+                               line[3], m_offset);
+    } else if (firstWord == ".endinstance") {
+      assert(m_instances.size() > 0);
+      m_instances.back().endAddr = m_offset;
     } else if (firstWord[0] == '.' && firstWord[1] == 'L') {
       assert(line.size() == 1);
       defineLabel(firstWord, m_offset);
@@ -110,10 +140,45 @@ void AsmBin::dump() {
            f.name.c_str(), f.args, f.locals);
   }
 
+  printf("Bindings:\n");
+  for (size_t i = 0; i < m_bindings.size(); i++) {
+    BindingItem &b = m_bindings[i];
+    string deps;
+    for (int dep : b.deps) {
+      deps += " " + to_string(dep);
+    }
+    printf("    %04x: %08x %08x [%d].%s(%d)%s\n", static_cast<unsigned>(i),
+           b.addr, b.endAddr, b.instance, b.name.c_str(), b.field,
+           deps.c_str());
+  }
+
+  printf("Instances:\n");
+  for (size_t i = 0; i < m_instances.size(); i++) {
+    InstanceItem &item = m_instances[i];
+    printf("    %04x: %08x %08x %s %d\n", static_cast<unsigned>(i), item.addr,
+           item.endAddr, item.id.c_str(), item.parent);
+  }
+
+  printf("Sources:\n");
+  for (size_t i = 0; i < m_sourceFiles.size(); i++) {
+    printf("    %04x: %s\n", static_cast<unsigned>(i),
+           m_sourceFiles[i].c_str());
+  }
+
   printf("Code:\n");
+  vector<SourceLocation> lines = lineTable();
+  size_t nextLine = 0;
   int offset = 0;
   while (offset < static_cast<int>(m_code.size())) {
     unsigned char instr = m_code[static_cast<size_t>(offset)];
+    if (nextLine < lines.size() && lines[nextLine].addr == offset) {
+      const SourceLocation &l = lines[nextLine++];
+      if (l.isValid()) {
+        printf("                         ; %s:%d:%d\n",
+               m_sourceFiles[static_cast<size_t>(l.file)].c_str(), l.line,
+               l.column);
+      }
+    }
 
     if (instr::is0OpInstr(instr)) {
       unsigned addr = static_cast<unsigned>(offset);
@@ -137,16 +202,15 @@ void AsmBin::dump() {
 int AsmBin::codeSize() const { return static_cast<int>(m_code.size()); }
 
 int AsmBin::defineFloat(float f) {
-  util::condPrint(option::printAssemble, "assemble: def float %lf\n",
-                  static_cast<double>(f));
+  COND_PRINT(m_printAssemble, "assemble: def float %lf\n",
+             static_cast<double>(f));
 
   m_constants.emplace_back(f);
   return static_cast<int>(m_constants.size() - 1);
 }
 
 int AsmBin::defineString(const std::string &s) {
-  util::condPrint(option::printAssemble, "assemble: def string %s\n",
-                  s.c_str());
+  COND_PRINT(m_printAssemble, "assemble: def string %s\n", s.c_str());
 
   for (size_t i = 0; i < m_constants.size(); i++) {
     Object &o = m_constants[i];
@@ -198,12 +262,12 @@ int AsmBin::defineFunction(const std::string &name, int addr, int args,
     printName += "(defined)";
   }
   if (isRef) {
-    util::condPrint(option::printAssemble, "assemble: ref [%u] function %s\n",
-                    index, printName.c_str());
+    COND_PRINT(m_printAssemble, "assemble: ref [%u] function %s\n", index,
+               printName.c_str());
   } else {
-    util::condPrint(option::printAssemble,
-                    "assemble: def [%u] function %s %d %d %d\n", index,
-                    printName.c_str(), addr, args, locals);
+    COND_PRINT(m_printAssemble,
+               "assemble: def [%u] function %s %d %d %d\n", index,
+               printName.c_str(), addr, args, locals);
   }
 
   return static_cast<int>(index);
@@ -246,11 +310,11 @@ int AsmBin::defineLabel(const string &name, int addr) {
     printName += "(new)";
   }
   if (isRef) {
-    util::condPrint(option::printAssemble, "assemble: ref [%u] label %s\n",
-                    index, printName.c_str());
+    COND_PRINT(m_printAssemble, "assemble: ref [%u] label %s\n", index,
+               printName.c_str());
   } else {
-    util::condPrint(option::printAssemble, "assemble: def [%u] label %s %d\n",
-                    index, printName.c_str(), addr);
+    COND_PRINT(m_printAssemble, "assemble: def [%u] label %s %d\n", index,
+               printName.c_str(), addr);
   }
 
   return static_cast<int>(index);
@@ -258,6 +322,7 @@ int AsmBin::defineLabel(const string &name, int addr) {
 
 void AsmBin::appendByte(unsigned char c) {
   assert(c != instr::INVALID);
+  appendLocation();
   m_code.push_back(c);
   m_offset += 1;
 }
@@ -275,6 +340,61 @@ unsigned char AsmBin::getByte(int addr) const {
   return m_code[static_cast<size_t>(addr)];
 }
 
+static void appendVarint(vector<unsigned char> &v, unsigned n) {
+  while (n >= 0x80) {
+    v.push_back(static_cast<unsigned char>(n | 0x80));
+    n >>= 7;
+  }
+  v.push_back(static_cast<unsigned char>(n));
+}
+
+static unsigned readVarint(const vector<unsigned char> &v, size_t &pos) {
+  unsigned n = 0;
+  int shift = 0;
+  while (pos < v.size()) {
+    unsigned char c = v[pos++];
+    n |= static_cast<unsigned>(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      break;
+    }
+    shift += 7;
+  }
+  return n;
+}
+
+static unsigned zigzag(int n) {
+  return (static_cast<unsigned>(n) << 1) ^ static_cast<unsigned>(n >> 31);
+}
+
+static int unzigzag(unsigned n) {
+  return static_cast<int>(n >> 1) ^ -static_cast<int>(n & 1);
+}
+
+// A row is the address delta, the line delta shifted left by one with the
+// low bit set when the file changes, then the file + 1 if it does, then
+// the column delta. Deltas of line and column are zigzag encoded.
+void AsmBin::appendLocation() {
+  const SourceLocation &next = m_nextLocation;
+  SourceLocation &last = m_lastLocation;
+  if (next.file == last.file &&
+      (next.file == -1 ||
+       (next.line == last.line && next.column == last.column))) {
+    return;
+  }
+
+  bool fileChanged = next.file != last.file;
+  appendVarint(m_lineTable, static_cast<unsigned>(m_offset - last.addr));
+  appendVarint(m_lineTable,
+               zigzag(next.line - last.line) << 1 | (fileChanged ? 1 : 0));
+  if (fileChanged) {
+    appendVarint(m_lineTable, static_cast<unsigned>(next.file + 1));
+  }
+  appendVarint(m_lineTable, zigzag(next.column - last.column));
+
+  last = next;
+  last.addr = m_offset;
+}
+
 void AsmBin::setInt(int addr, int n) {
   assert(addr >= 0 && addr < static_cast<int>(m_code.size()));
   for (int i = 0; i < 4; i++) {
@@ -320,5 +440,43 @@ AsmBin::FunctionItem AsmBin::getFunction(const string &funcName) const {
   return FunctionItem("(invalid)");
 }
 
+const vector<AsmBin::BindingItem> &AsmBin::bindings() const {
+  return m_bindings;
+}
+
+const vector<AsmBin::InstanceItem> &AsmBin::instances() const {
+  return m_instances;
+}
+
+const vector<string> &AsmBin::sourceFiles() const { return m_sourceFiles; }
+
+vector<AsmBin::SourceLocation> AsmBin::lineTable() const {
+  vector<SourceLocation> result;
+  SourceLocation cur(0, -1, 0, 0);
+  size_t pos = 0;
+  while (pos < m_lineTable.size()) {
+    cur.addr += static_cast<int>(readVarint(m_lineTable, pos));
+    unsigned line = readVarint(m_lineTable, pos);
+    if (line & 1) {
+      cur.file = static_cast<int>(readVarint(m_lineTable, pos)) - 1;
+    }
+    cur.line += unzigzag(line >> 1);
+    cur.column += unzigzag(readVarint(m_lineTable, pos));
+    result.push_back(cur);
+  }
+  return result;
+}
+
+AsmBin::SourceLocation AsmBin::location(int addr) const {
+  SourceLocation result;
+  for (auto &row : lineTable()) {
+    if (row.addr > addr) {
+      break;
+    }
+    result = row;
+  }
+  return result;
+}
+
 }  // namespace backend
 }  // namespace rectangle
@@ -19,6 +19,7 @@
 
 #include "asmtext.h"
 #include "object.h"
+#include "option.h"
 
 #pragma once
 
@@ -41,8 +42,46 @@ class AsmBin {
     int index;
   };
 
+  // code evaluating one property of one instance in main, see .binding
+  struct BindingItem {
+    BindingItem(int instance_ = -1, int field_ = -1,
+                const std::string &name_ = "", int addr_ = -1)
+        : instance(instance_), field(field_), name(name_), addr(addr_) {}
+    int instance;
+    int field;
+    std::string name;
+    int addr;
+    int endAddr = -1;
+    std::vector<int> deps;
+  };
+
+  // code calling draw() of one instance in main, see .instance
+  struct InstanceItem {
+    InstanceItem(int index_ = -1, int parent_ = -1, const std::string &id_ = "",
+                 int addr_ = -1)
+        : index(index_), parent(parent_), id(id_), addr(addr_) {}
+    int index;
+    int parent;
+    std::string id;
+    int addr;
+    int endAddr = -1;
+  };
+
+  // the .rect source of the code from addr on, see .loc
+  struct SourceLocation {
+    SourceLocation(int addr_ = -1, int file_ = -1, int line_ = -1,
+                   int column_ = -1)
+        : addr(addr_), file(file_), line(line_), column(column_) {}
+    bool isValid() const { return file != -1; }
+    int addr;
+    // index in sourceFiles()
+    int file;
+    int line;
+    int column;
+  };
+
  public:
-  explicit AsmBin(const AsmText &t);
+  explicit AsmBin(const AsmText &t, const Options &options = Options());
   ~AsmBin();
 
   void assemble(const AsmText &t);
@@ -56,6 +95,12 @@ class AsmBin {
   runtime::Object getConstant(int index) const;
   FunctionItem getFunction(int index) const;
   FunctionItem getFunction(const std::string &funcName) const;
+  const std::vector<BindingItem> &bindings() const;
+  const std::vector<InstanceItem> &instances() const;
+  const std::vector<std::string> &sourceFiles() const;
+  // decoded line table, one row where the location changes
+  std::vector<SourceLocation> lineTable() const;
+  SourceLocation location(int addr) const;
 
  private:
   int defineFloat(float f);
@@ -66,6 +111,7 @@ class AsmBin {
 
   void appendByte(unsigned char c);
   void appendInt(int n);
+  void appendLocation();
 
   void setInt(int addr, int n);
 
@@ -79,11 +125,19 @@ class AsmBin {
     int addr;
   };
 
+  bool m_printAssemble = false;
   int m_offset = 0;
   std::vector<unsigned char> m_code;
   std::vector<runtime::Object> m_constants;
   std::vector<FunctionItem> m_functions;
   std::vector<LabelItem> m_labels;
+  std::vector<BindingItem> m_bindings;
+  std::vector<InstanceItem> m_instances;
+  std::vector<std::string> m_sourceFiles;
+  // rows of address, line and column deltas, see appendLocation
+  std::vector<unsigned char> m_lineTable;
+  SourceLocation m_lastLocation = SourceLocation(0, -1, 0, 0);
+  SourceLocation m_nextLocation;
 
   std::vector<int> m_labelIndexAddr;
 };
@@ -18,7 +18,6 @@
 #include "asmmachine.h"
 
 #include "builtinstruct.h"
-#include "option.h"
 #include "util.h"
 
 using namespace std;
@@ -28,7 +27,10 @@ using namespace rectangle::backend;
 namespace rectangle {
 namespace runtime {
 
-AsmMachine::AsmMachine() : m_asm(AsmText()) {}
+AsmMachine::AsmMachine(const Options &options)
+    : m_asm(AsmText()),
+      m_printSvgDraw(options.printSvgDraw),
+      m_printStream(options.printToStderr ? stderr : stdout) {}
 
 string AsmMachine::run(const AsmBin &bin, const std::string &funcName) {
   AsmBin::FunctionItem func = bin.getFunction(funcName);
@@ -43,6 +45,23 @@ string AsmMachine::run(const AsmBin &bin, const std::string &funcName) {
   return m_painter.generate();
 }
 
+void AsmMachine::run(const AsmBin &bin, const std::string &funcName,
+                     util::OutputSink &sink) {
+  execute(bin, funcName);
+  m_painter.generate(sink);
+}
+
+void AsmMachine::execute(const AsmBin &bin, const std::string &funcName) {
+  AsmBin::FunctionItem func = bin.getFunction(funcName);
+  assert(func.isValid());
+
+  m_asm = bin;
+  reset();
+
+  interpret(instr::CALL, func.index);
+  mainLoop();
+}
+
 string AsmMachine::run(const AsmBin &bin, const int addr) {
   assert(addr >= 0 && addr < bin.codeSize());
 
@@ -55,6 +74,41 @@ string AsmMachine::run(const AsmBin &bin, const int addr) {
   return m_painter.generate();
 }
 
+void AsmMachine::enter(const AsmBin &bin, const std::string &funcName) {
+  AsmBin::FunctionItem func = bin.getFunction(funcName);
+  assert(func.isValid());
+
+  m_asm = bin;
+  reset();
+
+  m_frames.emplace_back(func, -1);
+  m_ip = func.addr;
+}
+
+void AsmMachine::runRange(int begin, int end) {
+  assert(m_frames.size() > 0);
+  assert(begin >= 0 && begin <= end && end <= m_asm.codeSize());
+
+  size_t depth = m_frames.size();
+  m_ip = begin;
+  while (!m_halt && !(m_ip == end && m_frames.size() == depth)) {
+    step();
+  }
+}
+
+Object &AsmMachine::local(int index) {
+  assert(m_frames.size() > 0);
+  assert(index >= 0 &&
+         index < static_cast<int>(m_frames.front().locals.size()));
+  return m_frames.front().locals[static_cast<size_t>(index)];
+}
+
+draw::SvgPainter &AsmMachine::painter() { return m_painter; }
+
+void AsmMachine::setTraceWriter(util::TraceWriter *trace) { m_trace = trace; }
+
+void AsmMachine::setProfiler(VmProfiler *profiler) { m_profiler = profiler; }
+
 void AsmMachine::reset() {
   m_ip = 0;
   m_halt = false;
@@ -76,16 +130,38 @@ ObjectPointer AsmMachine::popOperand() {
 }
 
 void AsmMachine::mainLoop() {
+  // tag the shapes with the instance drawing them
+  const vector<AsmBin::InstanceItem> &instances = m_asm.instances();
+  size_t nextInstance = 0;
   while (m_ip < m_asm.codeSize() && !m_halt) {
-    unsigned char instr = m_asm.getByte(m_ip);
-    m_ip += 1;
-    int op = -1;
-    if (instr::is1OpInstr(instr)) {
-      op = m_asm.getInt(m_ip);
-      m_ip += 4;
+    if (nextInstance < instances.size() &&
+        m_ip == instances[nextInstance].addr) {
+      m_painter.setInstance(instances[nextInstance].index);
+      nextInstance++;
     }
+    step();
+  }
+  m_painter.setInstance(-1);
+}
+
+void AsmMachine::step() {
+  int addr = m_ip;
+  unsigned char instr = m_asm.getByte(m_ip);
+  m_ip += 1;
+  int op = -1;
+  if (instr::is1OpInstr(instr)) {
+    op = m_asm.getInt(m_ip);
+    m_ip += 4;
+  }
+  if (!m_profiler) {
     interpret(static_cast<instr::AsmInstruction>(instr), op);
+    return;
   }
+  int func = m_frames.empty() ? -1 : m_frames.back().func.index;
+  uint64_t start = VmProfiler::now();
+  interpret(static_cast<instr::AsmInstruction>(instr), op);
+  m_profiler->instruction(instr, addr, func, VmProfiler::now() - start,
+                          m_operands.size(), m_frames.size());
 }
 
 void AsmMachine::interpret(instr::AsmInstruction instr, int op) {
@@ -295,11 +371,28 @@ void AsmMachine::interpret(instr::AsmInstruction instr, int op) {
       for (int i = func.args - 1; i >= 0; i--) {
         frame.locals[static_cast<size_t>(i)] = popOperand();
       }
+      if (m_trace) {
+        frame.traceStart = m_trace->now();
+      }
+      if (m_profiler) {
+        m_profiler->call(func);
+        frame.profileStart = VmProfiler::now();
+      }
       m_frames.push_back(frame);
       m_ip = func.addr;
       break;
     }
     case instr::RET: {
+      if (m_trace) {
+        const StackFrame &frame = m_frames.back();
+        m_trace->complete(frame.func.name, "vm", frame.traceStart,
+                          m_trace->now() - frame.traceStart);
+      }
+      if (m_profiler) {
+        const StackFrame &frame = m_frames.back();
+        m_profiler->ret(frame.func.index,
+                        VmProfiler::now() - frame.profileStart);
+      }
       m_ip = m_frames.back().returnAddr;
       m_frames.pop_back();
       if (m_frames.size() == 0) {
@@ -322,7 +415,7 @@ void AsmMachine::interpret(instr::AsmInstruction instr, int op) {
     }
     case instr::PRINT: {
       Object o = popOperand();
-      printf("> %s\n", o.toString().c_str());
+      fprintf(m_printStream, "> %s\n", o.toString().c_str());
       break;
     }
     case instr::HALT: {
@@ -333,61 +426,57 @@ void AsmMachine::interpret(instr::AsmInstruction instr, int op) {
       Object y = popOperand();
       Object x = popOperand();
       pushOrigin(x.intData(), y.intData());
-      util::condPrint(option::printSvgDraw, "svg: pushOrigin (%d, %d)\n",
-                      x.intData(), y.intData());
+      COND_PRINT(m_printSvgDraw, "svg: pushOrigin (%d, %d)\n",
+                 x.intData(), y.intData());
       break;
     }
     case instr::POPORIGIN: {
       popOrigin();
-      util::condPrint(option::printSvgDraw, "svg: popOrigin\n");
+      COND_PRINT(m_printSvgDraw, "svg: popOrigin\n");
       break;
     }
     case instr::DEFINESCENE: {
       Object o = popOperand();
-      util::condPrint(option::printSvgDraw, "svg: defineScene %s\n",
-                      o.toString().c_str());
+      COND_PRINT(m_printSvgDraw, "svg: defineScene %s\n", o.toString().c_str());
       defineScene(o);
       break;
     }
     case instr::DRAWRECT: {
       Object o = popOperand();
-      util::condPrint(option::printSvgDraw, "svg: drawRect %s\n",
-                      o.toString().c_str());
+      COND_PRINT(m_printSvgDraw, "svg: drawRect %s\n", o.toString().c_str());
       drawRect(o);
       break;
     }
     case instr::DRAWTEXT: {
       Object o = popOperand();
-      util::condPrint(option::printSvgDraw, "svg: drawText %s\n",
-                      o.toString().c_str());
+      COND_PRINT(m_printSvgDraw, "svg: drawText %s\n", o.toString().c_str());
       drawText(o);
       break;
     }
     case instr::DRAWELLIPSE: {
       Object o = popOperand();
-      util::condPrint(option::printSvgDraw, "svg: drawEllipse %s\n",
-                      o.toString().c_str());
+      COND_PRINT(m_printSvgDraw, "svg: drawEllipse %s\n", o.toString().c_str());
       drawEllipse(o);
       break;
     }
     case instr::DRAWPOLYGON: {
-      Object o = popOperand();
-      util::condPrint(option::printSvgDraw, "svg: drawPolygon %s\n",
-                      o.toString().c_str());
+      ObjectPointer p = popOperand();
+      const Object &o = *p.get();
+      COND_PRINT(m_printSvgDraw, "svg: drawPolygon %s\n", o.toString().c_str());
       drawPolygon(o);
       break;
     }
     case instr::DRAWLINE: {
       Object o = popOperand();
-      util::condPrint(option::printSvgDraw, "svg: drawLine %s\n",
-                      o.toString().c_str());
+      COND_PRINT(m_printSvgDraw, "svg: drawLine %s\n", o.toString().c_str());
       drawLine(o);
       break;
     }
     case instr::DRAWPOLYLINE: {
-      Object o = popOperand();
-      util::condPrint(option::printSvgDraw, "svg: drawPolyline %s\n",
-                      o.toString().c_str());
+      ObjectPointer p = popOperand();
+      const Object &o = *p.get();
+      COND_PRINT(m_printSvgDraw, "svg: drawPolyline %s\n",
+                 o.toString().c_str());
       drawPolyline(o);
       break;
     }
@@ -454,20 +543,22 @@ void AsmMachine::drawEllipse(const Object &o) {
   m_painter.draw(d);
 }
 
+static void flattenPoints(const Object &points, vector<int32_t> &out) {
+  int pointCount = points.elementCount();
+  out.resize(2 * static_cast<size_t>(pointCount));
+  int32_t *p = out.data();
+  for (int i = 0; i < pointCount; i++) {
+    const Object &point = points.element(i);
+    *p++ = point.element(0).intData();
+    *p++ = point.element(1).intData();
+  }
+}
+
 void AsmMachine::drawPolygon(const Object &o) {
   draw::PolygonData d;
   d.x = o.field(builtin::polygonInfo.fieldIndex("x")).intData();
   d.y = o.field(builtin::polygonInfo.fieldIndex("y")).intData();
-  {
-    Object points = o.field(builtin::polygonInfo.fieldIndex("points"));
-    int pointCount = points.elementCount();
-    for (int i = 0; i < pointCount; i++) {
-      Object point = points.element(i);
-      int x = point.element(0).intData();
-      int y = point.element(1).intData();
-      d.points.push_back({x, y});
-    }
-  }
+  flattenPoints(o.field(builtin::polygonInfo.fieldIndex("points")), d.points);
   d.fill_color =
       o.field(builtin::polygonInfo.fieldIndex("fill_color")).stringData();
   d.fill_rule =
@@ -502,16 +593,7 @@ void AsmMachine::drawPolyline(const Object &o) {
   draw::PolylineData d;
   d.x = o.field(builtin::polylineInfo.fieldIndex("x")).intData();
   d.y = o.field(builtin::polylineInfo.fieldIndex("y")).intData();
-  {
-    Object points = o.field(builtin::polylineInfo.fieldIndex("points"));
-    int pointCount = points.elementCount();
-    for (int i = 0; i < pointCount; i++) {
-      Object point = points.element(i);
-      int x = point.element(0).intData();
-      int y = point.element(1).intData();
-      d.points.push_back({x, y});
-    }
-  }
+  flattenPoints(o.field(builtin::polylineInfo.fieldIndex("points")), d.points);
   d.stroke_width =
       o.field(builtin::polylineInfo.fieldIndex("stroke_width")).intData();
   d.stroke_color =
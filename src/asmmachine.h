@@ -17,19 +17,38 @@
 
 #pragma once
 
+#include <stdio.h>
+
 #include "asmbin.h"
 #include "asminstruction.h"
+#include "option.h"
 #include "svgpainter.h"
+#include "tracewriter.h"
+#include "vmprofiler.h"
 
 namespace rectangle {
 namespace runtime {
 
 class AsmMachine {
  public:
-  AsmMachine();
+  explicit AsmMachine(const Options &options = Options());
 
   std::string run(const backend::AsmBin &bin, const std::string &funcName);
   std::string run(const backend::AsmBin &bin, const int addr);
+  void run(const backend::AsmBin &bin, const std::string &funcName,
+           util::OutputSink &sink);
+  // run without generating, the shapes stay in painter()
+  void execute(const backend::AsmBin &bin, const std::string &funcName);
+
+  // step-wise execution in the frame of funcName, used by FrameRenderer
+  void enter(const backend::AsmBin &bin, const std::string &funcName);
+  void runRange(int begin, int end);
+  Object &local(int index);
+  draw::SvgPainter &painter();
+  // every call is written to trace as an event named by the function
+  void setTraceWriter(util::TraceWriter *trace);
+  // every instruction and call is counted in profiler, may be null
+  void setProfiler(VmProfiler *profiler);
 
  private:
   struct StackFrame {
@@ -42,6 +61,8 @@ class AsmMachine {
     backend::AsmBin::FunctionItem func;
     int returnAddr;
     std::vector<Object> locals;
+    double traceStart = 0;
+    uint64_t profileStart = 0;
   };
 
  private:
@@ -51,6 +72,7 @@ class AsmMachine {
   ObjectPointer popOperand();
 
   void mainLoop();
+  void step();
   void interpret(backend::instr::AsmInstruction instr, int op);
 
   void defineScene(const Object &o);
@@ -71,6 +93,10 @@ class AsmMachine {
 
   backend::AsmBin m_asm;
   draw::SvgPainter m_painter;
+  util::TraceWriter *m_trace = nullptr;
+  VmProfiler *m_profiler = nullptr;
+  bool m_printSvgDraw = false;
+  FILE *m_printStream = stdout;
 };
 
 }  // namespace runtime
@@ -41,6 +41,10 @@ void AsmText::setLine(int lineNumber, const std::vector<std::string> &line) {
   m_text[static_cast<size_t>(lineNumber)] = line;
 }
 
+void AsmText::append(const AsmText &other) {
+  m_text.insert(m_text.end(), other.m_text.begin(), other.m_text.end());
+}
+
 void AsmText::dump() {
   printf("---------- AsmText::dump begin ----------\n");
   for (auto &line : m_text) {
@@ -33,6 +33,7 @@ class AsmText {
   void appendLine(const std::vector<std::string> &line);
   int appendBlank();
   void setLine(int lineNumber, const std::vector<std::string> &line);
+  void append(const AsmText &other);
 
   void dump();
 
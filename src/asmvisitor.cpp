@@ -32,14 +32,54 @@ namespace backend {
 AsmVisitor::AsmVisitor() { m_visitingLvalueStack.push_back(false); }
 
 AsmText AsmVisitor::visit(AST *ast) {
-  m_ast = ast;
   m_asm.clear();
+  genAsmForDefinations(ast);
+
+  vector<DocumentDecl *> instances;
+  for (auto doc : m_ast->documents()) {
+    assert(doc != nullptr);
+    if (doc->type == DocumentDecl::Type::Instance) {
+      instances.push_back(doc);
+    }
+  }
+
+  if (instances.size() == 0) {
+    throw SyntaxError("No instance document");
+  } else if (instances.size() > 1) {
+    throw SyntaxError("Multiple instance documents");
+  }
+
+  ComponentInstanceDecl *cid =
+      dynamic_cast<ComponentInstanceDecl *>(instances[0]);
+  assert(cid != nullptr);
+  genAsmForMain(cid);
+
+  return m_asm;
+}
+
+AsmText AsmVisitor::visitDefinations(AST *ast) {
+  m_asm.clear();
+  genAsmForDefinations(ast);
+  return m_asm;
+}
+
+AsmText AsmVisitor::visitInstance(ComponentInstanceDecl *cid) {
+  m_asm.clear();
+  genAsmForMain(cid);
+  return m_asm;
+}
+
+int AsmVisitor::labelCounter() const { return m_labelCounter; }
+
+void AsmVisitor::setLabelCounter(int counter) { m_labelCounter = counter; }
+
+void AsmVisitor::genAsmForDefinations(AST *ast) {
+  m_ast = ast;
 
   auto documents = m_ast->documents();
 
   vector<DocumentDecl *> structs;
   vector<DocumentDecl *> definations;
-  vector<DocumentDecl *> instances;
 
   for (auto doc : documents) {
     assert(doc != nullptr);
@@ -51,7 +91,6 @@ AsmText AsmVisitor::visit(AST *ast) {
         definations.push_back(doc);
         break;
       case DocumentDecl::Type::Instance:
-        instances.push_back(doc);
         break;
     }
   }
@@ -64,25 +103,25 @@ AsmText AsmVisitor::visit(AST *ast) {
     m_curFilePath = doc->filepath;
     visit(doc);
   }
+}
 
-  if (instances.size() == 0) {
-    throw SyntaxError("No instance document");
-  } else if (instances.size() > 1) {
-    throw SyntaxError("Multiple instance documents");
-  }
-
-  ComponentInstanceDecl *cid =
-      dynamic_cast<ComponentInstanceDecl *>(instances[0]);
-  assert(cid != nullptr);
+void AsmVisitor::genAsmForMain(ComponentInstanceDecl *cid) {
   m_curFilePath = cid->filepath;
 
   m_asm.appendLine({".def", "main", "0", to_string(cid->instanceTreeSize)});
+  m_lastLocation.clear();
+  appendLocation(cid->token(), m_curFilePath);
   genAsmForInitInstance(cid);
   genAsmForAllMember(cid);
   visit(cid);
   m_asm.appendLine({"ret"});
+}
 
-  return m_asm;
+void AsmVisitor::visit(Stmt *s) {
+  assert(s != nullptr);
+
+  appendLocation(s->token(), m_curFilePath);
+  Visitor::visit(s);
 }
 
 void AsmVisitor::visit(IntegerLiteral *il) {
@@ -651,6 +690,8 @@ void AsmVisitor::visit(FunctionDecl *fd) {
   int locals = fd->locals;
 
   m_asm.appendLine({".def", name, to_string(args), to_string(locals)});
+  m_lastLocation.clear();
+  appendLocation(fd->token(), m_curFilePath);
 
   visit(fd->body.get());
 
@@ -699,8 +740,14 @@ void AsmVisitor::visit(ComponentInstanceDecl *cid) {
   int instanceIndex = cid->instanceIndex;
   string componentName = cid->componentName;
 
+  // .instance <instance> <parent> <id>
+  int parentIndex = cid->parent ? cid->parent->instanceIndex : -1;
+  appendLocation(cid->token(), m_curFilePath);
+  m_asm.appendLine({".instance", to_string(instanceIndex),
+                    to_string(parentIndex), cid->instanceId});
   m_asm.appendLine({"lload", to_string(instanceIndex)});
   m_asm.appendLine({"call", componentName + "::draw"});
+  m_asm.appendLine({".endinstance"});
   m_asm.appendLine({"lload", to_string(instanceIndex)});
   m_asm.appendLine({"fload", to_string(0)});  // x
   m_asm.appendLine({"lload", to_string(instanceIndex)});
@@ -727,7 +774,11 @@ void AsmVisitor::genAsmForInitInstance(ComponentInstanceDecl *cid) {
 }
 
 void AsmVisitor::genAsmForAllMember(ComponentInstanceDecl *cid) {
-  for (auto pair : cid->orderedMemberInitList) {
+  assert(cid->orderedMemberInitDeps.size() ==
+         cid->orderedMemberInitList.size());
+
+  for (size_t i = 0; i < cid->orderedMemberInitList.size(); i++) {
+    auto &pair = cid->orderedMemberInitList[i];
     ComponentInstanceDecl *instance = pair.first;
     PropertyDecl *pd = dynamic_cast<PropertyDecl *>(pair.second);
     BindingDecl *bd = dynamic_cast<BindingDecl *>(pair.second);
@@ -735,11 +786,22 @@ void AsmVisitor::genAsmForAllMember(ComponentInstanceDecl *cid) {
     if ((pd == nullptr && bd == nullptr) || (pd != nullptr && bd != nullptr)) {
       assert(false);
     }
+
+    // .binding <instance> <field> <name> <deps>...
+    vector<string> directive = {".binding", to_string(instance->instanceIndex),
+                                to_string(pd ? pd->fieldIndex
+                                             : bd->fieldIndex()),
+                                pd ? pd->name : bd->name};
+    for (int dep : cid->orderedMemberInitDeps[i]) {
+      directive.push_back(to_string(dep));
+    }
+    m_asm.appendLine(directive);
     if (pd) {
       genAsmForPropertyDecl(instance, pd);
     } else {
       genAsmForBindingDecl(instance, bd);
     }
+    m_asm.appendLine({".endbinding"});
   }
 }
 
@@ -751,6 +813,8 @@ void AsmVisitor::genAsmForPropertyDecl(ComponentInstanceDecl *cid,
   int fieldIndex = pd->fieldIndex;
   assert(fieldIndex != -1);
 
+  // the default value is written in the file of the component
+  appendLocation(pd->token(), pd->componentDefination->filepath);
   m_asm.appendLine({"lload", to_string(instanceIndex)});
   setVisitingInstance(true, cid->componentDefination, cid->instanceIndex);
   visit(pd->expr.get());
@@ -766,6 +830,7 @@ void AsmVisitor::genAsmForBindingDecl(ComponentInstanceDecl *cid,
   int fieldIndex = bd->fieldIndex();
   assert(fieldIndex != -1);
 
+  appendLocation(bd->token(), m_curFilePath);
   m_asm.appendLine({"lload", to_string(instanceIndex)});
   setVisitingInstance(true, cid->componentDefination, cid->instanceIndex);
   visit(bd->expr.get());
@@ -813,10 +878,26 @@ int AsmVisitor::instanceIndexVisiting() const {
 
 bool AsmVisitor::visitingMethod() const { return m_visitingMethod; }
 
+void AsmVisitor::appendLocation(const frontend::Token &tok,
+                                const string &path) {
+  if (tok.line < 0 || path.empty()) {
+    return;
+  }
+
+  // .loc <path> <line> <column>
+  vector<string> directive = {".loc", path, to_string(tok.line),
+                              to_string(tok.column)};
+  if (directive != m_lastLocation) {
+    m_asm.appendLine(directive);
+    m_lastLocation = directive;
+  }
+}
+
 void AsmVisitor::clear() {
   setVisitingMethod(false);
   setVisitingInstance(false);
   m_curFilePath = "";
+  m_lastLocation.clear();
 }
 
 }  // namespace backend
@@ -28,10 +28,19 @@ class AsmVisitor : public Visitor {
   AsmVisitor();
 
   AsmText visit(AST *ast);
+  // code of the struct and component documents of ast
+  AsmText visitDefinations(AST *ast);
+  // main of cid, to be appended to the code of its definations
+  AsmText visitInstance(ComponentInstanceDecl *cid);
+
+  // labels are numbered on from here, so the code of several visits may be
+  // assembled together
+  int labelCounter() const;
+  void setLabelCounter(int counter);
 
  protected:
   void visit(Expr *e) override { Visitor::visit(e); }
-  void visit(Stmt *s) override { Visitor::visit(s); }
+  void visit(Stmt *s) override;
   void visit(DocumentDecl *dd) override { Visitor::visit(dd); }
   void visit(IntegerLiteral *il) override;
   void visit(FloatLiteral *fl) override;
@@ -63,6 +72,8 @@ class AsmVisitor : public Visitor {
   void visit(BindingDecl *bd) override;
   void visit(ComponentInstanceDecl *cid) override;
 
+  void genAsmForDefinations(AST *ast);
+  void genAsmForMain(ComponentInstanceDecl *cid);
   void genAsmForInitInstance(ComponentInstanceDecl *cid);
   void genAsmForAllMember(ComponentInstanceDecl *cid);
   void genAsmForPropertyDecl(ComponentInstanceDecl *cid, PropertyDecl *pd);
@@ -83,6 +94,9 @@ class AsmVisitor : public Visitor {
   ComponentDefinationDecl *componentVisiting() const;
   bool visitingMethod() const;
 
+  // .loc of the code appended next, nothing if tok has no position
+  void appendLocation(const frontend::Token &tok, const std::string &path);
+
   void clear();
 
  private:
@@ -105,6 +119,7 @@ class AsmVisitor : public Visitor {
   ComponentDefinationDecl *m_componentVisiting = nullptr;
   bool m_visitingMethod = false;
   std::string m_curFilePath;
+  std::vector<std::string> m_lastLocation;
 };
 
 }  // namespace backend
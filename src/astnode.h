@@ -373,6 +373,8 @@ struct ComponentInstanceDecl : public DocumentDecl {
 
   std::vector<std::pair<ComponentInstanceDecl *, ASTNode *>>
       orderedMemberInitList;
+  // indexes in orderedMemberInitList which each member init reads
+  std::vector<std::set<int>> orderedMemberInitDeps;
 };
 
 }  // namespace rectangle
@@ -0,0 +1,635 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "deflate.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <queue>
+
+using namespace std;
+
+namespace rectangle {
+namespace util {
+
+namespace {
+
+struct CrcTable {
+  CrcTable() {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      values[n] = c;
+    }
+  }
+  uint32_t values[256];
+};
+
+const int kWindowSize = 32768;
+const int kMinMatch = 3;
+const int kMaxMatch = 258;
+const int kHashBits = 15;
+// input bytes per block
+const size_t kBlockSize = 64 * 1024;
+
+const int kLitLenCodes = 286;
+const int kDistCodes = 30;
+const int kCodeLengthCodes = 19;
+const int kEndOfBlock = 256;
+
+const int kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,
+                             15, 17, 19, 23, 27, 31, 35, 43, 51,  59,
+                             67, 83, 99, 115, 131, 163, 195, 227, 258};
+const int kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                              2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const int kDistBase[30] = {1,    2,    3,    4,    5,    7,     9,    13,
+                           17,   25,   33,   49,   65,   97,    129,  193,
+                           257,  385,  513,  769,  1025, 1537,  2049, 3073,
+                           4097, 6145, 8193, 12289, 16385, 24577};
+const int kDistExtra[30] = {0, 0, 0,  0,  1,  1,  2,  2,  3,  3,
+                            4, 4, 5,  5,  6,  6,  7,  7,  8,  8,
+                            9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+const int kCodeLengthOrder[kCodeLengthCodes] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// code of every match length and distance
+struct CodeTables {
+  CodeTables() {
+    for (int code = 0; code < 29; code++) {
+      int end = code == 28 ? kMaxMatch + 1 : kLengthBase[code + 1];
+      for (int len = kLengthBase[code]; len < end; len++) {
+        lengthCode[len] = static_cast<uint8_t>(code);
+      }
+    }
+    // distances up to 256 directly, larger ones by (dist - 1) >> 7
+    for (int code = 0; code < kDistCodes; code++) {
+      int end = code == kDistCodes - 1 ? kWindowSize + 1 : kDistBase[code + 1];
+      for (int dist = kDistBase[code]; dist < end; dist++) {
+        if (dist <= 256) {
+          distCode[dist - 1] = static_cast<uint8_t>(code);
+        } else {
+          distCode[256 + ((dist - 1) >> 7)] = static_cast<uint8_t>(code);
+        }
+      }
+    }
+  }
+  int dist(int d) const {
+    return d <= 256 ? distCode[d - 1] : distCode[256 + ((d - 1) >> 7)];
+  }
+  uint8_t lengthCode[kMaxMatch + 1];
+  uint8_t distCode[512];
+};
+
+// the codes of block type 1
+struct FixedCodes {
+  FixedCodes() {
+    for (int i = 0; i < 288; i++) {
+      litLenLengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    }
+    for (int i = 0; i < kDistCodes; i++) {
+      distLengths[i] = 5;
+    }
+  }
+  uint8_t litLenLengths[288];
+  uint8_t distLengths[kDistCodes];
+};
+
+const CodeTables &codeTables() {
+  static const CodeTables tables;
+  return tables;
+}
+
+}  // namespace
+
+uint32_t crc32(uint32_t crc, const void *data, size_t size) {
+  static const CrcTable table;
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc = table.values[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+// Huffman code lengths of at most limit bits. Lengths deeper than limit
+// are cut and the Kraft sum is repaired by moving codes one level down,
+// then the shortest lengths go to the most frequent symbols.
+static void buildLengths(const uint32_t *freqs, int n, int limit,
+                         uint8_t *lengths) {
+  memset(lengths, 0, static_cast<size_t>(n));
+  vector<int> used;
+  for (int i = 0; i < n; i++) {
+    if (freqs[i] > 0) {
+      used.push_back(i);
+    }
+  }
+  // a complete code needs two symbols
+  if (used.size() < 2) {
+    int other = used.empty() || used[0] != 0 ? 0 : 1;
+    lengths[other] = 1;
+    if (!used.empty()) {
+      lengths[used[0]] = 1;
+    } else {
+      lengths[1] = 1;
+    }
+    return;
+  }
+
+  // nodes [0, used.size()) are leaves, the others are internal
+  vector<int> left;
+  vector<int> right;
+  typedef pair<uint64_t, int> Entry;
+  priority_queue<Entry, vector<Entry>, greater<Entry>> queue;
+  for (size_t i = 0; i < used.size(); i++) {
+    queue.push(Entry(freqs[used[i]], static_cast<int>(i)));
+  }
+  int nodeCount = static_cast<int>(used.size());
+  while (queue.size() > 1) {
+    Entry a = queue.top();
+    queue.pop();
+    Entry b = queue.top();
+    queue.pop();
+    left.push_back(a.second);
+    right.push_back(b.second);
+    queue.push(Entry(a.first + b.first, nodeCount++));
+  }
+  vector<int> depth(static_cast<size_t>(nodeCount), 0);
+  int leafCount = static_cast<int>(used.size());
+  for (int node = nodeCount - 1; node >= leafCount; node--) {
+    size_t internal = static_cast<size_t>(node - leafCount);
+    int childDepth = depth[static_cast<size_t>(node)] + 1;
+    depth[static_cast<size_t>(left[internal])] = childDepth;
+    depth[static_cast<size_t>(right[internal])] = childDepth;
+  }
+
+  vector<int> counts(static_cast<size_t>(limit) + 1, 0);
+  for (int i = 0; i < leafCount; i++) {
+    counts[static_cast<size_t>(min(depth[static_cast<size_t>(i)], limit))]++;
+  }
+  uint32_t total = 0;
+  for (int len = 1; len <= limit; len++) {
+    total += static_cast<uint32_t>(counts[static_cast<size_t>(len)])
+             << (limit - len);
+  }
+  while (total > (1u << limit)) {
+    counts[static_cast<size_t>(limit)]--;
+    for (int len = limit - 1; len > 0; len--) {
+      if (counts[static_cast<size_t>(len)] > 0) {
+        counts[static_cast<size_t>(len)]--;
+        counts[static_cast<size_t>(len) + 1] += 2;
+        break;
+      }
+    }
+    total--;
+  }
+
+  stable_sort(used.begin(), used.end(), [freqs](int a, int b) {
+    return freqs[a] > freqs[b];
+  });
+  size_t next = 0;
+  for (int len = 1; len <= limit; len++) {
+    for (int i = 0; i < counts[static_cast<size_t>(len)]; i++) {
+      lengths[used[next++]] = static_cast<uint8_t>(len);
+    }
+  }
+}
+
+// canonical codes, bit reversed as deflate writes from the low bit
+static void buildCodes(const uint8_t *lengths, int n, uint16_t *codes) {
+  int counts[16] = {0};
+  for (int i = 0; i < n; i++) {
+    counts[lengths[i]]++;
+  }
+  counts[0] = 0;
+  int next[16] = {0};
+  int code = 0;
+  for (int len = 1; len < 16; len++) {
+    code = (code + counts[len - 1]) << 1;
+    next[len] = code;
+  }
+  for (int i = 0; i < n; i++) {
+    int len = lengths[i];
+    if (len == 0) {
+      codes[i] = 0;
+      continue;
+    }
+    int c = next[len]++;
+    int reversed = 0;
+    for (int b = 0; b < len; b++) {
+      reversed = (reversed << 1) | ((c >> b) & 1);
+    }
+    codes[i] = static_cast<uint16_t>(reversed);
+  }
+}
+
+// run length coding of the code lengths, every entry is code | extra << 8
+static vector<int> encodeLengths(const uint8_t *lengths, int n) {
+  vector<int> out;
+  int i = 0;
+  while (i < n) {
+    int len = lengths[i];
+    int run = 1;
+    while (i + run < n && lengths[i + run] == len) {
+      run++;
+    }
+    i += run;
+    if (len == 0) {
+      while (run >= 11) {
+        int r = min(run, 138);
+        out.push_back(18 | (r - 11) << 8);
+        run -= r;
+      }
+      if (run >= 3) {
+        out.push_back(17 | (run - 3) << 8);
+        run = 0;
+      }
+    } else {
+      out.push_back(len);
+      run--;
+      while (run >= 3) {
+        int r = min(run, 6);
+        out.push_back(16 | (r - 3) << 8);
+        run -= r;
+      }
+    }
+    for (; run > 0; run--) {
+      out.push_back(len);
+    }
+  }
+  return out;
+}
+
+static const int kCodeLengthExtra[kCodeLengthCodes] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7};
+
+Deflater::Deflater(int level)
+    : m_level(min(max(level, 0), 9)),
+      m_head(static_cast<size_t>(1) << kHashBits, -1) {
+  static const int maxChains[10] = {0, 4, 8, 16, 32, 64, 128, 256, 1024, 4096};
+  static const int niceLengths[10] = {0,   8,   16,  32,  64,
+                                      128, 128, 258, 258, 258};
+  m_maxChain = maxChains[m_level];
+  m_niceLength = niceLengths[m_level];
+  m_lazy = m_level >= 4;
+}
+
+int Deflater::level() const { return m_level; }
+
+void Deflater::write(const char *data, size_t size, string &out) {
+  m_buffer.insert(m_buffer.end(), data, data + size);
+  // matches may look kMaxMatch bytes past the block
+  while (m_buffer.size() - m_pos >= kBlockSize + kMaxMatch) {
+    compressBlock(m_pos + kBlockSize, false, out);
+  }
+}
+
+void Deflater::finish(string &out) {
+  // a block ending on a match may already reach the end, the final block
+  // is empty then
+  for (;;) {
+    size_t limit = min(m_buffer.size(), m_pos + kBlockSize);
+    bool last = limit == m_buffer.size();
+    compressBlock(limit, last, out);
+    if (last) {
+      break;
+    }
+  }
+  alignToByte(out);
+}
+
+static uint32_t hashAt(const unsigned char *p) {
+  return ((static_cast<uint32_t>(p[0]) << 10) ^
+          (static_cast<uint32_t>(p[1]) << 5) ^ p[2]) &
+         ((1u << kHashBits) - 1);
+}
+
+void Deflater::insert(size_t pos) {
+  if (pos + kMinMatch > m_buffer.size()) {
+    return;
+  }
+  uint32_t h = hashAt(&m_buffer[pos]);
+  m_prev[pos] = m_head[h];
+  m_head[h] = static_cast<int32_t>(pos);
+}
+
+int Deflater::longestMatch(size_t pos, int &dist) const {
+  if (pos + kMinMatch > m_buffer.size()) {
+    return 0;
+  }
+  const unsigned char *cur = &m_buffer[pos];
+  int maxLength = static_cast<int>(
+      min(m_buffer.size() - pos, static_cast<size_t>(kMaxMatch)));
+  int best = 0;
+  int chain = m_maxChain;
+  int32_t candidate = m_head[hashAt(cur)];
+  while (candidate >= 0 && chain-- > 0 &&
+         pos - static_cast<size_t>(candidate) <= kWindowSize) {
+    const unsigned char *p = &m_buffer[static_cast<size_t>(candidate)];
+    if (p[best] == cur[best] && p[0] == cur[0] && p[1] == cur[1]) {
+      int len = 2;
+      while (len < maxLength && p[len] == cur[len]) {
+        len++;
+      }
+      if (len > best) {
+        best = len;
+        dist = static_cast<int>(pos - static_cast<size_t>(candidate));
+        if (len >= m_niceLength || len == maxLength) {
+          break;
+        }
+      }
+    }
+    candidate = m_prev[static_cast<size_t>(candidate)];
+  }
+  // a short match far away costs more than its literals
+  if (best < kMinMatch || (best == kMinMatch && dist > 4096)) {
+    return 0;
+  }
+  return best;
+}
+
+void Deflater::compressBlock(size_t limit, bool last, string &out) {
+  size_t begin = m_pos;
+  m_prev.resize(m_buffer.size(), -1);
+  m_symbols.clear();
+
+  if (m_level > 0) {
+    size_t pos = m_pos;
+    int prevLength = 0;
+    int prevDist = 0;
+    bool pending = false;
+    while (pos < limit) {
+      int dist = 0;
+      int length = longestMatch(pos, dist);
+      insert(pos);
+      if (!m_lazy) {
+        if (length >= kMinMatch) {
+          m_symbols.push_back({static_cast<uint16_t>(length),
+                               static_cast<uint16_t>(dist)});
+          for (size_t i = pos + 1; i < pos + static_cast<size_t>(length);
+               i++) {
+            insert(i);
+          }
+          pos += static_cast<size_t>(length);
+        } else {
+          m_symbols.push_back({m_buffer[pos], 0});
+          pos++;
+        }
+        continue;
+      }
+
+      // a match is only taken if the next position has no longer one
+      if (pending && prevLength >= kMinMatch && length <= prevLength) {
+        m_symbols.push_back({static_cast<uint16_t>(prevLength),
+                             static_cast<uint16_t>(prevDist)});
+        size_t end = pos - 1 + static_cast<size_t>(prevLength);
+        for (size_t i = pos + 1; i < end; i++) {
+          insert(i);
+        }
+        pos = end;
+        pending = false;
+        prevLength = 0;
+      } else {
+        if (pending) {
+          m_symbols.push_back({m_buffer[pos - 1], 0});
+        }
+        pending = true;
+        prevLength = length;
+        prevDist = dist;
+        pos++;
+      }
+    }
+    if (pending) {
+      if (prevLength >= kMinMatch) {
+        m_symbols.push_back({static_cast<uint16_t>(prevLength),
+                             static_cast<uint16_t>(prevDist)});
+        size_t end = pos - 1 + static_cast<size_t>(prevLength);
+        for (size_t i = pos; i < end; i++) {
+          insert(i);
+        }
+        pos = end;
+      } else {
+        m_symbols.push_back({m_buffer[pos - 1], 0});
+      }
+    }
+    m_pos = pos;
+  } else {
+    m_pos = limit;
+  }
+
+  emitBlock(begin, m_pos, last, out);
+  slide();
+}
+
+void Deflater::emitBlock(size_t begin, size_t end, bool last, string &out) {
+  if (m_level == 0) {
+    emitStored(begin, end, last, out);
+    return;
+  }
+
+  const CodeTables &tables = codeTables();
+  uint32_t litLenFreqs[kLitLenCodes] = {0};
+  uint32_t distFreqs[kDistCodes] = {0};
+  for (auto &s : m_symbols) {
+    if (s.dist == 0) {
+      litLenFreqs[s.litLen]++;
+    } else {
+      litLenFreqs[257 + tables.lengthCode[s.litLen]]++;
+      distFreqs[tables.dist(s.dist)]++;
+    }
+  }
+  litLenFreqs[kEndOfBlock] = 1;
+
+  uint8_t litLenLengths[kLitLenCodes];
+  uint8_t distLengths[kDistCodes];
+  buildLengths(litLenFreqs, kLitLenCodes, 15, litLenLengths);
+  buildLengths(distFreqs, kDistCodes, 15, distLengths);
+
+  int litLenCount = kLitLenCodes;
+  while (litLenCount > 257 && litLenLengths[litLenCount - 1] == 0) {
+    litLenCount--;
+  }
+  int distCount = kDistCodes;
+  while (distCount > 1 && distLengths[distCount - 1] == 0) {
+    distCount--;
+  }
+  uint8_t allLengths[kLitLenCodes + kDistCodes];
+  memcpy(allLengths, litLenLengths, static_cast<size_t>(litLenCount));
+  memcpy(allLengths + litLenCount, distLengths,
+         static_cast<size_t>(distCount));
+  vector<int> lengthSymbols =
+      encodeLengths(allLengths, litLenCount + distCount);
+  uint32_t codeLengthFreqs[kCodeLengthCodes] = {0};
+  for (int s : lengthSymbols) {
+    codeLengthFreqs[s & 0xff]++;
+  }
+  uint8_t codeLengthLengths[kCodeLengthCodes];
+  buildLengths(codeLengthFreqs, kCodeLengthCodes, 7, codeLengthLengths);
+  int codeLengthCount = kCodeLengthCodes;
+  while (codeLengthCount > 4 &&
+         codeLengthLengths[kCodeLengthOrder[codeLengthCount - 1]] == 0) {
+    codeLengthCount--;
+  }
+
+  // sizes in bits of the three block types
+  FixedCodes fixed;
+  uint64_t extraBits = 0;
+  uint64_t dynamicBits =
+      3 + 5 + 5 + 4 + 3 * static_cast<uint64_t>(codeLengthCount);
+  uint64_t fixedBits = 3;
+  for (int s : lengthSymbols) {
+    dynamicBits += codeLengthLengths[s & 0xff] +
+                   static_cast<uint64_t>(kCodeLengthExtra[s & 0xff]);
+  }
+  for (int i = 0; i < kLitLenCodes; i++) {
+    dynamicBits += static_cast<uint64_t>(litLenFreqs[i]) * litLenLengths[i];
+    fixedBits += static_cast<uint64_t>(litLenFreqs[i]) * fixed.litLenLengths[i];
+    if (i >= 257) {
+      extraBits +=
+          static_cast<uint64_t>(litLenFreqs[i]) * kLengthExtra[i - 257];
+    }
+  }
+  for (int i = 0; i < kDistCodes; i++) {
+    dynamicBits += static_cast<uint64_t>(distFreqs[i]) * distLengths[i];
+    fixedBits += static_cast<uint64_t>(distFreqs[i]) * 5;
+    extraBits += static_cast<uint64_t>(distFreqs[i]) * kDistExtra[i];
+  }
+  dynamicBits += extraBits;
+  fixedBits += extraBits;
+  uint64_t storedBits =
+      8 * (static_cast<uint64_t>(end - begin) +
+           5 * ((end - begin) / 65535 + 1)) + 7;
+
+  if (storedBits < dynamicBits && storedBits < fixedBits) {
+    emitStored(begin, end, last, out);
+    return;
+  }
+
+  uint16_t litLenCodes[288];
+  uint16_t distCodes[kDistCodes];
+  putBits(last ? 1 : 0, 1, out);
+  if (fixedBits <= dynamicBits) {
+    putBits(1, 2, out);
+    buildCodes(fixed.litLenLengths, 288, litLenCodes);
+    buildCodes(fixed.distLengths, kDistCodes, distCodes);
+    emitSymbols(fixed.litLenLengths, litLenCodes, fixed.distLengths,
+                distCodes, out);
+    return;
+  }
+
+  putBits(2, 2, out);
+  putBits(static_cast<uint32_t>(litLenCount - 257), 5, out);
+  putBits(static_cast<uint32_t>(distCount - 1), 5, out);
+  putBits(static_cast<uint32_t>(codeLengthCount - 4), 4, out);
+  for (int i = 0; i < codeLengthCount; i++) {
+    putBits(codeLengthLengths[kCodeLengthOrder[i]], 3, out);
+  }
+  uint16_t codeLengthCodes[kCodeLengthCodes];
+  buildCodes(codeLengthLengths, kCodeLengthCodes, codeLengthCodes);
+  for (int s : lengthSymbols) {
+    int code = s & 0xff;
+    putBits(codeLengthCodes[code], codeLengthLengths[code], out);
+    if (kCodeLengthExtra[code] > 0) {
+      putBits(static_cast<uint32_t>(s >> 8), kCodeLengthExtra[code], out);
+    }
+  }
+  buildCodes(litLenLengths, kLitLenCodes, litLenCodes);
+  buildCodes(distLengths, kDistCodes, distCodes);
+  emitSymbols(litLenLengths, litLenCodes, distLengths, distCodes, out);
+}
+
+void Deflater::emitSymbols(const uint8_t *litLenLengths,
+                           const uint16_t *litLenCodes,
+                           const uint8_t *distLengths,
+                           const uint16_t *distCodes, string &out) {
+  const CodeTables &tables = codeTables();
+  for (auto &s : m_symbols) {
+    if (s.dist == 0) {
+      putBits(litLenCodes[s.litLen], litLenLengths[s.litLen], out);
+      continue;
+    }
+    int lengthCode = tables.lengthCode[s.litLen];
+    putBits(litLenCodes[257 + lengthCode], litLenLengths[257 + lengthCode],
+            out);
+    putBits(static_cast<uint32_t>(s.litLen - kLengthBase[lengthCode]),
+            kLengthExtra[lengthCode], out);
+    int distCode = tables.dist(s.dist);
+    putBits(distCodes[distCode], distLengths[distCode], out);
+    putBits(static_cast<uint32_t>(s.dist - kDistBase[distCode]),
+            kDistExtra[distCode], out);
+  }
+  putBits(litLenCodes[kEndOfBlock], litLenLengths[kEndOfBlock], out);
+}
+
+void Deflater::emitStored(size_t begin, size_t end, bool last, string &out) {
+  do {
+    size_t size = min(end - begin, static_cast<size_t>(65535));
+    putBits(last && begin + size == end ? 1 : 0, 1, out);
+    putBits(0, 2, out);
+    alignToByte(out);
+    out.push_back(static_cast<char>(size & 0xff));
+    out.push_back(static_cast<char>(size >> 8));
+    out.push_back(static_cast<char>(~size & 0xff));
+    out.push_back(static_cast<char>((~size >> 8) & 0xff));
+    out.append(reinterpret_cast<const char *>(m_buffer.data()) + begin, size);
+    begin += size;
+  } while (begin < end);
+}
+
+void Deflater::slide() {
+  if (m_pos <= 2 * static_cast<size_t>(kWindowSize)) {
+    return;
+  }
+  // keep one window of history before the pending input
+  size_t shift = m_pos - kWindowSize;
+  m_buffer.erase(m_buffer.begin(),
+                 m_buffer.begin() + static_cast<ptrdiff_t>(shift));
+  m_prev.erase(m_prev.begin(), m_prev.begin() + static_cast<ptrdiff_t>(shift));
+  int32_t delta = static_cast<int32_t>(shift);
+  for (auto &p : m_head) {
+    p = p >= delta ? p - delta : -1;
+  }
+  for (auto &p : m_prev) {
+    p = p >= delta ? p - delta : -1;
+  }
+  m_pos -= shift;
+}
+
+void Deflater::putBits(uint32_t value, int count, string &out) {
+  m_bits |= static_cast<uint64_t>(value) << m_bitCount;
+  m_bitCount += count;
+  while (m_bitCount >= 8) {
+    out.push_back(static_cast<char>(m_bits & 0xff));
+    m_bits >>= 8;
+    m_bitCount -= 8;
+  }
+}
+
+void Deflater::alignToByte(string &out) {
+  if (m_bitCount > 0) {
+    out.push_back(static_cast<char>(m_bits & 0xff));
+  }
+  m_bits = 0;
+  m_bitCount = 0;
+}
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,86 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace rectangle {
+namespace util {
+
+// crc32 of gzip and png, pass 0 to start and the previous result to go on
+uint32_t crc32(uint32_t crc, const void *data, size_t size);
+
+// Raw deflate (RFC 1951) compressor for a stream. Matches are found
+// through hash chains and every block is written with the cheapest of
+// dynamic Huffman codes, the fixed codes or stored bytes.
+class Deflater {
+ public:
+  // 0 only stores the data, 1 is the fastest and 9 the smallest
+  explicit Deflater(int level = 6);
+
+  // Appends the compressed data to out. Input is kept until it fills a
+  // block, so the output lags behind.
+  void write(const char *data, size_t size, std::string &out);
+  // compresses the rest of the input and ends the stream
+  void finish(std::string &out);
+
+  int level() const;
+
+ private:
+  // a literal if dist is 0, otherwise a match of length litLen
+  struct Symbol {
+    uint16_t litLen;
+    uint16_t dist;
+  };
+
+  void compressBlock(size_t limit, bool last, std::string &out);
+  void insert(size_t pos);
+  int longestMatch(size_t pos, int &dist) const;
+  void emitBlock(size_t begin, size_t end, bool last, std::string &out);
+  void emitStored(size_t begin, size_t end, bool last, std::string &out);
+  void emitSymbols(const uint8_t *litLenLengths, const uint16_t *litLenCodes,
+                   const uint8_t *distLengths, const uint16_t *distCodes,
+                   std::string &out);
+  void slide();
+  void putBits(uint32_t value, int count, std::string &out);
+  void alignToByte(std::string &out);
+
+ private:
+  int m_level;
+  int m_maxChain;
+  int m_niceLength;
+  bool m_lazy;
+
+  // history of up to 32k bytes followed by the pending input
+  std::vector<unsigned char> m_buffer;
+  size_t m_pos = 0;
+  std::vector<int32_t> m_head;
+  std::vector<int32_t> m_prev;
+  std::vector<Symbol> m_symbols;
+
+  uint64_t m_bits = 0;
+  int m_bitCount = 0;
+};
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,318 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "displaylist.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+int StringPool::intern(const string &s) {
+  auto it = m_ids.find(s);
+  if (it != m_ids.end()) {
+    return it->second;
+  }
+  int id = static_cast<int>(m_strings.size());
+  m_strings.push_back(s);
+  m_ids.emplace(s, id);
+  return id;
+}
+
+const string &StringPool::get(int id) const {
+  assert(id >= 0 && id < size());
+  return m_strings[static_cast<size_t>(id)];
+}
+
+int StringPool::size() const { return static_cast<int>(m_strings.size()); }
+
+void StringPool::clear() {
+  m_ids.clear();
+  m_strings.clear();
+}
+
+bool operator==(const Style &lhs, const Style &rhs) {
+  return lhs.fillColor == rhs.fillColor &&
+         lhs.strokeWidth == rhs.strokeWidth &&
+         lhs.strokeColor == rhs.strokeColor &&
+         lhs.strokeDasharray == rhs.strokeDasharray &&
+         lhs.fillRule == rhs.fillRule;
+}
+
+size_t StyleHash::operator()(const Style &style) const {
+  size_t h = static_cast<size_t>(style.fillColor);
+  h = h * 31 + static_cast<size_t>(style.strokeWidth);
+  h = h * 31 + static_cast<size_t>(style.strokeColor);
+  h = h * 31 + static_cast<size_t>(style.strokeDasharray);
+  h = h * 31 + static_cast<size_t>(style.fillRule);
+  return h;
+}
+
+void DisplayList::clear() {
+  m_items.clear();
+  m_rectangles.clear();
+  m_texts.clear();
+  m_ellipses.clear();
+  m_polygons.clear();
+  m_lines.clear();
+  m_polylines.clear();
+  m_points.clear();
+  m_strings.clear();
+  m_styles.clear();
+  m_styleIds.clear();
+}
+
+Style DisplayList::makeStyle(int strokeWidth, const string &strokeColor,
+                             const string &strokeDasharray) {
+  Style style;
+  style.strokeWidth = strokeWidth;
+  style.strokeColor = m_strings.intern(strokeColor);
+  style.strokeDasharray = m_strings.intern(strokeDasharray);
+  return style;
+}
+
+int DisplayList::internStyle(const Style &style) {
+  auto it = m_styleIds.find(style);
+  if (it != m_styleIds.end()) {
+    return it->second;
+  }
+  int id = static_cast<int>(m_styles.size());
+  m_styles.push_back(style);
+  m_styleIds.emplace(style, id);
+  return id;
+}
+
+int DisplayList::appendPoints(const vector<int32_t> &points) {
+  assert(points.size() % 2 == 0);
+  int begin = static_cast<int>(m_points.size() / 2);
+  m_points.insert(m_points.end(), points.begin(), points.end());
+  return begin;
+}
+
+void DisplayList::append(const RectangleData &d, int originX, int originY,
+                         int instance) {
+  RectangleShape shape;
+  shape.x = d.x + originX;
+  shape.y = d.y + originY;
+  shape.width = d.width;
+  shape.height = d.height;
+  Style style = makeStyle(d.stroke_width, d.stroke_color, d.stroke_dasharray);
+  style.fillColor = m_strings.intern(d.fill_color);
+  shape.style = internStyle(style);
+  m_items.push_back({ShapeType::Rectangle,
+                     static_cast<int>(m_rectangles.size()), instance});
+  m_rectangles.push_back(shape);
+}
+
+void DisplayList::append(const TextData &d, int originX, int originY,
+                         int instance) {
+  TextShape shape;
+  shape.x = d.x + originX;
+  shape.y = d.y + originY;
+  shape.size = d.size;
+  shape.text = m_strings.intern(d.text);
+  m_items.push_back(
+      {ShapeType::Text, static_cast<int>(m_texts.size()), instance});
+  m_texts.push_back(shape);
+}
+
+void DisplayList::append(const EllipseData &d, int originX, int originY,
+                         int instance) {
+  EllipseShape shape;
+  shape.cx = d.x + d.x_radius + originX;
+  shape.cy = d.y + d.y_radius + originY;
+  shape.rx = d.x_radius;
+  shape.ry = d.y_radius;
+  Style style = makeStyle(d.stroke_width, d.stroke_color, d.stroke_dasharray);
+  style.fillColor = m_strings.intern(d.fill_color);
+  shape.style = internStyle(style);
+  m_items.push_back(
+      {ShapeType::Ellipse, static_cast<int>(m_ellipses.size()), instance});
+  m_ellipses.push_back(shape);
+}
+
+void DisplayList::append(const PolygonData &d, int originX, int originY,
+                         int instance) {
+  PolygonShape shape;
+  shape.x = d.x + originX;
+  shape.y = d.y + originY;
+  shape.pointBegin = appendPoints(d.points);
+  shape.pointCount = static_cast<int>(d.points.size() / 2);
+  Style style = makeStyle(d.stroke_width, d.stroke_color, d.stroke_dasharray);
+  style.fillColor = m_strings.intern(d.fill_color);
+  style.fillRule = m_strings.intern(d.fill_rule);
+  shape.style = internStyle(style);
+  m_items.push_back(
+      {ShapeType::Polygon, static_cast<int>(m_polygons.size()), instance});
+  m_polygons.push_back(shape);
+}
+
+void DisplayList::append(const LineData &d, int originX, int originY,
+                         int instance) {
+  LineShape shape;
+  shape.x1 = originX + d.x + d.dx1;
+  shape.y1 = originY + d.y + d.dy1;
+  shape.x2 = originX + d.x + d.dx2;
+  shape.y2 = originY + d.y + d.dy2;
+  shape.style = internStyle(
+      makeStyle(d.stroke_width, d.stroke_color, d.stroke_dasharray));
+  m_items.push_back(
+      {ShapeType::Line, static_cast<int>(m_lines.size()), instance});
+  m_lines.push_back(shape);
+}
+
+void DisplayList::append(const PolylineData &d, int originX, int originY,
+                         int instance) {
+  PolylineShape shape;
+  shape.x = d.x + originX;
+  shape.y = d.y + originY;
+  shape.pointBegin = appendPoints(d.points);
+  shape.pointCount = static_cast<int>(d.points.size() / 2);
+  Style style = makeStyle(d.stroke_width, d.stroke_color, d.stroke_dasharray);
+  style.fillColor = m_strings.intern("none");
+  shape.style = internStyle(style);
+  m_items.push_back(
+      {ShapeType::Polyline, static_cast<int>(m_polylines.size()), instance});
+  m_polylines.push_back(shape);
+}
+
+Rect DisplayList::pointBounds(int x, int y, int pointBegin,
+                              int pointCount) const {
+  if (pointCount == 0) {
+    return Rect{x, y, x, y};
+  }
+  const int32_t *p = points(pointBegin);
+  Rect r{p[0], p[1], p[0], p[1]};
+  for (int i = 1; i < pointCount; i++) {
+    r.left = min(r.left, p[2 * i]);
+    r.right = max(r.right, p[2 * i]);
+    r.top = min(r.top, p[2 * i + 1]);
+    r.bottom = max(r.bottom, p[2 * i + 1]);
+  }
+  return Rect{x + r.left, y + r.top, x + r.right, y + r.bottom};
+}
+
+static Rect expand(const Rect &r, int strokeWidth) {
+  // half of the stroke is outside the geometry
+  int d = (max(strokeWidth, 0) + 1) / 2;
+  return Rect{r.left - d, r.top - d, r.right + d, r.bottom + d};
+}
+
+Rect DisplayList::bounds(const DisplayItem &item) const {
+  switch (item.type) {
+    case ShapeType::Rectangle: {
+      const RectangleShape &s = rectangle(item.index);
+      return expand(Rect{s.x, s.y, s.x + s.width, s.y + s.height},
+                    style(s.style).strokeWidth);
+    }
+    case ShapeType::Text: {
+      const TextShape &s = text(item.index);
+      int length = static_cast<int>(str(s.text).size());
+      return Rect{s.x, s.y, s.x + s.size * length, s.y + s.size};
+    }
+    case ShapeType::Ellipse: {
+      const EllipseShape &s = ellipse(item.index);
+      return expand(Rect{s.cx - s.rx, s.cy - s.ry, s.cx + s.rx, s.cy + s.ry},
+                    style(s.style).strokeWidth);
+    }
+    case ShapeType::Polygon: {
+      const PolygonShape &s = polygon(item.index);
+      return expand(pointBounds(s.x, s.y, s.pointBegin, s.pointCount),
+                    style(s.style).strokeWidth);
+    }
+    case ShapeType::Line: {
+      const LineShape &s = line(item.index);
+      return expand(Rect{min(s.x1, s.x2), min(s.y1, s.y2), max(s.x1, s.x2),
+                         max(s.y1, s.y2)},
+                    style(s.style).strokeWidth);
+    }
+    case ShapeType::Polyline: {
+      const PolylineShape &s = polyline(item.index);
+      return expand(pointBounds(s.x, s.y, s.pointBegin, s.pointCount),
+                    style(s.style).strokeWidth);
+    }
+  }
+  assert(false);
+  return Rect{0, 0, 0, 0};
+}
+
+void DisplayList::appendItem(const DisplayList &from, const DisplayItem &item) {
+  DisplayItem copy = item;
+  switch (item.type) {
+    case ShapeType::Rectangle:
+      copy.index = static_cast<int>(m_rectangles.size());
+      m_rectangles.push_back(from.rectangle(item.index));
+      break;
+    case ShapeType::Text:
+      copy.index = static_cast<int>(m_texts.size());
+      m_texts.push_back(from.text(item.index));
+      break;
+    case ShapeType::Ellipse:
+      copy.index = static_cast<int>(m_ellipses.size());
+      m_ellipses.push_back(from.ellipse(item.index));
+      break;
+    case ShapeType::Polygon: {
+      PolygonShape shape = from.polygon(item.index);
+      const int32_t *points = from.points(shape.pointBegin);
+      shape.pointBegin = static_cast<int>(m_points.size() / 2);
+      m_points.insert(m_points.end(), points, points + 2 * shape.pointCount);
+      copy.index = static_cast<int>(m_polygons.size());
+      m_polygons.push_back(shape);
+      break;
+    }
+    case ShapeType::Line:
+      copy.index = static_cast<int>(m_lines.size());
+      m_lines.push_back(from.line(item.index));
+      break;
+    case ShapeType::Polyline: {
+      PolylineShape shape = from.polyline(item.index);
+      const int32_t *points = from.points(shape.pointBegin);
+      shape.pointBegin = static_cast<int>(m_points.size() / 2);
+      m_points.insert(m_points.end(), points, points + 2 * shape.pointCount);
+      copy.index = static_cast<int>(m_polylines.size());
+      m_polylines.push_back(shape);
+      break;
+    }
+  }
+  m_items.push_back(copy);
+}
+
+void DisplayList::sortByInstance() {
+  vector<DisplayItem> items = m_items;
+  stable_sort(items.begin(), items.end(),
+              [](const DisplayItem &lhs, const DisplayItem &rhs) {
+                return lhs.instance < rhs.instance;
+              });
+
+  DisplayList sorted;
+  sorted.m_strings = move(m_strings);
+  sorted.m_styles = move(m_styles);
+  sorted.m_styleIds = move(m_styleIds);
+  sorted.m_items.reserve(items.size());
+  for (auto &item : items) {
+    sorted.appendItem(*this, item);
+  }
+  *this = move(sorted);
+}
+
+}  // namespace draw
+}  // namespace rectangle
@@ -0,0 +1,312 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rectangle {
+namespace draw {
+
+struct Point {
+  Point(int x_ = 0, int y_ = 0) : x(x_), y(y_) {}
+  int x;
+  int y;
+};
+
+struct SceneData {
+  int leftMargin;
+  int topMargin;
+  int rightMargin;
+  int bottomMargin;
+  int width;
+  int height;
+};
+
+struct RectangleData {
+  int x;
+  int y;
+  int width;
+  int height;
+  std::string fill_color;
+  int stroke_width;
+  std::string stroke_color;
+  std::string stroke_dasharray;
+};
+
+struct TextData {
+  int x;
+  int y;
+  int size;
+  std::string text;
+};
+
+struct EllipseData {
+  int x;
+  int y;
+  int x_radius;
+  int y_radius;
+  std::string fill_color;
+  int stroke_width;
+  std::string stroke_color;
+  std::string stroke_dasharray;
+};
+
+struct PolygonData {
+  int x;
+  int y;
+  // x0, y0, x1, y1, ...
+  std::vector<int32_t> points;
+  std::string fill_color;
+  std::string fill_rule;
+  int stroke_width;
+  std::string stroke_color;
+  std::string stroke_dasharray;
+};
+
+struct LineData {
+  int x;
+  int y;
+  int dx1;
+  int dy1;
+  int dx2;
+  int dy2;
+  int stroke_width;
+  std::string stroke_color;
+  std::string stroke_dasharray;
+};
+
+struct PolylineData {
+  int x;
+  int y;
+  // x0, y0, x1, y1, ...
+  std::vector<int32_t> points;
+  int stroke_width;
+  std::string stroke_color;
+  std::string stroke_dasharray;
+};
+
+class StringPool {
+ public:
+  int intern(const std::string &s);
+  const std::string &get(int id) const;
+  int size() const;
+  void clear();
+
+ private:
+  std::unordered_map<std::string, int> m_ids;
+  std::vector<std::string> m_strings;
+};
+
+enum class ShapeType : unsigned char {
+  Rectangle,
+  Text,
+  Ellipse,
+  Polygon,
+  Line,
+  Polyline
+};
+
+// string members are ids in the string pool of the display list, -1 if
+// the shape has no such member
+struct Style {
+  int fillColor = -1;
+  int strokeWidth = 0;
+  int strokeColor = -1;
+  int strokeDasharray = -1;
+  int fillRule = -1;
+};
+
+bool operator==(const Style &lhs, const Style &rhs);
+
+struct StyleHash {
+  size_t operator()(const Style &style) const;
+};
+
+// coordinates are absolute, the origin is already applied
+struct RectangleShape {
+  int x;
+  int y;
+  int width;
+  int height;
+  int style;
+};
+
+struct TextShape {
+  int x;
+  int y;
+  int size;
+  int text;
+};
+
+struct EllipseShape {
+  int cx;
+  int cy;
+  int rx;
+  int ry;
+  int style;
+};
+
+// points are relative to (x, y)
+struct PolygonShape {
+  int x;
+  int y;
+  int pointBegin;
+  int pointCount;
+  int style;
+};
+
+struct LineShape {
+  int x1;
+  int y1;
+  int x2;
+  int y2;
+  int style;
+};
+
+struct PolylineShape {
+  int x;
+  int y;
+  int pointBegin;
+  int pointCount;
+  int style;
+};
+
+struct DisplayItem {
+  ShapeType type;
+  int index;
+  int instance;
+};
+
+// [left, right) x [top, bottom)
+struct Rect {
+  int left;
+  int top;
+  int right;
+  int bottom;
+
+  bool intersects(const Rect &other) const {
+    return left < other.right && other.left < right && top < other.bottom &&
+           other.top < bottom;
+  }
+  bool contains(const Rect &other) const {
+    return left <= other.left && other.right <= right && top <= other.top &&
+           other.bottom <= bottom;
+  }
+};
+
+// Shapes in paint order. Every shape type has its own contiguous array
+// and the points of all polygons and polylines share one flat x, y array.
+class DisplayList {
+ public:
+  void clear();
+
+  void append(const RectangleData &d, int originX, int originY, int instance);
+  void append(const TextData &d, int originX, int originY, int instance);
+  void append(const EllipseData &d, int originX, int originY, int instance);
+  void append(const PolygonData &d, int originX, int originY, int instance);
+  void append(const LineData &d, int originX, int originY, int instance);
+  void append(const PolylineData &d, int originX, int originY, int instance);
+
+  const std::vector<DisplayItem> &items() const { return m_items; }
+  const RectangleShape &rectangle(int index) const {
+    return m_rectangles[static_cast<size_t>(index)];
+  }
+  const TextShape &text(int index) const {
+    return m_texts[static_cast<size_t>(index)];
+  }
+  const EllipseShape &ellipse(int index) const {
+    return m_ellipses[static_cast<size_t>(index)];
+  }
+  const PolygonShape &polygon(int index) const {
+    return m_polygons[static_cast<size_t>(index)];
+  }
+  const LineShape &line(int index) const {
+    return m_lines[static_cast<size_t>(index)];
+  }
+  const PolylineShape &polyline(int index) const {
+    return m_polylines[static_cast<size_t>(index)];
+  }
+  // x0, y0, x1, y1, ...
+  const int32_t *points(int pointBegin) const {
+    return m_points.data() + 2 * static_cast<size_t>(pointBegin);
+  }
+  const std::string &str(int id) const { return m_strings.get(id); }
+  const StringPool &strings() const { return m_strings; }
+  // shapes with the same look share one entry of the style table
+  const Style &style(int id) const {
+    return m_styles[static_cast<size_t>(id)];
+  }
+  int styleCount() const { return static_cast<int>(m_styles.size()); }
+
+  // Area the shape may paint, including the stroke. For text every
+  // character is taken as one font size wide.
+  Rect bounds(const DisplayItem &item) const;
+
+  // keep the shapes for which keep(item) is true, in the same order
+  template <typename Pred>
+  void filter(Pred keep);
+  // stable sort the shapes by instance
+  void sortByInstance();
+
+ private:
+  // reads and writes the arrays of the list as they are
+  friend class DisplayListFile;
+
+  Style makeStyle(int strokeWidth, const std::string &strokeColor,
+                  const std::string &strokeDasharray);
+  int internStyle(const Style &style);
+  int appendPoints(const std::vector<int32_t> &points);
+  Rect pointBounds(int x, int y, int pointBegin, int pointCount) const;
+  void appendItem(const DisplayList &from, const DisplayItem &item);
+
+ private:
+  std::vector<DisplayItem> m_items;
+  std::vector<RectangleShape> m_rectangles;
+  std::vector<TextShape> m_texts;
+  std::vector<EllipseShape> m_ellipses;
+  std::vector<PolygonShape> m_polygons;
+  std::vector<LineShape> m_lines;
+  std::vector<PolylineShape> m_polylines;
+  std::vector<int32_t> m_points;
+  StringPool m_strings;
+  std::vector<Style> m_styles;
+  std::unordered_map<Style, int, StyleHash> m_styleIds;
+};
+
+template <typename Pred>
+void DisplayList::filter(Pred keep) {
+  DisplayList kept;
+  kept.m_strings = m_strings;
+  kept.m_styles = m_styles;
+  kept.m_styleIds = m_styleIds;
+  kept.m_items.reserve(m_items.size());
+  for (auto &item : m_items) {
+    if (keep(item)) {
+      kept.appendItem(*this, item);
+    }
+  }
+  *this = std::move(kept);
+}
+
+}  // namespace draw
+}  // namespace rectangle
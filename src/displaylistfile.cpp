@@ -0,0 +1,327 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "displaylistfile.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <type_traits>
+#include <unordered_set>
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+static_assert(sizeof(Style) == 5 * 4, "style record");
+static_assert(sizeof(RectangleShape) == 5 * 4, "rectangle record");
+static_assert(sizeof(TextShape) == 4 * 4, "text record");
+static_assert(sizeof(EllipseShape) == 5 * 4, "ellipse record");
+static_assert(sizeof(PolygonShape) == 5 * 4, "polygon record");
+static_assert(sizeof(LineShape) == 5 * 4, "line record");
+static_assert(sizeof(PolylineShape) == 5 * 4, "polyline record");
+static_assert(sizeof(DisplayListHeader) == 16 * 4, "header");
+static_assert(is_trivially_copyable<Style>::value &&
+                  is_trivially_copyable<PolylineShape>::value,
+              "records are copied as bytes");
+
+const char DisplayListFile::kMagic[4] = {'R', 'D', 'L', '\0'};
+const uint32_t DisplayListFile::kByteOrder;
+const uint32_t DisplayListFile::kVersion;
+
+template <typename T>
+static void writeArray(util::OutputSink &sink, const vector<T> &v) {
+  sink.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+void DisplayListFile::write(util::OutputSink &sink, const DisplayList &list,
+                            int width, int height) {
+  DisplayListHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.byteOrder = kByteOrder;
+  header.version = kVersion;
+  header.width = width;
+  header.height = height;
+  header.itemCount = static_cast<uint32_t>(list.m_items.size());
+  header.styleCount = static_cast<uint32_t>(list.m_styles.size());
+  header.rectangleCount = static_cast<uint32_t>(list.m_rectangles.size());
+  header.textCount = static_cast<uint32_t>(list.m_texts.size());
+  header.ellipseCount = static_cast<uint32_t>(list.m_ellipses.size());
+  header.polygonCount = static_cast<uint32_t>(list.m_polygons.size());
+  header.lineCount = static_cast<uint32_t>(list.m_lines.size());
+  header.polylineCount = static_cast<uint32_t>(list.m_polylines.size());
+  header.pointCount = static_cast<uint32_t>(list.m_points.size() / 2);
+  header.stringCount = static_cast<uint32_t>(list.m_strings.size());
+
+  vector<uint32_t> offsets;
+  offsets.reserve(header.stringCount + 1);
+  uint32_t bytes = 0;
+  for (int i = 0; i < list.m_strings.size(); i++) {
+    offsets.push_back(bytes);
+    bytes += static_cast<uint32_t>(list.m_strings.get(i).size() + 1);
+  }
+  offsets.push_back(bytes);
+  // keep the file a multiple of 4 bytes
+  header.stringBytes = (bytes + 3) & ~3u;
+
+  sink.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  vector<DisplayListRecord> records;
+  records.reserve(list.m_items.size());
+  for (auto &item : list.m_items) {
+    records.push_back(
+        {static_cast<int32_t>(item.type), item.index, item.instance});
+  }
+  writeArray(sink, records);
+  writeArray(sink, list.m_styles);
+  writeArray(sink, list.m_rectangles);
+  writeArray(sink, list.m_texts);
+  writeArray(sink, list.m_ellipses);
+  writeArray(sink, list.m_polygons);
+  writeArray(sink, list.m_lines);
+  writeArray(sink, list.m_polylines);
+  writeArray(sink, list.m_points);
+  writeArray(sink, offsets);
+  for (int i = 0; i < list.m_strings.size(); i++) {
+    const string &s = list.m_strings.get(i);
+    sink.write(s.c_str(), s.size() + 1);
+  }
+  for (uint32_t i = bytes; i < header.stringBytes; i++) {
+    sink.write('\0');
+  }
+}
+
+DisplayListFile::DisplayListFile() {}
+
+DisplayListFile::~DisplayListFile() { close(); }
+
+bool DisplayListFile::open(const string &path) {
+  close();
+  if (!map(path)) {
+    return false;
+  }
+  if (!validate()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void DisplayListFile::close() {
+  if (m_data) {
+    munmap(m_data, m_size);
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_header = nullptr;
+}
+
+const string &DisplayListFile::error() const { return m_error; }
+
+void DisplayListFile::copyTo(DisplayList &list) const {
+  list.clear();
+  const DisplayListHeader &h = *m_header;
+  list.m_items.reserve(h.itemCount);
+  for (uint32_t i = 0; i < h.itemCount; i++) {
+    list.m_items.push_back({static_cast<ShapeType>(m_items[i].type),
+                            m_items[i].index, m_items[i].instance});
+  }
+  list.m_styles.assign(m_styles, m_styles + h.styleCount);
+  for (uint32_t i = 0; i < h.styleCount; i++) {
+    list.m_styleIds.emplace(m_styles[i], static_cast<int>(i));
+  }
+  list.m_rectangles.assign(m_rectangles, m_rectangles + h.rectangleCount);
+  list.m_texts.assign(m_texts, m_texts + h.textCount);
+  list.m_ellipses.assign(m_ellipses, m_ellipses + h.ellipseCount);
+  list.m_polygons.assign(m_polygons, m_polygons + h.polygonCount);
+  list.m_lines.assign(m_lines, m_lines + h.lineCount);
+  list.m_polylines.assign(m_polylines, m_polylines + h.polylineCount);
+  list.m_points.assign(m_points, m_points + 2 * size_t(h.pointCount));
+  for (uint32_t i = 0; i < h.stringCount; i++) {
+    list.m_strings.intern(str(static_cast<int>(i)));
+  }
+}
+
+bool DisplayListFile::map(const string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return fail("open " + path + " failed");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 0) {
+    ::close(fd);
+    return fail("stat " + path + " failed");
+  }
+  m_size = static_cast<size_t>(st.st_size);
+  if (m_size < sizeof(DisplayListHeader)) {
+    ::close(fd);
+    m_size = 0;
+    return fail(path + " is too short for a display list");
+  }
+  void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    m_size = 0;
+    return fail("map " + path + " failed");
+  }
+  m_data = data;
+  return true;
+}
+
+bool DisplayListFile::validate() {
+  const char *base = static_cast<const char *>(m_data);
+  m_header = reinterpret_cast<const DisplayListHeader *>(base);
+  const DisplayListHeader &h = *m_header;
+  if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+    return fail("not a display list");
+  }
+  if (h.byteOrder != kByteOrder) {
+    return fail("display list of another byte order");
+  }
+  if (h.version != kVersion) {
+    return fail("display list version " + to_string(h.version) +
+                " is not supported");
+  }
+
+  // 64 bit sums cannot overflow for 32 bit counts
+  uint64_t offset = sizeof(DisplayListHeader);
+  auto section = [&offset, base](uint64_t count, size_t recordSize) {
+    const char *p = base + offset;
+    offset += count * recordSize;
+    return p;
+  };
+  m_items = reinterpret_cast<const DisplayListRecord *>(
+      section(h.itemCount, sizeof(DisplayListRecord)));
+  m_styles =
+      reinterpret_cast<const Style *>(section(h.styleCount, sizeof(Style)));
+  m_rectangles = reinterpret_cast<const RectangleShape *>(
+      section(h.rectangleCount, sizeof(RectangleShape)));
+  m_texts = reinterpret_cast<const TextShape *>(
+      section(h.textCount, sizeof(TextShape)));
+  m_ellipses = reinterpret_cast<const EllipseShape *>(
+      section(h.ellipseCount, sizeof(EllipseShape)));
+  m_polygons = reinterpret_cast<const PolygonShape *>(
+      section(h.polygonCount, sizeof(PolygonShape)));
+  m_lines = reinterpret_cast<const LineShape *>(
+      section(h.lineCount, sizeof(LineShape)));
+  m_polylines = reinterpret_cast<const PolylineShape *>(
+      section(h.polylineCount, sizeof(PolylineShape)));
+  m_points =
+      reinterpret_cast<const int32_t *>(section(h.pointCount, 2 * 4));
+  m_stringOffsets = reinterpret_cast<const uint32_t *>(
+      section(uint64_t(h.stringCount) + 1, 4));
+  m_stringBytes = section(h.stringBytes, 1);
+  if (offset != m_size) {
+    return fail("display list size does not match its header");
+  }
+
+  // references are checked once here, so the accessors need not
+  uint32_t last = 0;
+  for (uint32_t i = 0; i <= h.stringCount; i++) {
+    uint32_t end = m_stringOffsets[i];
+    if (end < last || end > h.stringBytes ||
+        (i > 0 && (end == last || m_stringBytes[end - 1] != '\0'))) {
+      return fail("bad string table");
+    }
+    last = end;
+  }
+  // copyTo interns the strings, a repeated one would shift the later ids
+  unordered_set<string> strings;
+  for (uint32_t i = 0; i < h.stringCount; i++) {
+    if (!strings.insert(str(static_cast<int>(i))).second) {
+      return fail("repeated string " + to_string(i));
+    }
+  }
+  auto validString = [&h](int id) {
+    return id >= 0 && id < static_cast<int64_t>(h.stringCount);
+  };
+  // the readers check these for -1 before reading them
+  auto validOptionalString = [&validString](int id) {
+    return id == -1 || validString(id);
+  };
+  auto validStyle = [&h](int id) {
+    return id >= 0 && id < static_cast<int64_t>(h.styleCount);
+  };
+  auto validPoints = [&h](int begin, int count) {
+    return begin >= 0 && count >= 0 &&
+           int64_t(begin) + count <= int64_t(h.pointCount);
+  };
+  for (uint32_t i = 0; i < h.styleCount; i++) {
+    const Style &s = m_styles[i];
+    if (!validOptionalString(s.fillColor) || !validString(s.strokeColor) ||
+        !validString(s.strokeDasharray) || !validOptionalString(s.fillRule)) {
+      return fail("bad style " + to_string(i));
+    }
+  }
+
+  const uint32_t counts[] = {h.rectangleCount, h.textCount,
+                             h.ellipseCount,   h.polygonCount,
+                             h.lineCount,      h.polylineCount};
+  for (uint32_t i = 0; i < h.itemCount; i++) {
+    const DisplayListRecord &r = m_items[i];
+    if (r.type < 0 || r.type > static_cast<int>(ShapeType::Polyline) ||
+        r.index < 0 || uint32_t(r.index) >= counts[r.type] ||
+        r.instance < -1) {
+      return fail("bad item " + to_string(i));
+    }
+  }
+  for (uint32_t i = 0; i < h.rectangleCount; i++) {
+    if (!validStyle(m_rectangles[i].style)) {
+      return fail("bad rectangle " + to_string(i));
+    }
+  }
+  for (uint32_t i = 0; i < h.textCount; i++) {
+    if (!validString(m_texts[i].text)) {
+      return fail("bad text " + to_string(i));
+    }
+  }
+  for (uint32_t i = 0; i < h.ellipseCount; i++) {
+    if (!validStyle(m_ellipses[i].style)) {
+      return fail("bad ellipse " + to_string(i));
+    }
+  }
+  for (uint32_t i = 0; i < h.polygonCount; i++) {
+    const PolygonShape &s = m_polygons[i];
+    if (!validStyle(s.style) || !validPoints(s.pointBegin, s.pointCount)) {
+      return fail("bad polygon " + to_string(i));
+    }
+  }
+  for (uint32_t i = 0; i < h.lineCount; i++) {
+    if (!validStyle(m_lines[i].style)) {
+      return fail("bad line " + to_string(i));
+    }
+  }
+  for (uint32_t i = 0; i < h.polylineCount; i++) {
+    const PolylineShape &s = m_polylines[i];
+    if (!validStyle(s.style) || !validPoints(s.pointBegin, s.pointCount)) {
+      return fail("bad polyline " + to_string(i));
+    }
+  }
+  return true;
+}
+
+bool DisplayListFile::fail(const string &error) {
+  m_error = error;
+  return false;
+}
+
+}  // namespace draw
+}  // namespace rectangle
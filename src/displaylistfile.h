@@ -0,0 +1,151 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "displaylist.h"
+#include "outputsink.h"
+
+namespace rectangle {
+namespace draw {
+
+// Binary form of a display list. Every field is a 32 bit word in the byte
+// order of the writer, the sections follow the header in this order:
+//   items, styles, rectangles, texts, ellipses, polygons, lines,
+//   polylines, points, string offsets (stringCount + 1), string bytes
+// Style, shape and point records have the layout of the DisplayList
+// structs, so a mapped file is read in place. Strings are terminated by
+// '\0' and the offsets point into the string bytes.
+struct DisplayListHeader {
+  char magic[4];
+  uint32_t byteOrder;
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  uint32_t itemCount;
+  uint32_t styleCount;
+  uint32_t rectangleCount;
+  uint32_t textCount;
+  uint32_t ellipseCount;
+  uint32_t polygonCount;
+  uint32_t lineCount;
+  uint32_t polylineCount;
+  uint32_t pointCount;
+  uint32_t stringCount;
+  uint32_t stringBytes;
+};
+
+struct DisplayListRecord {
+  int32_t type;
+  int32_t index;
+  int32_t instance;
+};
+
+// Read only view of a display list file mapped into memory.
+class DisplayListFile {
+ public:
+  static const char kMagic[4];
+  static const uint32_t kByteOrder = 0x01020304;
+  static const uint32_t kVersion = 1;
+
+  // width and height are the size of the scene including the margins
+  static void write(util::OutputSink &sink, const DisplayList &list,
+                    int width, int height);
+
+ public:
+  DisplayListFile();
+  ~DisplayListFile();
+  DisplayListFile(const DisplayListFile &) = delete;
+  DisplayListFile &operator=(const DisplayListFile &) = delete;
+
+  // false if the file cannot be mapped or is no valid display list of
+  // this version, see error()
+  bool open(const std::string &path);
+  void close();
+  const std::string &error() const;
+
+  int width() const { return m_header->width; }
+  int height() const { return m_header->height; }
+  int itemCount() const { return static_cast<int>(m_header->itemCount); }
+  const DisplayListRecord &item(int i) const {
+    return m_items[static_cast<size_t>(i)];
+  }
+  const Style &style(int id) const {
+    return m_styles[static_cast<size_t>(id)];
+  }
+  const RectangleShape &rectangle(int index) const {
+    return m_rectangles[static_cast<size_t>(index)];
+  }
+  const TextShape &text(int index) const {
+    return m_texts[static_cast<size_t>(index)];
+  }
+  const EllipseShape &ellipse(int index) const {
+    return m_ellipses[static_cast<size_t>(index)];
+  }
+  const PolygonShape &polygon(int index) const {
+    return m_polygons[static_cast<size_t>(index)];
+  }
+  const LineShape &line(int index) const {
+    return m_lines[static_cast<size_t>(index)];
+  }
+  const PolylineShape &polyline(int index) const {
+    return m_polylines[static_cast<size_t>(index)];
+  }
+  // x0, y0, x1, y1, ...
+  const int32_t *points(int pointBegin) const {
+    return m_points + 2 * static_cast<size_t>(pointBegin);
+  }
+  int stringCount() const { return static_cast<int>(m_header->stringCount); }
+  const char *str(int id) const {
+    return m_stringBytes + m_stringOffsets[static_cast<size_t>(id)];
+  }
+
+  // copy into list, e.g. to generate svg through SvgPainter
+  void copyTo(DisplayList &list) const;
+
+ private:
+  bool map(const std::string &path);
+  bool validate();
+  bool fail(const std::string &error);
+
+ private:
+  void *m_data = nullptr;
+  size_t m_size = 0;
+  std::string m_error;
+
+  const DisplayListHeader *m_header = nullptr;
+  const DisplayListRecord *m_items = nullptr;
+  const Style *m_styles = nullptr;
+  const RectangleShape *m_rectangles = nullptr;
+  const TextShape *m_texts = nullptr;
+  const EllipseShape *m_ellipses = nullptr;
+  const PolygonShape *m_polygons = nullptr;
+  const LineShape *m_lines = nullptr;
+  const PolylineShape *m_polylines = nullptr;
+  const int32_t *m_points = nullptr;
+  const uint32_t *m_stringOffsets = nullptr;
+  const char *m_stringBytes = nullptr;
+};
+
+}  // namespace draw
+}  // namespace rectangle
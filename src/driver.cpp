@@ -24,13 +24,19 @@
 #include "asmtext.h"
 #include "asmvisitor.h"
 #include "ast.h"
+#include "displaylistfile.h"
 #include "dumpvisitor.h"
 #include "errorprinter.h"
 #include "exception.h"
 #include "lexer.h"
+#include "option.h"
 #include "parser.h"
+#include "rasterizer.h"
 #include "sourcefile.h"
 #include "symbolvisitor.h"
+#include "threadpool.h"
+#include "tiledsvgwriter.h"
+#include "tilerenderer.h"
 #include "util.h"
 
 using namespace std;
@@ -43,88 +49,333 @@ using namespace rectangle::util;
 namespace rectangle {
 namespace driver {
 
-Driver::Driver() {}
+Driver::Driver() : Driver(Options::fromGlobals()) {}
+
+Driver::Driver(const Options &options) : m_options(options) {
+  m_phases.setEnabled(m_options.timePhases);
+}
+
+const Options &Driver::options() const { return m_options; }
 
 string Driver::compile(const vector<string> &paths) {
-  map<string, SourceFile> path2file;
+  unique_ptr<AsmBin> bin = build(paths);
+  if (!bin) {
+    return "";
+  }
+
+  AsmMachine machine(m_options);
+  {
+    ScopedPhase phase(&m_phases, "run");
+    render(*bin, machine);
+  }
+
+  ScopedPhase phase(&m_phases, "output");
+  return machine.painter().generate();
+}
+
+bool Driver::compile(const vector<string> &paths, OutputSink &sink) {
+  unique_ptr<AsmBin> bin = build(paths);
+  if (!bin) {
+    return false;
+  }
+  return run(*bin, sink);
+}
+
+bool Driver::run(const AsmBin &bin, OutputSink &sink) {
+  AsmMachine machine(m_options);
+  {
+    ScopedPhase phase(&m_phases, "run");
+    render(bin, machine);
+  }
+
+  ScopedPhase phase(&m_phases, "output");
+  const draw::SvgPainter &painter = machine.painter();
+  unique_ptr<ThreadPool> ownPool;
+  auto pool = [this, &ownPool]() -> ThreadPool & {
+    if (m_pool) {
+      return *m_pool;
+    }
+    ownPool.reset(new ThreadPool);
+    return *ownPool;
+  };
+  if (m_options.tiles.size()) {
+    draw::TiledSvgWriter writer(m_options.tileSize, m_options.tileLevels);
+    if (!writer.write(painter, m_options.tiles, pool())) {
+      return false;
+    }
+    fprintf(stderr, "info: wrote %d tiles to %s\n", writer.tileCount(),
+            m_options.tiles.c_str());
+  } else if (m_options.format == "displaylist") {
+    draw::DisplayListFile::write(sink, painter.displayList(), painter.width(),
+                                 painter.height());
+  } else if (m_options.format == "ppm" || m_options.format == "png") {
+    draw::Image image(painter.width(), painter.height());
+    if (m_options.parallelRaster) {
+      draw::TileRenderer().render(painter.displayList(), image, pool());
+    } else {
+      draw::Rasterizer(image).draw(painter.displayList());
+    }
+    if (m_options.format == "ppm") {
+      image.writePpm(sink);
+    } else {
+      image.writePng(sink);
+    }
+  } else {
+    painter.generate(sink);
+  }
+
+  return true;
+}
+
+void Driver::render(const AsmBin &bin, AsmMachine &machine) {
+  draw::SvgPainter &painter = machine.painter();
+  if (m_options.traceVm) {
+    machine.setTraceWriter(m_trace);
+  }
+  if (m_options.profileVm) {
+    m_profiler.clear();
+    machine.setProfiler(&m_profiler);
+  }
+  if (m_options.cssStyles) {
+    painter.setStyleMode(draw::SvgPainter::StyleMode::Class);
+  }
+  painter.setUseSymbols(m_options.useSymbols);
+
+  machine.execute(bin, "main");
+  if (m_options.profileVm) {
+    m_profiler.resolveLines(bin);
+  }
+
+  if (m_options.cullOffscreen) {
+    int culled = painter.cullOutsideScene();
+    fprintf(stderr, "info: culled %d shapes outside the scene\n", culled);
+  }
+  if (m_options.cullOccluded) {
+    int culled = painter.cullOccluded();
+    fprintf(stderr, "info: culled %d occluded shapes\n", culled);
+  }
+}
+
+const PhaseTimer &Driver::phases() const { return m_phases; }
+
+const VmProfiler &Driver::profiler() const { return m_profiler; }
+
+void Driver::setThreadPool(ThreadPool *pool) { m_pool = pool; }
+
+void Driver::setTraceWriter(TraceWriter *trace) {
+  m_trace = trace;
+  m_phases.setTraceWriter(trace);
+  if (trace) {
+    m_phases.setEnabled(true);
+  }
+}
+
+const string &Driver::error() const { return m_error; }
+
+void Driver::setPrintErrors(bool print) { m_printErrors = print; }
+
+unique_ptr<AsmBin> Driver::build(const vector<string> &paths) {
+  m_phases.clear();
+  m_error.clear();
+  vector<SourceFile> files;
   for (auto &path : paths) {
-    path2file[path] = SourceFile(path);
-    if (!path2file[path].valid()) {
-      fprintf(stderr, "error: open %s failed\n", path.c_str());
-      return "";
+    ScopedPhase phase(&m_phases, "read", path);
+    files.emplace_back(path);
+    if (!files.back().valid()) {
+      fail("open " + path + " failed");
+      return nullptr;
+    }
+  }
+  return buildFiles(files);
+}
+
+unique_ptr<AsmBin> Driver::build(const vector<SourceFile> &files) {
+  m_phases.clear();
+  m_error.clear();
+  return buildFiles(files);
+}
+
+unique_ptr<Module> Driver::load(const vector<SourceFile> &files) {
+  m_phases.clear();
+  m_error.clear();
+
+  unique_ptr<AST> ast(new AST);
+  if (!parse(files, *ast)) {
+    return nullptr;
+  }
+  for (auto doc : ast->documents()) {
+    if (doc->type == DocumentDecl::Type::Instance) {
+      fail(doc->filepath + " is an instance document");
+      return nullptr;
+    }
+  }
+
+  AsmText txt;
+  AsmVisitor av;
+  try {
+    {
+      ScopedPhase phase(&m_phases, "symbol");
+      SymbolVisitor(m_options).visitDefinations(ast.get());
+    }
+    ScopedPhase phase(&m_phases, "asm");
+    txt = av.visitDefinations(ast.get());
+  } catch (SyntaxError &e) {
+    fail(files, e);
+    return nullptr;
+  }
+
+  return unique_ptr<Module>(
+      new Module(files, move(ast), txt, av.labelCounter()));
+}
+
+shared_ptr<const AsmBin> Driver::build(Module &module,
+                                       const SourceFile &instance) {
+  m_phases.clear();
+  m_error.clear();
+
+  string key = instance.path() + '\n' + instance.source();
+  shared_ptr<const AsmBin> bin = module.cached(key);
+  if (bin) {
+    return bin;
+  }
+
+  AST ast;
+  if (!parse(vector<SourceFile>(1, instance), ast)) {
+    return nullptr;
+  }
+  vector<DocumentDecl *> documents = ast.documents();
+  ComponentInstanceDecl *cid =
+      dynamic_cast<ComponentInstanceDecl *>(documents.front());
+  if (cid == nullptr) {
+    fail(instance.path() + " is not an instance document");
+    return nullptr;
+  }
+
+  // scopes of the instance, on top of the shared ones of the module
+  SymbolTable table(module.globalScope());
+  AsmText txt = module.text();
+  try {
+    {
+      ScopedPhase phase(&m_phases, "symbol");
+      SymbolVisitor(m_options).visitInstance(cid, &table);
     }
+    ScopedPhase phase(&m_phases, "asm");
+    AsmVisitor av;
+    av.setLabelCounter(module.labelCounter());
+    txt.append(av.visitInstance(cid));
+  } catch (SyntaxError &e) {
+    vector<SourceFile> files = module.files();
+    files.push_back(instance);
+    fail(files, e);
+    return nullptr;
   }
 
+  {
+    ScopedPhase phase(&m_phases, "assemble");
+    bin = make_shared<const AsmBin>(txt, m_options);
+  }
+  module.cache(key, bin);
+  return bin;
+}
+
+unique_ptr<AsmBin> Driver::buildFiles(const vector<SourceFile> &files) {
   AST ast;
+  if (!parse(files, ast)) {
+    return nullptr;
+  }
+
+  AsmText txt;
+  try {
+    {
+      ScopedPhase phase(&m_phases, "symbol");
+      SymbolVisitor(m_options).visit(&ast);
+    }
+    ScopedPhase phase(&m_phases, "asm");
+    txt = AsmVisitor().visit(&ast);
+  } catch (SyntaxError &e) {
+    fail(files, e);
+    return nullptr;
+  }
+
+  if (m_options.dumpAsm) {
+    txt.dump();
+  }
+
+  unique_ptr<AsmBin> bin;
+  {
+    ScopedPhase phase(&m_phases, "assemble");
+    bin.reset(new AsmBin(txt, m_options));
+  }
+  if (m_options.dumpBytecode) {
+    bin->dump();
+  }
+
+  return bin;
+}
+
+bool Driver::parse(const vector<SourceFile> &files, AST &ast) {
+  // documents are added in path order
+  map<string, const SourceFile *> path2file;
+  for (auto &f : files) {
+    path2file[f.path()] = &f;
+  }
+
   for (auto &pair : path2file) {
-    SourceFile &sc = pair.second;
+    const SourceFile &sc = *pair.second;
+    ScopedTrace fileTrace(m_trace, sc.path(), "file", sc.path());
     string code = sc.source();
 
     vector<rectangle::frontend::Token> tokens;
     try {
+      ScopedPhase phase(&m_phases, "lex", sc.path());
       tokens = Lexer().scan(code);
     } catch (SyntaxError &e) {
-      printSyntaxError(sc, e);
-      return "";
+      fail(sc, e);
+      return false;
     }
 
     unique_ptr<DocumentDecl> document;
     try {
-      document = Parser().parse(tokens);
+      ScopedPhase phase(&m_phases, "parse", sc.path());
+      document = Parser(m_options).parse(tokens);
     } catch (SyntaxError &e) {
-      printSyntaxError(sc, e);
-      return "";
+      fail(sc, e);
+      return false;
     }
     document->filepath = sc.path();
 
     ast.addDocument(move(document));
   }
 
-  if (option::dumpAst) {
+  if (m_options.dumpAst) {
     DumpVisitor dv;
     dv.visit(&ast);
   }
+  return true;
+}
 
-  SymbolVisitor sv;
-  try {
-    sv.visit(&ast);
-  } catch (SyntaxError &e) {
-    auto iter = path2file.find(e.path());
-    if (iter == path2file.end()) {
-      fprintf(stderr, "error: %s\n", e.what());
-    } else {
-      printSyntaxError(iter->second, e);
-    }
-    return "";
-  }
-
-  AsmText txt;
-  try {
-    AsmVisitor av;
-    txt = av.visit(&ast);
-  } catch (SyntaxError &e) {
-    auto iter = path2file.find(e.path());
-    if (iter == path2file.end()) {
-      fprintf(stderr, "error: %s\n", e.what());
-    } else {
-      printSyntaxError(iter->second, e);
-    }
-    return "";
+void Driver::fail(const string &msg) {
+  m_error = "error: " + msg + "\n";
+  if (m_printErrors) {
+    fputs(m_error.c_str(), stderr);
   }
+}
 
-  if (option::dumpAsm) {
-    txt.dump();
+void Driver::fail(const SourceFile &sc, const SyntaxError &e) {
+  m_error = syntaxErrorString(sc, e);
+  if (m_printErrors) {
+    printSyntaxError(sc, e);
   }
+}
 
-  AsmBin bin(txt);
-  if (option::dumpBytecode) {
-    bin.dump();
+void Driver::fail(const vector<SourceFile> &files, const SyntaxError &e) {
+  for (auto &f : files) {
+    if (f.path() == e.path()) {
+      fail(f, e);
+      return;
+    }
   }
-
-  AsmMachine machine;
-  string svg = machine.run(bin, "main");
-
-  return svg;
+  fail(e.what());
 }
 
 }  // namespace driver
@@ -17,17 +17,93 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "asmbin.h"
+#include "module.h"
+#include "option.h"
+#include "outputsink.h"
+#include "phasetimer.h"
+#include "vmprofiler.h"
+
 namespace rectangle {
+namespace diag {
+class SyntaxError;
+}
+namespace util {
+class ThreadPool;
+}
+namespace runtime {
+class AsmMachine;
+}
+
 namespace driver {
 
+// A Driver only reads its own Options, so drivers may compile on several
+// threads at once. One Driver is not meant to be shared between threads.
 class Driver {
  public:
+  // with the options parsed from the command line
   Driver();
+  explicit Driver(const Options &options);
+
+  const Options &options() const;
 
   std::string compile(const std::vector<std::string> &paths);
+  bool compile(const std::vector<std::string> &paths, util::OutputSink &sink);
+  // compile without running, nullptr if there is any error
+  std::unique_ptr<backend::AsmBin> build(const std::vector<std::string> &paths);
+  std::unique_ptr<backend::AsmBin> build(
+      const std::vector<frontend::SourceFile> &files);
+  // run bin and write the output as compile() does
+  bool run(const backend::AsmBin &bin, util::OutputSink &sink);
+
+  // compile the struct and component documents of files, nullptr if there
+  // is any error
+  std::unique_ptr<Module> load(const std::vector<frontend::SourceFile> &files);
+  // build the instance document against module, the bin of an earlier build
+  // of the same source is reused
+  std::shared_ptr<const backend::AsmBin> build(
+      Module &module, const frontend::SourceFile &instance);
+
+  // message of the last error, which is also printed to stderr unless
+  // disabled here
+  const std::string &error() const;
+  void setPrintErrors(bool print);
+
+  // phases of the last compile or build, measured with --time-phases
+  const util::PhaseTimer &phases() const;
+  // phases, files and with --trace-vm the vm calls are written to trace
+  void setTraceWriter(util::TraceWriter *trace);
+  // the vm of the last compile, counted with --profile-vm
+  const runtime::VmProfiler &profiler() const;
+  // tiles and parallel raster run on pool, which may also run the caller,
+  // instead of a pool created for each output
+  void setThreadPool(util::ThreadPool *pool);
+
+ private:
+  // run main of bin and apply the painter options
+  void render(const backend::AsmBin &bin, runtime::AsmMachine &machine);
+  std::unique_ptr<backend::AsmBin> buildFiles(
+      const std::vector<frontend::SourceFile> &files);
+  // lex and parse files into ast, false if there is any error
+  bool parse(const std::vector<frontend::SourceFile> &files, AST &ast);
+  void fail(const std::string &msg);
+  void fail(const frontend::SourceFile &sc, const diag::SyntaxError &e);
+  // e located in files, or in none of them
+  void fail(const std::vector<frontend::SourceFile> &files,
+            const diag::SyntaxError &e);
+
+ private:
+  Options m_options;
+  util::PhaseTimer m_phases;
+  util::TraceWriter *m_trace = nullptr;
+  util::ThreadPool *m_pool = nullptr;
+  runtime::VmProfiler m_profiler;
+  std::string m_error;
+  bool m_printErrors = true;
 };
 
 }  // namespace driver
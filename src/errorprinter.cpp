@@ -25,11 +25,17 @@ namespace rectangle {
 namespace diag {
 
 void printSyntaxError(const frontend::SourceFile &sc, const SyntaxError &e) {
-  static const char *COLOR_PREFIX = "\033[40;31m";
-  static const char *COLOR_SUFFIX = "\033[0m";
+  fputs(syntaxErrorString(sc, e, true).c_str(), stderr);
+}
+
+string syntaxErrorString(const frontend::SourceFile &sc, const SyntaxError &e,
+                         bool color) {
+  const string colorPrefix = color ? "\033[40;31m" : "";
+  const string colorSuffix = color ? "\033[0m" : "";
 
-  fprintf(stderr, "%s:%d:%d: %serror%s: %s\n", sc.path().c_str(), e.line(),
-          e.column(), COLOR_PREFIX, COLOR_SUFFIX, e.msg().c_str());
+  string result = sc.path() + ":" + to_string(e.line()) + ":" +
+                  to_string(e.column()) + ": " + colorPrefix + "error" +
+                  colorSuffix + ": " + e.msg() + "\n";
 
   const size_t tokenBegin = static_cast<size_t>(e.column()) - 1;
   const size_t tokenEnd =
@@ -41,11 +47,11 @@ void printSyntaxError(const frontend::SourceFile &sc, const SyntaxError &e) {
   string mid = line.substr(tokenBegin, tokenEnd - tokenBegin);
   string right = line.substr(tokenEnd);
 
-  fprintf(stderr, "%s%s%s%s%s\n", left.c_str(), COLOR_PREFIX, mid.c_str(),
-          COLOR_SUFFIX, right.c_str());
+  result += left + colorPrefix + mid + colorSuffix + right + "\n";
 
   string indicator = string(static_cast<size_t>(e.column() - 1), ' ') + '^';
-  fprintf(stderr, "%s%s%s\n", COLOR_PREFIX, indicator.c_str(), COLOR_SUFFIX);
+  result += colorPrefix + indicator + colorSuffix + "\n";
+  return result;
 }
 
 }  // namespace diag
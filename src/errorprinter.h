@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "exception.h"
 #include "sourcefile.h"
 
@@ -24,6 +26,10 @@ namespace rectangle {
 namespace diag {
 
 void printSyntaxError(const frontend::SourceFile &sc, const SyntaxError &e);
+// the message printSyntaxError() prints, with the error token highlighted
+// if color is set
+std::string syntaxErrorString(const frontend::SourceFile &sc,
+                              const SyntaxError &e, bool color = false);
 
 }
 }  // namespace rectangle
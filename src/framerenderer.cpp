@@ -0,0 +1,209 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "framerenderer.h"
+
+#include <assert.h>
+
+using namespace std;
+using namespace rectangle::backend;
+
+namespace rectangle {
+namespace runtime {
+
+static string bindingKey(const string &instanceId, const string &name) {
+  return instanceId + "." + name;
+}
+
+FrameRenderer::FrameRenderer(const AsmBin &bin)
+    : m_bindings(bin.bindings()), m_instances(bin.instances()) {
+  assert(m_bindings.size() > 0 && m_instances.size() > 0);
+
+  m_dependents.resize(m_bindings.size());
+  for (size_t i = 0; i < m_bindings.size(); i++) {
+    const AsmBin::BindingItem &b = m_bindings[i];
+    assert(b.endAddr != -1);
+    for (int dep : b.deps) {
+      m_dependents[static_cast<size_t>(dep)].push_back(static_cast<int>(i));
+    }
+    const AsmBin::InstanceItem &instance =
+        m_instances[static_cast<size_t>(b.instance)];
+    m_id2binding[bindingKey(instance.id, b.name)] = static_cast<int>(i);
+  }
+
+  // everything before the first binding creates the instance structs
+  m_machine.enter(bin, "main");
+  m_machine.runRange(bin.getFunction("main").addr, m_bindings.front().addr);
+
+  for (size_t i = 0; i < m_bindings.size(); i++) {
+    m_dirtyBindings.insert(static_cast<int>(i));
+  }
+}
+
+bool FrameRenderer::setProperty(const string &instanceId, const string &name,
+                                const Object &value) {
+  int index = bindingIndex(instanceId, name);
+  if (index == -1) {
+    return false;
+  }
+
+  const AsmBin::BindingItem &b = m_bindings[static_cast<size_t>(index)];
+  const Object &cur = m_machine.local(b.instance).field(b.field);
+  if (cur.category() != Object::Category::Invalid &&
+      cur.category() != value.category()) {
+    return false;
+  }
+
+  m_pinnedValues[index] = value;
+
+  vector<int> pending(1, index);
+  while (!pending.empty()) {
+    int binding = pending.back();
+    pending.pop_back();
+    if (m_dirtyBindings.insert(binding).second ||
+        binding == index) {
+      for (int dependent : m_dependents[static_cast<size_t>(binding)]) {
+        pending.push_back(dependent);
+      }
+    }
+  }
+  return true;
+}
+
+Object FrameRenderer::property(const string &instanceId, const string &name) {
+  int index = bindingIndex(instanceId, name);
+  if (index == -1) {
+    return Object();
+  }
+  const AsmBin::BindingItem &b = m_bindings[static_cast<size_t>(index)];
+  return m_machine.local(b.instance).field(b.field);
+}
+
+string FrameRenderer::render() {
+  m_evaluatedBindings = 0;
+  m_redrawnInstances = 0;
+
+  // bindings are stored in topological order
+  set<int> changedOrigins;
+  for (int binding : m_dirtyBindings) {
+    evaluate(binding);
+    const AsmBin::BindingItem &b = m_bindings[static_cast<size_t>(binding)];
+    m_dirtyInstances.insert(b.instance);
+    if (b.field == 0 || b.field == 1) {
+      changedOrigins.insert(b.instance);
+    }
+  }
+  m_dirtyBindings.clear();
+
+  // instances are in pre-order, so parents are visited before children
+  for (auto &instance : m_instances) {
+    if (instance.parent != -1 && changedOrigins.count(instance.parent)) {
+      changedOrigins.insert(instance.index);
+      m_dirtyInstances.insert(instance.index);
+    }
+  }
+
+  redraw(m_dirtyInstances);
+  m_dirtyInstances.clear();
+  m_shapeIndex.reset();
+
+  return m_machine.painter().generate();
+}
+
+string FrameRenderer::instanceAt(int x, int y) {
+  int instance = shapeIndex().instanceAt(x, y);
+  if (instance < 0) {
+    return string();
+  }
+  return m_instances[static_cast<size_t>(instance)].id;
+}
+
+vector<string> FrameRenderer::instancesIn(const draw::Rect &r) {
+  const draw::DisplayList &list = m_machine.painter().displayList();
+  vector<string> ids;
+  vector<bool> seen(m_instances.size(), false);
+  for (int item : shapeIndex().itemsIn(r)) {
+    int instance = list.items()[static_cast<size_t>(item)].instance;
+    if (instance >= 0 && !seen[static_cast<size_t>(instance)]) {
+      seen[static_cast<size_t>(instance)] = true;
+      ids.push_back(m_instances[static_cast<size_t>(instance)].id);
+    }
+  }
+  return ids;
+}
+
+int FrameRenderer::evaluatedBindings() const { return m_evaluatedBindings; }
+
+int FrameRenderer::redrawnInstances() const { return m_redrawnInstances; }
+
+int FrameRenderer::bindingIndex(const string &instanceId,
+                                const string &name) const {
+  auto iter = m_id2binding.find(bindingKey(instanceId, name));
+  return iter == m_id2binding.end() ? -1 : iter->second;
+}
+
+const draw::ShapeIndex &FrameRenderer::shapeIndex() {
+  // built on the first query after a render, the list is stable until then
+  if (!m_shapeIndex) {
+    m_shapeIndex.reset(
+        new draw::ShapeIndex(m_machine.painter().displayList()));
+  }
+  return *m_shapeIndex;
+}
+
+void FrameRenderer::evaluate(int binding) {
+  const AsmBin::BindingItem &b = m_bindings[static_cast<size_t>(binding)];
+  auto iter = m_pinnedValues.find(binding);
+  if (iter != m_pinnedValues.end()) {
+    m_machine.local(b.instance).field(b.field) = iter->second;
+  } else {
+    m_machine.runRange(b.addr, b.endAddr);
+  }
+  m_evaluatedBindings++;
+}
+
+void FrameRenderer::redraw(const set<int> &instances) {
+  draw::SvgPainter &painter = m_machine.painter();
+  painter.eraseInstances(instances);
+
+  vector<int> originX(m_instances.size(), 0);
+  vector<int> originY(m_instances.size(), 0);
+  for (auto &instance : m_instances) {
+    size_t index = static_cast<size_t>(instance.index);
+    if (instance.parent != -1) {
+      size_t parent = static_cast<size_t>(instance.parent);
+      Object &o = m_machine.local(instance.parent);
+      originX[index] = originX[parent] + o.field(0).intData();
+      originY[index] = originY[parent] + o.field(1).intData();
+    }
+
+    if (instances.count(instance.index) == 0) {
+      continue;
+    }
+    painter.setInstance(instance.index);
+    painter.pushOrigin(originX[index], originY[index]);
+    m_machine.runRange(instance.addr, instance.endAddr);
+    painter.popOrigin();
+    m_redrawnInstances++;
+  }
+  painter.setInstance(-1);
+  painter.sortByInstance();
+}
+
+}  // namespace runtime
+}  // namespace rectangle
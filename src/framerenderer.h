@@ -0,0 +1,81 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "asmbin.h"
+#include "asmmachine.h"
+#include "object.h"
+#include "shapeindex.h"
+
+namespace rectangle {
+namespace runtime {
+
+// Renders many frames of one scene. Setting a property re-evaluates only
+// the bindings depending on it and redraws only the affected instances.
+class FrameRenderer {
+ public:
+  explicit FrameRenderer(const backend::AsmBin &bin);
+
+  // the property keeps the value, its own binding is not evaluated any more
+  bool setProperty(const std::string &instanceId, const std::string &name,
+                   const Object &value);
+  Object property(const std::string &instanceId, const std::string &name);
+
+  std::string render();
+
+  // hit testing on the last rendered frame, in svg coordinates
+  // id of the instance which drew the topmost shape at (x, y), empty if none
+  std::string instanceAt(int x, int y);
+  // ids of the instances drawing inside r, in paint order
+  std::vector<std::string> instancesIn(const draw::Rect &r);
+
+  int evaluatedBindings() const;
+  int redrawnInstances() const;
+
+ private:
+  int bindingIndex(const std::string &instanceId,
+                   const std::string &name) const;
+  void evaluate(int binding);
+  void redraw(const std::set<int> &instances);
+  const draw::ShapeIndex &shapeIndex();
+
+ private:
+  AsmMachine m_machine;
+  std::vector<backend::AsmBin::BindingItem> m_bindings;
+  std::vector<backend::AsmBin::InstanceItem> m_instances;
+  std::vector<std::vector<int>> m_dependents;
+  std::map<std::string, int> m_id2binding;
+  std::unique_ptr<draw::ShapeIndex> m_shapeIndex;
+
+  std::map<int, Object> m_pinnedValues;
+  std::set<int> m_dirtyBindings;
+  std::set<int> m_dirtyInstances;
+
+  int m_evaluatedBindings = 0;
+  int m_redrawnInstances = 0;
+};
+
+}  // namespace runtime
+}  // namespace rectangle
@@ -0,0 +1,82 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "gridindex.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+GridIndex::GridIndex(const Rect &extent, int columns, int rows)
+    : m_extent(extent),
+      m_columns(max(columns, 1)),
+      m_rows(max(rows, 1)),
+      m_cells(static_cast<size_t>(m_columns * m_rows)) {
+  if (m_extent.right <= m_extent.left) {
+    m_extent.right = m_extent.left + 1;
+  }
+  if (m_extent.bottom <= m_extent.top) {
+    m_extent.bottom = m_extent.top + 1;
+  }
+}
+
+void GridIndex::insert(const Rect &r, int id) {
+  int right = column(r.right - 1);
+  int bottom = row(r.bottom - 1);
+  for (int y = row(r.top); y <= bottom; y++) {
+    for (int x = column(r.left); x <= right; x++) {
+      m_cells[static_cast<size_t>(y * m_columns + x)].push_back(id);
+    }
+  }
+}
+
+int GridIndex::cellCount(const Rect &r) const {
+  return (column(r.right - 1) - column(r.left) + 1) *
+         (row(r.bottom - 1) - row(r.top) + 1);
+}
+
+const vector<int> &GridIndex::cell(int x, int y) const {
+  return m_cells[static_cast<size_t>(row(y) * m_columns + column(x))];
+}
+
+int GridIndex::defaultSide(size_t count) {
+  int side = static_cast<int>(sqrt(static_cast<double>(count)));
+  return min(max(side, 1), 256);
+}
+
+int GridIndex::column(int x) const {
+  long long offset = static_cast<long long>(x) - m_extent.left;
+  long long width = static_cast<long long>(m_extent.right) - m_extent.left;
+  long long c = offset * m_columns / width;
+  return static_cast<int>(min(max(c, 0ll), m_columns - 1ll));
+}
+
+int GridIndex::row(int y) const {
+  long long offset = static_cast<long long>(y) - m_extent.top;
+  long long height = static_cast<long long>(m_extent.bottom) - m_extent.top;
+  long long r = offset * m_rows / height;
+  return static_cast<int>(min(max(r, 0ll), m_rows - 1ll));
+}
+
+}  // namespace draw
+}  // namespace rectangle
@@ -0,0 +1,72 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+#include "displaylist.h"
+
+namespace rectangle {
+namespace draw {
+
+// Uniform grid over extent. Every cell lists the ids of the rects
+// overlapping it, rects outside extent are kept in the border cells.
+class GridIndex {
+ public:
+  GridIndex(const Rect &extent, int columns, int rows);
+
+  void insert(const Rect &r, int id);
+  // cells insert(r) adds an id to
+  int cellCount(const Rect &r) const;
+  // ids of the rects which may contain (x, y)
+  const std::vector<int> &cell(int x, int y) const;
+  // calls f(id) for the rects which may intersect r, an id may be passed
+  // more than once
+  template <typename F>
+  void forEach(const Rect &r, F f) const;
+
+  // columns and rows for count rects spread over the extent
+  static int defaultSide(size_t count);
+
+ private:
+  int column(int x) const;
+  int row(int y) const;
+
+ private:
+  Rect m_extent;
+  int m_columns;
+  int m_rows;
+  std::vector<std::vector<int>> m_cells;
+};
+
+template <typename F>
+void GridIndex::forEach(const Rect &r, F f) const {
+  int right = column(r.right - 1);
+  int bottom = row(r.bottom - 1);
+  for (int y = row(r.top); y <= bottom; y++) {
+    for (int x = column(r.left); x <= right; x++) {
+      for (int id : m_cells[static_cast<size_t>(y * m_columns + x)]) {
+        f(id);
+      }
+    }
+  }
+}
+
+}  // namespace draw
+}  // namespace rectangle
@@ -0,0 +1,97 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "gzipsink.h"
+
+using namespace std;
+
+namespace rectangle {
+namespace util {
+
+// buffers waiting for compression before the producer blocks
+static const size_t kMaxQueuedChunks = 4;
+
+GzipSink::GzipSink(OutputSink &target, int level)
+    : m_target(target), m_deflater(level) {
+  // no name, no mtime, unknown os
+  const char header[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0,
+                           static_cast<char>(level >= 9 ? 2 : 0), '\xff'};
+  m_target.write(header, sizeof(header));
+  m_thread = thread(&GzipSink::compressLoop, this);
+}
+
+GzipSink::~GzipSink() { finish(); }
+
+void GzipSink::finish() {
+  if (m_finished) {
+    return;
+  }
+  flush();
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_finishing = true;
+  }
+  m_cond.notify_all();
+  m_thread.join();
+  m_finished = true;
+
+  string tail;
+  m_deflater.finish(tail);
+  for (uint32_t n : {m_crc, m_inputSize}) {
+    for (int i = 0; i < 4; i++) {
+      tail.push_back(static_cast<char>(n >> (8 * i)));
+    }
+  }
+  m_target.write(tail);
+}
+
+bool GzipSink::writeRaw(const char *data, size_t size) {
+  unique_lock<mutex> lock(m_mutex);
+  m_cond.wait(lock, [this] { return m_chunks.size() < kMaxQueuedChunks; });
+  m_chunks.emplace_back(data, size);
+  lock.unlock();
+  m_cond.notify_all();
+  return true;
+}
+
+void GzipSink::compressLoop() {
+  string out;
+  for (;;) {
+    string chunk;
+    {
+      unique_lock<mutex> lock(m_mutex);
+      m_cond.wait(lock, [this] { return !m_chunks.empty() || m_finishing; });
+      if (m_chunks.empty()) {
+        return;
+      }
+      chunk.swap(m_chunks.front());
+      m_chunks.pop_front();
+    }
+    m_cond.notify_all();
+
+    m_crc = crc32(m_crc, chunk.data(), chunk.size());
+    // the size modulo 2^32, as gzip stores it
+    m_inputSize += static_cast<uint32_t>(chunk.size());
+    out.clear();
+    m_deflater.write(chunk.data(), chunk.size(), out);
+    m_target.write(out);
+  }
+}
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,68 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "deflate.h"
+#include "outputsink.h"
+
+namespace rectangle {
+namespace util {
+
+// Writes everything written to it as a gzip stream to target. The
+// buffers are compressed on a thread of their own while the producer
+// goes on, at most a few buffers wait in between.
+class GzipSink : public OutputSink {
+ public:
+  explicit GzipSink(OutputSink &target, int level = 6);
+  ~GzipSink() override;
+
+  // compresses the rest and writes the gzip trailer, target is not
+  // flushed
+  void finish();
+
+ protected:
+  bool writeRaw(const char *data, size_t size) override;
+
+ private:
+  void compressLoop();
+
+ private:
+  OutputSink &m_target;
+  Deflater m_deflater;
+  uint32_t m_crc = 0;
+  uint32_t m_inputSize = 0;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::deque<std::string> m_chunks;
+  bool m_finishing = false;
+  bool m_finished = false;
+  std::thread m_thread;
+};
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,169 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "image.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <string>
+
+#include "deflate.h"
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+Image::Image(int width, int height)
+    : m_width(max(width, 0)),
+      m_height(max(height, 0)),
+      m_pixels(static_cast<size_t>(m_width) * m_height, 0) {}
+
+uint32_t Image::pack(int r, int g, int b, int a) {
+  // little endian, the bytes in memory are r, g, b, a
+  return static_cast<uint32_t>(r) | static_cast<uint32_t>(g) << 8 |
+         static_cast<uint32_t>(b) << 16 | static_cast<uint32_t>(a) << 24;
+}
+
+int Image::red(uint32_t pixel) { return pixel & 0xff; }
+
+int Image::green(uint32_t pixel) { return pixel >> 8 & 0xff; }
+
+int Image::blue(uint32_t pixel) { return pixel >> 16 & 0xff; }
+
+int Image::alpha(uint32_t pixel) { return pixel >> 24 & 0xff; }
+
+void Image::writePpm(util::OutputSink &sink) const {
+  sink.print("P6\n%d %d\n255\n", m_width, m_height);
+  vector<char> line(static_cast<size_t>(m_width) * 3);
+  for (int y = 0; y < m_height; y++) {
+    const uint32_t *p = row(y);
+    char *out = line.data();
+    for (int x = 0; x < m_width; x++) {
+      int background = 255 - alpha(p[x]);
+      *out++ = static_cast<char>(red(p[x]) + background);
+      *out++ = static_cast<char>(green(p[x]) + background);
+      *out++ = static_cast<char>(blue(p[x]) + background);
+    }
+    sink.write(line.data(), line.size());
+  }
+}
+
+static uint32_t adler32(const string &data) {
+  // 5552 bytes can be summed before the sums may overflow
+  const size_t maxRun = 5552;
+  uint32_t s1 = 1;
+  uint32_t s2 = 0;
+  size_t i = 0;
+  while (i < data.size()) {
+    size_t end = min(data.size(), i + maxRun);
+    for (; i < end; i++) {
+      s1 += static_cast<unsigned char>(data[i]);
+      s2 += s1;
+    }
+    s1 %= 65521;
+    s2 %= 65521;
+  }
+  return s2 << 16 | s1;
+}
+
+static void appendBigEndian(string &out, uint32_t n) {
+  out.push_back(static_cast<char>(n >> 24));
+  out.push_back(static_cast<char>(n >> 16));
+  out.push_back(static_cast<char>(n >> 8));
+  out.push_back(static_cast<char>(n));
+}
+
+static void writeChunk(util::OutputSink &sink, const char *type,
+                       const string &data) {
+  string head;
+  appendBigEndian(head, static_cast<uint32_t>(data.size()));
+  head.append(type, 4);
+  sink.write(head);
+  sink.write(data);
+
+  uint32_t crc = util::crc32(0, type, 4);
+  crc = util::crc32(crc, data.data(), data.size());
+  string tail;
+  appendBigEndian(tail, crc);
+  sink.write(tail);
+}
+
+void Image::writePng(util::OutputSink &sink) const {
+  sink.write("\x89PNG\r\n\x1a\n", 8);
+
+  string header;
+  appendBigEndian(header, static_cast<uint32_t>(m_width));
+  appendBigEndian(header, static_cast<uint32_t>(m_height));
+  header.push_back(8);  // bit depth
+  header.push_back(6);  // rgba
+  header.push_back(0);  // deflate
+  header.push_back(0);  // adaptive filter
+  header.push_back(0);  // no interlace
+  writeChunk(sink, "IHDR", header);
+
+  // every scanline is filter byte 0 followed by unpremultiplied rgba
+  string raw;
+  raw.reserve(static_cast<size_t>(m_height) * (1 + 4 * m_width));
+  for (int y = 0; y < m_height; y++) {
+    raw.push_back(0);
+    const uint32_t *p = row(y);
+    for (int x = 0; x < m_width; x++) {
+      int a = alpha(p[x]);
+      int r = 0;
+      int g = 0;
+      int b = 0;
+      if (a > 0) {
+        r = (red(p[x]) * 255 + a / 2) / a;
+        g = (green(p[x]) * 255 + a / 2) / a;
+        b = (blue(p[x]) * 255 + a / 2) / a;
+      }
+      raw.push_back(static_cast<char>(r));
+      raw.push_back(static_cast<char>(g));
+      raw.push_back(static_cast<char>(b));
+      raw.push_back(static_cast<char>(a));
+    }
+  }
+
+  // zlib stream of stored deflate blocks
+  string data;
+  data.push_back(0x78);
+  data.push_back(0x01);
+  const size_t maxBlock = 65535;
+  size_t offset = 0;
+  do {
+    size_t size = min(maxBlock, raw.size() - offset);
+    bool last = offset + size == raw.size();
+    data.push_back(last ? 1 : 0);
+    data.push_back(static_cast<char>(size & 0xff));
+    data.push_back(static_cast<char>(size >> 8));
+    data.push_back(static_cast<char>(~size & 0xff));
+    data.push_back(static_cast<char>((~size >> 8) & 0xff));
+    data.append(raw, offset, size);
+    offset += size;
+  } while (offset < raw.size());
+
+  appendBigEndian(data, adler32(raw));
+  writeChunk(sink, "IDAT", data);
+
+  writeChunk(sink, "IEND", "");
+}
+
+}  // namespace draw
+}  // namespace rectangle
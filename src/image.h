@@ -0,0 +1,63 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "outputsink.h"
+
+namespace rectangle {
+namespace draw {
+
+// RGBA image, every pixel is stored premultiplied as bytes r, g, b, a
+class Image {
+ public:
+  Image(int width, int height);
+
+  int width() const { return m_width; }
+  int height() const { return m_height; }
+  uint32_t *row(int y) {
+    return m_pixels.data() + static_cast<size_t>(y) * m_width;
+  }
+  const uint32_t *row(int y) const {
+    return m_pixels.data() + static_cast<size_t>(y) * m_width;
+  }
+  uint32_t pixel(int x, int y) const { return row(y)[x]; }
+
+  // binary ppm, composed over white
+  void writePpm(util::OutputSink &sink) const;
+  // rgba png with stored (uncompressed) deflate blocks
+  void writePng(util::OutputSink &sink) const;
+
+  static uint32_t pack(int r, int g, int b, int a);
+  static int red(uint32_t pixel);
+  static int green(uint32_t pixel);
+  static int blue(uint32_t pixel);
+  static int alpha(uint32_t pixel);
+
+ private:
+  int m_width;
+  int m_height;
+  std::vector<uint32_t> m_pixels;
+};
+
+}  // namespace draw
+}  // namespace rectangle
@@ -0,0 +1,145 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "librectangle.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "driver.h"
+#include "option.h"
+#include "outputsink.h"
+#include "sourcefile.h"
+
+using namespace std;
+using namespace rectangle;
+using namespace rectangle::driver;
+using namespace rectangle::frontend;
+
+struct rect_module {
+  Options options;
+  unique_ptr<Module> module;
+};
+
+static thread_local string lastError;
+
+static rect_status fail(rect_status status, const string &msg) {
+  lastError = msg;
+  return status;
+}
+
+static SourceFile sourceFile(const rect_source &source) {
+  string data;
+  if (source.data) {
+    data.assign(source.data, source.size);
+  }
+  return SourceFile(source.path ? source.path : "", data);
+}
+
+int rect_api_version(void) { return RECT_API_VERSION; }
+
+const char *rect_last_error(void) { return lastError.c_str(); }
+
+rect_status rect_module_create(const rect_source *definitions, size_t count,
+                               unsigned flags, rect_module **module) {
+  if (module == nullptr || (definitions == nullptr && count > 0)) {
+    return fail(RECT_ERROR_INVALID_ARGUMENT, "error: invalid argument\n");
+  }
+  *module = nullptr;
+
+  unique_ptr<rect_module> m(new rect_module);
+  m->options.cssStyles = flags & RECT_CSS_STYLES;
+  m->options.useSymbols = flags & RECT_USE_SYMBOLS;
+  m->options.cullOffscreen = flags & RECT_CULL_OFFSCREEN;
+  m->options.cullOccluded = flags & RECT_CULL_OCCLUDED;
+  m->options.parallelAnalyze = flags & RECT_PARALLEL_ANALYZE;
+
+  vector<SourceFile> files;
+  for (size_t i = 0; i < count; i++) {
+    files.push_back(sourceFile(definitions[i]));
+  }
+
+  Driver d(m->options);
+  d.setPrintErrors(false);
+  m->module = d.load(files);
+  if (!m->module) {
+    return fail(RECT_ERROR_COMPILE, d.error());
+  }
+
+  *module = m.release();
+  lastError.clear();
+  return RECT_OK;
+}
+
+void rect_module_free(rect_module *module) { delete module; }
+
+void rect_module_set_cache_capacity(rect_module *module, size_t capacity) {
+  if (module) {
+    module->module->setCacheCapacity(capacity);
+  }
+}
+
+rect_status rect_render(rect_module *module, const rect_source *instance,
+                        rect_format format, char *buffer, size_t capacity,
+                        size_t *size) {
+  if (module == nullptr || instance == nullptr || size == nullptr ||
+      (buffer == nullptr && capacity > 0)) {
+    return fail(RECT_ERROR_INVALID_ARGUMENT, "error: invalid argument\n");
+  }
+  *size = 0;
+
+  Options options = module->options;
+  switch (format) {
+    case RECT_FORMAT_SVG:
+      break;
+    case RECT_FORMAT_PPM:
+      options.format = "ppm";
+      break;
+    case RECT_FORMAT_PNG:
+      options.format = "png";
+      break;
+    case RECT_FORMAT_DISPLAYLIST:
+      options.format = "displaylist";
+      break;
+    default:
+      return fail(RECT_ERROR_INVALID_ARGUMENT, "error: invalid format\n");
+  }
+
+  Driver d(options);
+  d.setPrintErrors(false);
+  shared_ptr<const backend::AsmBin> bin =
+      d.build(*module->module, sourceFile(*instance));
+  if (!bin) {
+    return fail(RECT_ERROR_COMPILE, d.error());
+  }
+
+  util::BufferSink sink(buffer, capacity);
+  if (!d.run(*bin, sink)) {
+    return fail(RECT_ERROR_OUTPUT, d.error());
+  }
+  sink.flush();
+  *size = sink.bytesWritten();
+  if (sink.truncated()) {
+    return fail(RECT_ERROR_BUFFER_TOO_SMALL,
+                "error: output of " + to_string(*size) +
+                    " bytes does not fit the buffer\n");
+  }
+
+  lastError.clear();
+  return RECT_OK;
+}
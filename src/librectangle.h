@@ -0,0 +1,90 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#pragma once
+
+// C API of librectangle. Component definitions are compiled once into a
+// module, then instance documents are rendered against it without starting
+// a process. All functions may be called from several threads, also on the
+// same module.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RECT_API_VERSION 1
+
+typedef enum rect_status {
+  RECT_OK = 0,
+  // a source does not compile, see rect_last_error()
+  RECT_ERROR_COMPILE = 1,
+  // the output did not fit, *size is set to the size needed
+  RECT_ERROR_BUFFER_TOO_SMALL = 2,
+  RECT_ERROR_INVALID_ARGUMENT = 3,
+  RECT_ERROR_OUTPUT = 4
+} rect_status;
+
+typedef enum rect_format {
+  RECT_FORMAT_SVG = 0,
+  RECT_FORMAT_PPM = 1,
+  RECT_FORMAT_PNG = 2,
+  RECT_FORMAT_DISPLAYLIST = 3
+} rect_format;
+
+// flags of rect_module_create()
+#define RECT_CSS_STYLES 0x1u
+#define RECT_USE_SYMBOLS 0x2u
+#define RECT_CULL_OFFSCREEN 0x4u
+#define RECT_CULL_OCCLUDED 0x8u
+#define RECT_PARALLEL_ANALYZE 0x10u
+
+typedef struct rect_source {
+  // used in error messages, definitions are compiled in path order
+  const char *path;
+  const char *data;
+  size_t size;
+} rect_source;
+
+typedef struct rect_module rect_module;
+
+// RECT_API_VERSION of the library, which may differ from the header
+int rect_api_version(void);
+
+// message of the last failed call on this thread, "" if there is none
+const char *rect_last_error(void);
+
+// Compiles the struct and component documents of definitions. The sources
+// are copied, so they may be freed once this returns.
+rect_status rect_module_create(const rect_source *definitions, size_t count,
+                               unsigned flags, rect_module **module);
+void rect_module_free(rect_module *module);
+
+// Compiled instances are kept in the module, up to capacity of them, so
+// rendering an instance again only runs it. The default capacity is 64.
+void rect_module_set_cache_capacity(rect_module *module, size_t capacity);
+
+// Renders instance against module into buffer. *size is set to the size of
+// the output, also when it is larger than capacity.
+rect_status rect_render(rect_module *module, const rect_source *instance,
+                        rect_format format, char *buffer, size_t capacity,
+                        size_t *size);
+
+#ifdef __cplusplus
+}
+#endif
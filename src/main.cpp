@@ -15,14 +15,22 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  ********************************************************************************/
 
+#include <signal.h>
 #include <stdlib.h>
+#include <unistd.h>
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "argsparser.h"
 #include "driver.h"
+#include "gzipsink.h"
 #include "option.h"
+#include "outputsink.h"
+#include "renderserver.h"
+#include "tracewriter.h"
 
 using namespace std;
 using namespace rectangle;
@@ -57,10 +65,78 @@ static vector<string> parseArgs(int argc, char **argv) {
                         option::printBindingDep);
   ap.addOnOffLongOption("print-svg-draw", "Show information in drawing svg",
                         option::printSvgDraw);
+  ap.addOnOffLongOption("parallel-analyze",
+                        "Analyze component definations on all cores",
+                        option::parallelAnalyze);
+  ap.addOnOffLongOption("css-styles",
+                        "Share styles of shapes through css classes",
+                        option::cssStyles);
+  ap.addOnOffLongOption("use-symbols",
+                        "Write instances drawn alike once as a symbol",
+                        option::useSymbols);
+  ap.addOnOffLongOption("cull-offscreen",
+                        "Drop shapes outside the scene and report the count",
+                        option::cullOffscreen);
+  ap.addOnOffLongOption("cull-occluded",
+                        "Drop shapes covered by opaque rectangles and report "
+                        "the count",
+                        option::cullOccluded);
+  ap.addOnOffLongOption("parallel-raster",
+                        "Rasterize ppm and png output in tiles on all cores",
+                        option::parallelRaster);
+  ap.addOnOffLongOption("svgz", "Compress the svg with gzip while writing it",
+                        option::svgz);
+  ap.addOnOffLongOption("time-phases",
+                        "Report time, allocations and peak rss of every "
+                        "compile phase",
+                        option::timePhases);
+  ap.addValueLongOption("time-phases-json",
+                        "Write the phase report as json to a file",
+                        option::timePhasesJson);
+  ap.addValueLongOption("trace-out",
+                        "Write the compile phases as chrome trace events to "
+                        "a file",
+                        option::traceOut);
+  ap.addOnOffLongOption("trace-vm",
+                        "Also trace every function call of the vm with "
+                        "--trace-out",
+                        option::traceVm);
+  ap.addOnOffLongOption("profile-vm",
+                        "Report the time spent in every opcode and function "
+                        "of the vm",
+                        option::profileVm);
+  ap.addValueLongOption("profile-vm-json",
+                        "Write the vm profile as json to a file",
+                        option::profileVmJson);
   ap.addOnOffLongOption("dump-ast", "Dump the ast", option::dumpAst);
   ap.addOnOffLongOption("dump-asm", "Dump the asm source", option::dumpAsm);
   ap.addOnOffLongOption("dump-bytecode", "Dump the bytecode",
                         option::dumpBytecode);
+  ap.addValueLongOption("output", "Write the svg to a file instead of stdout",
+                        option::output);
+  ap.addValueLongOption("format",
+                        "Output format: svg (default), ppm, png or "
+                        "displaylist",
+                        option::format);
+  ap.addValueLongOption("tiles",
+                        "Write the svg as tiles and an index.json into a "
+                        "directory",
+                        option::tiles);
+  ap.addValueLongOption("tile-size", "Side of a tile, 512 by default",
+                        option::tileSize);
+  ap.addValueLongOption("tile-levels",
+                        "Number of resolution levels of the tiles, each "
+                        "halving the scale, 1 by default",
+                        option::tileLevels);
+  ap.addValueLongOption("svgz-level",
+                        "Compression level of --svgz from 0 to 9, 6 by "
+                        "default",
+                        option::svgzLevel);
+  ap.addValueLongOption("serve",
+                        "Keep the definations compiled and render the "
+                        "instances of requests on a unix socket, or on "
+                        "stdin and stdout with -",
+                        option::serve);
   ap.addOnOffLongOption("help", "Show help", option::showHelp);
   ap.addOnOffLongOption("show-opt", "Show option configured", option::showOpt);
   ap.addOnOffLongOption("show-files", "Show input files", option::showFiles);
@@ -75,6 +151,56 @@ static vector<string> parseArgs(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
+  if (option::format.size() && option::format != "svg" &&
+      option::format != "ppm" && option::format != "png" &&
+      option::format != "displaylist") {
+    fprintf(stderr, "Unknown format: %s\n", option::format.c_str());
+    ap.dumpHelp();
+    exit(EXIT_FAILURE);
+  }
+
+  if ((option::tileSize.size() && atoi(option::tileSize.c_str()) <= 0) ||
+      (option::tileLevels.size() &&
+       (atoi(option::tileLevels.c_str()) <= 0 ||
+        atoi(option::tileLevels.c_str()) > 16))) {
+    fprintf(stderr, "Invalid tile size or levels\n");
+    ap.dumpHelp();
+    exit(EXIT_FAILURE);
+  }
+
+  if (option::svgzLevel.size() &&
+      (option::svgzLevel.find_first_not_of("0123456789") != string::npos ||
+       atoi(option::svgzLevel.c_str()) > 9)) {
+    fprintf(stderr, "Invalid svgz level: %s\n", option::svgzLevel.c_str());
+    ap.dumpHelp();
+    exit(EXIT_FAILURE);
+  }
+  if (option::svgz &&
+      ((option::format.size() && option::format != "svg") ||
+       option::tiles.size())) {
+    fprintf(stderr, "--svgz only compresses a single svg\n");
+    ap.dumpHelp();
+    exit(EXIT_FAILURE);
+  }
+
+  if (option::serve.size() &&
+      (option::output.size() || option::tiles.size() || option::svgz)) {
+    fprintf(stderr, "--serve answers on the socket only\n");
+    ap.dumpHelp();
+    exit(EXIT_FAILURE);
+  }
+  // these report on a single compile, or write to stdout
+  if (option::serve.size() &&
+      (option::dumpAst || option::dumpAsm || option::dumpBytecode ||
+       option::timePhases || option::timePhasesJson.size() ||
+       option::traceOut.size() || option::traceVm || option::profileVm ||
+       option::profileVmJson.size())) {
+    fprintf(stderr,
+            "--serve does not dump, time, trace or profile the requests\n");
+    ap.dumpHelp();
+    exit(EXIT_FAILURE);
+  }
+
   if (option::showHelp) {
     ap.dumpHelp();
     exit(EXIT_SUCCESS);
@@ -92,14 +218,133 @@ static vector<string> parseArgs(int argc, char **argv) {
   return files;
 }
 
+// writes a report through write() into the file at path
+static bool writeReport(const string &path,
+                        const function<void(OutputSink &)> &write) {
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp) {
+    fprintf(stderr, "error: open %s failed\n", path.c_str());
+    return false;
+  }
+  bool failed = false;
+  {
+    FileSink sink(fp);
+    write(sink);
+    sink.flush();
+    failed = sink.failed();
+  }
+  if (fclose(fp) != 0 || failed) {
+    fprintf(stderr, "error: write %s failed\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+static bool report(const Driver &d, const TraceWriter &trace) {
+  if (option::timePhases) {
+    d.phases().printReport(stderr);
+  }
+  bool ok = true;
+  auto writePhases = [&d](OutputSink &sink) { d.phases().writeJson(sink); };
+  if (option::timePhasesJson.size() &&
+      !writeReport(option::timePhasesJson, writePhases)) {
+    ok = false;
+  }
+  auto writeTrace = [&trace](OutputSink &sink) { trace.write(sink); };
+  if (option::traceOut.size() && !writeReport(option::traceOut, writeTrace)) {
+    ok = false;
+  }
+  if (option::profileVm) {
+    d.profiler().printReport(stderr);
+  }
+  auto writeProfile = [&d](OutputSink &sink) { d.profiler().writeJson(sink); };
+  if (option::profileVmJson.size() &&
+      !writeReport(option::profileVmJson, writeProfile)) {
+    ok = false;
+  }
+  return ok;
+}
+
+static int serve(const vector<string> &files) {
+  // a client closing its connection early must not end the server
+  signal(SIGPIPE, SIG_IGN);
+
+  RenderServer server(Options::fromGlobals(), files);
+  if (!server.load()) {
+    return EXIT_FAILURE;
+  }
+  bool ok = false;
+  if (option::serve == "-") {
+    // the responses get stdout to themselves, anything else printed there
+    // goes to stderr
+    fflush(stdout);
+    int out = dup(STDOUT_FILENO);
+    if (out < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+      fprintf(stderr, "error: redirect stdout failed\n");
+      return EXIT_FAILURE;
+    }
+    ok = server.serve(STDIN_FILENO, out);
+    close(out);
+  } else {
+    ok = server.listen(option::serve);
+  }
+  return ok ? 0 : EXIT_FAILURE;
+}
+
 int main(int argc, char **argv) {
   auto files = parseArgs(argc, argv);
+  if (option::serve.size()) {
+    return serve(files);
+  }
+
+  FILE *fp = stdout;
+  if (option::output.size()) {
+    fp = fopen(option::output.c_str(), "wb");
+    if (!fp) {
+      fprintf(stderr, "error: open %s failed\n", option::output.c_str());
+      return EXIT_FAILURE;
+    }
+  }
 
-  Driver d;
-  string svg = d.compile(files);
+  bool failed = false;
+  bool reported = true;
+  {
+    FileSink sink(fp);
+    // the svg is compressed on another thread while it is generated
+    unique_ptr<GzipSink> gzip;
+    OutputSink *out = &sink;
+    if (option::svgz) {
+      int level = 6;
+      if (option::svgzLevel.size()) {
+        level = atoi(option::svgzLevel.c_str());
+      }
+      gzip.reset(new GzipSink(sink, level));
+      out = gzip.get();
+    }
+    Driver d;
+    TraceWriter trace;
+    if (option::traceOut.size()) {
+      d.setTraceWriter(&trace);
+    }
+    bool binary = option::format == "ppm" || option::format == "png" ||
+                  option::format == "displaylist";
+    if (d.compile(files, *out) && !binary && option::tiles.empty()) {
+      out->write('\n');
+    }
+    if (gzip) {
+      gzip->finish();
+    }
+    sink.flush();
+    failed = sink.failed();
+    reported = report(d, trace);
+  }
 
-  if (svg.size()) {
-    printf("%s\n", svg.c_str());
+  if (fp != stdout) {
+    fclose(fp);
+  }
+  if (failed) {
+    fprintf(stderr, "error: write output failed\n");
+    return EXIT_FAILURE;
   }
-  return 0;
+  return reported ? 0 : EXIT_FAILURE;
 }
@@ -0,0 +1,96 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "module.h"
+
+#include <assert.h>
+
+using namespace std;
+using namespace rectangle::frontend;
+using namespace rectangle::backend;
+
+namespace rectangle {
+namespace driver {
+
+Module::Module(const vector<SourceFile> &files, unique_ptr<AST> ast,
+               const AsmText &text, int labelCounter)
+    : m_files(files),
+      m_ast(move(ast)),
+      m_text(text),
+      m_labelCounter(labelCounter) {
+  assert(m_ast != nullptr);
+  m_globalScope = m_ast->symbolTable()->curScope();
+}
+
+const vector<SourceFile> &Module::files() const { return m_files; }
+
+const SourceFile *Module::file(const string &path) const {
+  for (auto &f : m_files) {
+    if (f.path() == path) {
+      return &f;
+    }
+  }
+  return nullptr;
+}
+
+Scope *Module::globalScope() const { return m_globalScope; }
+
+const AsmText &Module::text() const { return m_text; }
+
+int Module::labelCounter() const { return m_labelCounter; }
+
+shared_ptr<const AsmBin> Module::cached(const string &key) {
+  lock_guard<mutex> lock(m_cacheMutex);
+  auto iter = m_cacheIndex.find(key);
+  if (iter == m_cacheIndex.end()) {
+    return nullptr;
+  }
+  m_cache.splice(m_cache.begin(), m_cache, iter->second);
+  return iter->second->second;
+}
+
+void Module::cache(const string &key, shared_ptr<const AsmBin> bin) {
+  lock_guard<mutex> lock(m_cacheMutex);
+  auto iter = m_cacheIndex.find(key);
+  if (iter != m_cacheIndex.end()) {
+    m_cache.erase(iter->second);
+  }
+  m_cache.emplace_front(key, bin);
+  m_cacheIndex[key] = m_cache.begin();
+  trimCache();
+}
+
+void Module::setCacheCapacity(size_t capacity) {
+  lock_guard<mutex> lock(m_cacheMutex);
+  m_cacheCapacity = capacity;
+  trimCache();
+}
+
+size_t Module::cacheSize() {
+  lock_guard<mutex> lock(m_cacheMutex);
+  return m_cache.size();
+}
+
+void Module::trimCache() {
+  while (m_cache.size() > m_cacheCapacity) {
+    m_cacheIndex.erase(m_cache.back().first);
+    m_cache.pop_back();
+  }
+}
+
+}  // namespace driver
+}  // namespace rectangle
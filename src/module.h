@@ -0,0 +1,80 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "asmbin.h"
+#include "asmtext.h"
+#include "ast.h"
+#include "sourcefile.h"
+
+namespace rectangle {
+namespace driver {
+
+// Struct and component definations compiled once by Driver::load(). Instance
+// documents are built against them, so a render only pays for its own
+// document and the vm. A Module may be shared by drivers on several threads.
+class Module {
+ public:
+  Module(const std::vector<frontend::SourceFile> &files,
+         std::unique_ptr<AST> ast, const backend::AsmText &text,
+         int labelCounter);
+
+  const std::vector<frontend::SourceFile> &files() const;
+  // nullptr if path is not one of files
+  const frontend::SourceFile *file(const std::string &path) const;
+  // the scope instances are analyzed in
+  backend::Scope *globalScope() const;
+  const backend::AsmText &text() const;
+  int labelCounter() const;
+
+  // bins built from instance sources, the least recently used is dropped
+  // once there are more than capacity
+  std::shared_ptr<const backend::AsmBin> cached(const std::string &key);
+  void cache(const std::string &key,
+             std::shared_ptr<const backend::AsmBin> bin);
+  void setCacheCapacity(size_t capacity);
+  size_t cacheSize();
+
+ private:
+  void trimCache();
+
+ private:
+  typedef std::pair<std::string, std::shared_ptr<const backend::AsmBin>>
+      CacheEntry;
+
+  std::vector<frontend::SourceFile> m_files;
+  std::unique_ptr<AST> m_ast;
+  backend::Scope *m_globalScope = nullptr;
+  backend::AsmText m_text;
+  int m_labelCounter = 0;
+
+  std::mutex m_cacheMutex;
+  size_t m_cacheCapacity = 64;
+  std::list<CacheEntry> m_cache;
+  std::map<std::string, std::list<CacheEntry>::iterator> m_cacheIndex;
+};
+
+}  // namespace driver
+}  // namespace rectangle
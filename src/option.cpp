@@ -17,6 +17,8 @@
 
 #include "option.h"
 
+#include <stdlib.h>
+
 namespace rectangle {
 namespace option {
 
@@ -32,6 +34,17 @@ bool printAssemble = false;
 bool printBindingDep = false;
 bool printSvgDraw = false;
 
+bool parallelAnalyze = false;
+bool cssStyles = false;
+bool useSymbols = false;
+bool cullOffscreen = false;
+bool cullOccluded = false;
+bool parallelRaster = false;
+bool svgz = false;
+bool timePhases = false;
+bool traceVm = false;
+bool profileVm = false;
+
 bool dumpAst = false;
 bool dumpAsm = false;
 bool dumpBytecode = false;
@@ -40,5 +53,55 @@ bool showHelp = false;
 bool showOpt = false;
 bool showFiles = false;
 
+std::string output;
+std::string format;
+std::string tiles;
+std::string tileSize;
+std::string tileLevels;
+std::string svgzLevel;
+std::string timePhasesJson;
+std::string traceOut;
+std::string profileVmJson;
+std::string serve;
+
 }  // namespace option
+
+Options Options::fromGlobals() {
+  Options o;
+  o.printSymbolDef = option::verbose || option::printSymbolDef;
+  o.printSymbolRef = option::verbose || option::printSymbolRef;
+  o.printPropertyDep = option::verbose || option::printPropertyDep;
+  o.printScopeStack = option::verbose || option::printScopeStack;
+  o.printLLTry = option::verbose || option::printLLTry;
+  o.printLocalIndex = option::verbose || option::printLocalIndex;
+  o.printGenAsm = option::verbose || option::printGenAsm;
+  o.printAssemble = option::verbose || option::printAssemble;
+  o.printBindingDep = option::verbose || option::printBindingDep;
+  o.printSvgDraw = option::verbose || option::printSvgDraw;
+
+  o.parallelAnalyze = option::parallelAnalyze;
+  o.cssStyles = option::cssStyles;
+  o.useSymbols = option::useSymbols;
+  o.cullOffscreen = option::cullOffscreen;
+  o.cullOccluded = option::cullOccluded;
+  o.parallelRaster = option::parallelRaster;
+  o.timePhases = option::timePhases || option::timePhasesJson.size();
+  o.traceVm = option::traceVm;
+  o.profileVm = option::profileVm || option::profileVmJson.size();
+
+  o.dumpAst = option::dumpAst;
+  o.dumpAsm = option::dumpAsm;
+  o.dumpBytecode = option::dumpBytecode;
+
+  o.format = option::format;
+  o.tiles = option::tiles;
+  if (option::tileSize.size()) {
+    o.tileSize = atoi(option::tileSize.c_str());
+  }
+  if (option::tileLevels.size()) {
+    o.tileLevels = atoi(option::tileLevels.c_str());
+  }
+  return o;
+}
+
 }  // namespace rectangle
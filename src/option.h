@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <string>
+
 namespace rectangle {
 namespace option {
 
@@ -33,6 +35,17 @@ extern bool printAssemble;
 extern bool printBindingDep;
 extern bool printSvgDraw;
 
+extern bool parallelAnalyze;
+extern bool cssStyles;
+extern bool useSymbols;
+extern bool cullOffscreen;
+extern bool cullOccluded;
+extern bool parallelRaster;
+extern bool svgz;
+extern bool timePhases;
+extern bool traceVm;
+extern bool profileVm;
+
 extern bool dumpAst;
 extern bool dumpAsm;
 extern bool dumpBytecode;
@@ -41,5 +54,61 @@ extern bool showHelp;
 extern bool showOpt;
 extern bool showFiles;
 
+extern std::string output;
+extern std::string format;
+extern std::string tiles;
+extern std::string tileSize;
+extern std::string tileLevels;
+extern std::string svgzLevel;
+extern std::string timePhasesJson;
+extern std::string traceOut;
+extern std::string profileVmJson;
+extern std::string serve;
+
 }  // namespace option
+
+// Settings of one compilation. Driver hands them to the passes it creates,
+// so compilations with different settings may run at the same time. The
+// globals of option above are only the command line parsed by main.
+struct Options {
+  // the globals with --verbose turning on every print flag
+  static Options fromGlobals();
+
+  bool printSymbolDef = false;
+  bool printSymbolRef = false;
+  bool printPropertyDep = false;
+  bool printScopeStack = false;
+  bool printLLTry = false;
+  bool printLocalIndex = false;
+  bool printGenAsm = false;
+  bool printAssemble = false;
+  bool printBindingDep = false;
+  bool printSvgDraw = false;
+
+  bool parallelAnalyze = false;
+  bool cssStyles = false;
+  bool useSymbols = false;
+  bool cullOffscreen = false;
+  bool cullOccluded = false;
+  bool parallelRaster = false;
+  bool timePhases = false;
+  bool traceVm = false;
+  bool profileVm = false;
+
+  bool dumpAst = false;
+  bool dumpAsm = false;
+  bool dumpBytecode = false;
+
+  // print() of the vm writes to stderr instead of stdout, which may carry
+  // the output
+  bool printToStderr = false;
+
+  // svg if empty, or ppm, png or displaylist
+  std::string format;
+  // write tiles of tileSize to this directory instead of the output
+  std::string tiles;
+  int tileSize = 512;
+  int tileLevels = 1;
+};
+
 }  // namespace rectangle
@@ -0,0 +1,222 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "outputsink.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace rectangle {
+namespace util {
+
+OutputSink::OutputSink(size_t bufferSize)
+    : m_buffer(bufferSize > 0 ? bufferSize : 1) {}
+
+OutputSink::~OutputSink() {}
+
+void OutputSink::write(const char *data, size_t size) {
+  if (size > m_buffer.size() - m_size) {
+    flushBuffer();
+    if (size >= m_buffer.size()) {
+      if (!m_failed && !writeRaw(data, size)) {
+        m_failed = true;
+      }
+      m_bytesWritten += size;
+      return;
+    }
+  }
+  memcpy(m_buffer.data() + m_size, data, size);
+  m_size += size;
+}
+
+void OutputSink::writeInt(int n) {
+  commit(formatInt(reserve(kMaxIntLength), n));
+}
+
+void OutputSink::reserveSlow(size_t size) {
+  flushBuffer();
+  if (m_buffer.size() < size) {
+    m_buffer.resize(size);
+  }
+}
+
+static const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static int digitCount(unsigned u) {
+  int count = 1;
+  while (u >= 10) {
+    u /= 10;
+    count++;
+  }
+  return count;
+}
+
+char *formatInt(char *out, int n) {
+  unsigned u = static_cast<unsigned>(n);
+  if (n < 0) {
+    *out++ = '-';
+    u = 0u - u;
+  }
+  char *end = out + digitCount(u);
+  char *p = end;
+  while (u >= 100) {
+    unsigned pair = (u % 100) * 2;
+    u /= 100;
+    *--p = kDigitPairs[pair + 1];
+    *--p = kDigitPairs[pair];
+  }
+  if (u >= 10) {
+    *--p = kDigitPairs[u * 2 + 1];
+    *--p = kDigitPairs[u * 2];
+  } else {
+    *--p = static_cast<char>('0' + u);
+  }
+  return end;
+}
+
+void OutputSink::print(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  va_list ap2;
+  va_copy(ap2, ap);
+
+  size_t avail = m_buffer.size() - m_size;
+  int n = vsnprintf(m_buffer.data() + m_size, avail, fmt, ap);
+  if (n >= 0 && static_cast<size_t>(n) < avail) {
+    m_size += static_cast<size_t>(n);
+  } else if (n >= 0) {
+    string s(static_cast<size_t>(n) + 1, '\0');
+    vsnprintf(&s[0], s.size(), fmt, ap2);
+    write(s.data(), static_cast<size_t>(n));
+  }
+
+  va_end(ap2);
+  va_end(ap);
+}
+
+void OutputSink::flush() {
+  flushBuffer();
+  if (!m_failed && !flushRaw()) {
+    m_failed = true;
+  }
+}
+
+bool OutputSink::failed() const { return m_failed; }
+
+size_t OutputSink::bytesWritten() const { return m_bytesWritten + m_size; }
+
+void OutputSink::flushBuffer() {
+  if (m_size == 0) {
+    return;
+  }
+  if (!m_failed && !writeRaw(m_buffer.data(), m_size)) {
+    m_failed = true;
+  }
+  m_bytesWritten += m_size;
+  m_size = 0;
+}
+
+void writeJsonString(OutputSink &sink, const string &s) {
+  sink.write('"');
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      sink.write('\\');
+      sink.write(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      sink.print("\\u%04x", c);
+    } else {
+      sink.write(c);
+    }
+  }
+  sink.write('"');
+}
+
+FileSink::FileSink(FILE *fp) : m_fp(fp) {}
+
+FileSink::~FileSink() { flush(); }
+
+bool FileSink::writeRaw(const char *data, size_t size) {
+  return fwrite(data, 1, size, m_fp) == size;
+}
+
+bool FileSink::flushRaw() { return fflush(m_fp) == 0; }
+
+FdSink::FdSink(int fd) : m_fd(fd) {}
+
+FdSink::~FdSink() { flush(); }
+
+bool FdSink::writeRaw(const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::write(m_fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+StringSink::StringSink(string &out) : m_out(out) {}
+
+StringSink::~StringSink() { flush(); }
+
+bool StringSink::writeRaw(const char *data, size_t size) {
+  m_out.append(data, size);
+  return true;
+}
+
+BufferSink::BufferSink(char *buffer, size_t capacity)
+    : m_out(buffer), m_capacity(capacity) {}
+
+BufferSink::~BufferSink() { flush(); }
+
+bool BufferSink::truncated() const { return m_truncated; }
+
+bool BufferSink::writeRaw(const char *data, size_t size) {
+  size_t n = min(size, m_capacity - m_size);
+  if (n > 0) {
+    memcpy(m_out + m_size, data, n);
+    m_size += n;
+  }
+  if (n < size) {
+    m_truncated = true;
+  }
+  return true;
+}
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,146 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+namespace rectangle {
+namespace util {
+
+// max length of formatInt() output
+const size_t kMaxIntLength = 11;
+
+// Writes the decimal text of n at out and returns the end of it.
+char *formatInt(char *out, int n);
+
+// Buffered byte sink. Derived classes only write out full buffers and
+// must call flush() in their destructor.
+class OutputSink {
+ public:
+  explicit OutputSink(size_t bufferSize = 64 * 1024);
+  virtual ~OutputSink();
+
+  void write(const char *data, size_t size);
+  void write(const char *s) { write(s, strlen(s)); }
+  void write(const std::string &s) { write(s.data(), s.size()); }
+  void write(char c) {
+    if (m_size == m_buffer.size()) {
+      flushBuffer();
+    }
+    m_buffer[m_size++] = c;
+  }
+  void writeInt(int n);
+  // Returns room for at least size bytes in the buffer, the caller writes
+  // there directly and passes the end of the written bytes to commit().
+  char *reserve(size_t size) {
+    if (m_buffer.size() - m_size < size) {
+      reserveSlow(size);
+    }
+    return m_buffer.data() + m_size;
+  }
+  void commit(char *end) {
+    m_size = static_cast<size_t>(end - m_buffer.data());
+  }
+  void print(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  void flush();
+  bool failed() const;
+  size_t bytesWritten() const;
+
+ protected:
+  virtual bool writeRaw(const char *data, size_t size) = 0;
+  virtual bool flushRaw() { return true; }
+
+ private:
+  void flushBuffer();
+  void reserveSlow(size_t size);
+
+ private:
+  std::vector<char> m_buffer;
+  size_t m_size = 0;
+  size_t m_bytesWritten = 0;
+  bool m_failed = false;
+};
+
+// writes s as a quoted json string
+void writeJsonString(OutputSink &sink, const std::string &s);
+
+class FileSink : public OutputSink {
+ public:
+  explicit FileSink(FILE *fp);
+  ~FileSink() override;
+
+ protected:
+  bool writeRaw(const char *data, size_t size) override;
+  bool flushRaw() override;
+
+ private:
+  FILE *m_fp;
+};
+
+class FdSink : public OutputSink {
+ public:
+  explicit FdSink(int fd);
+  ~FdSink() override;
+
+ protected:
+  bool writeRaw(const char *data, size_t size) override;
+
+ private:
+  int m_fd;
+};
+
+class StringSink : public OutputSink {
+ public:
+  explicit StringSink(std::string &out);
+  ~StringSink() override;
+
+ protected:
+  bool writeRaw(const char *data, size_t size) override;
+
+ private:
+  std::string &m_out;
+};
+
+// Writes into a fixed buffer of the caller. What does not fit is dropped
+// but still counted by bytesWritten(), so the caller can retry with a
+// buffer large enough.
+class BufferSink : public OutputSink {
+ public:
+  BufferSink(char *buffer, size_t capacity);
+  ~BufferSink() override;
+
+  bool truncated() const;
+
+ protected:
+  bool writeRaw(const char *data, size_t size) override;
+
+ private:
+  char *m_out;
+  size_t m_capacity;
+  size_t m_size = 0;
+  bool m_truncated = false;
+};
+
+}  // namespace util
+}  // namespace rectangle
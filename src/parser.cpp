@@ -31,7 +31,8 @@ using namespace rectangle::diag;
 namespace rectangle {
 namespace frontend {
 
-Parser::Parser() {}
+Parser::Parser(const Options &options)
+    : m_printLLTry(options.printLLTry) {}
 
 void Parser::clear() {
   m_tokens.clear();
@@ -202,8 +203,7 @@ bool Parser::tryMemberItemAlt1() {
   try {
     parsePropertyDefination();
   } catch (exception &e) {
-    util::condPrint(option::printLLTry, "tryMemberItemAlt1 fail: %s\n",
-                    e.what());
+    COND_PRINT(m_printLLTry, "tryMemberItemAlt1 fail: %s\n", e.what());
     result = false;
   }
 
@@ -221,8 +221,7 @@ bool Parser::tryMemberItemAlt2() {
   try {
     parseFunctionDefination();
   } catch (exception &e) {
-    util::condPrint(option::printLLTry, "tryMemberItemAlt2 fail: %s\n",
-                    e.what());
+    COND_PRINT(m_printLLTry, "tryMemberItemAlt2 fail: %s\n", e.what());
     result = false;
     throw;
   }
@@ -516,6 +515,7 @@ void Parser::parseBlockItemList(std::vector<std::unique_ptr<Stmt>> &stmts) {
 //    ;
 
 void Parser::parseBlockItem(std::vector<std::unique_ptr<Stmt>> &stmts) {
+  Token tok = curToken();
   unique_ptr<Stmt> stmt;
   if (tryBlockItemAlt2()) {
     stmt = parseStatement();
@@ -527,6 +527,9 @@ void Parser::parseBlockItem(std::vector<std::unique_ptr<Stmt>> &stmts) {
   }
 
   if (!trying()) {
+    if (stmt->tok.line < 0) {
+      stmt->tok = tok;
+    }
     stmts.push_back(move(stmt));
   }
 }
@@ -539,8 +542,7 @@ bool Parser::tryBlockItemAlt1() {
   try {
     parseDeclaration();
   } catch (exception &e) {
-    util::condPrint(option::printLLTry, "tryBlockItemAlt1 fail: %s\n",
-                    e.what());
+    COND_PRINT(m_printLLTry, "tryBlockItemAlt1 fail: %s\n", e.what());
     result = false;
     throw;
   }
@@ -559,8 +561,7 @@ bool Parser::tryBlockItemAlt2() {
   try {
     parseStatement();
   } catch (exception &e) {
-    util::condPrint(option::printLLTry, "tryBlockItemAlt2 fail: %s\n",
-                    e.what());
+    COND_PRINT(m_printLLTry, "tryBlockItemAlt2 fail: %s\n", e.what());
     result = false;
   }
 
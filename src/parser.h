@@ -23,6 +23,7 @@
 
 #include "astnode.h"
 #include "lexer.h"
+#include "option.h"
 
 namespace rectangle {
 
@@ -78,7 +79,7 @@ class Parser {
  public:
   static std::string parserRuleString(ParserRule rule);
 
-  Parser();
+  explicit Parser(const Options &options = Options());
   std::unique_ptr<DocumentDecl> parse(const std::vector<Token> &tokens);
 
  private:
@@ -150,6 +151,7 @@ class Parser {
   std::vector<Token> m_tokens;
   int m_index = 0;
   int m_trying = 0;
+  bool m_printLLTry = false;
   std::unique_ptr<DocumentDecl> m_document;
 };
 
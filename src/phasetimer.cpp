@@ -0,0 +1,203 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "phasetimer.h"
+
+#include <assert.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace rectangle {
+namespace util {
+
+static AllocStatsHook g_allocStatsHook = nullptr;
+
+AllocStatsHook setAllocStatsHook(AllocStatsHook hook) {
+  AllocStatsHook previous = g_allocStatsHook;
+  g_allocStatsHook = hook;
+  return previous;
+}
+
+bool allocStatsAvailable() { return g_allocStatsHook != nullptr; }
+
+AllocStats allocStats() {
+  return g_allocStatsHook ? g_allocStatsHook() : AllocStats{0, 0};
+}
+
+static double clockMs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static long peakRssKb() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  // kilobytes on linux
+  return usage.ru_maxrss;
+}
+
+PhaseTimer::PhaseTimer()
+    : m_origin(clockMs(CLOCK_MONOTONIC)),
+      m_allocCounted(allocStatsAvailable()) {}
+
+void PhaseTimer::setEnabled(bool enabled) { m_enabled = enabled; }
+
+bool PhaseTimer::enabled() const { return m_enabled; }
+
+void PhaseTimer::setTraceWriter(TraceWriter *trace) { m_trace = trace; }
+
+void PhaseTimer::begin(const string &name, const string &file) {
+  if (!m_enabled) {
+    return;
+  }
+  assert(!m_running);
+  m_running = true;
+  m_current.name = name;
+  m_current.file = file;
+  m_allocStart = allocStats();
+  m_cpuStart = clockMs(CLOCK_PROCESS_CPUTIME_ID);
+  m_current.startMs = clockMs(CLOCK_MONOTONIC) - m_origin;
+  if (m_trace) {
+    m_traceStart = m_trace->now();
+  }
+}
+
+void PhaseTimer::end() {
+  if (!m_enabled || !m_running) {
+    return;
+  }
+  m_current.wallMs = clockMs(CLOCK_MONOTONIC) - m_origin - m_current.startMs;
+  m_current.cpuMs = clockMs(CLOCK_PROCESS_CPUTIME_ID) - m_cpuStart;
+  AllocStats stats = allocStats();
+  m_current.allocations = stats.count - m_allocStart.count;
+  m_current.allocatedBytes = stats.bytes - m_allocStart.bytes;
+  m_current.peakRssKb = peakRssKb();
+  m_records.push_back(m_current);
+  m_running = false;
+  if (m_trace) {
+    m_trace->complete(m_current.name, "phase", m_traceStart,
+                      m_trace->now() - m_traceStart, m_current.file);
+  }
+}
+
+void PhaseTimer::clear() {
+  m_records.clear();
+  m_running = false;
+}
+
+const vector<PhaseRecord> &PhaseTimer::records() const { return m_records; }
+
+bool PhaseTimer::allocationsCounted() const { return m_allocCounted; }
+
+PhaseRecord PhaseTimer::total() const {
+  PhaseRecord total;
+  total.name = "total";
+  total.startMs = m_records.empty() ? 0 : m_records.front().startMs;
+  total.wallMs = 0;
+  total.cpuMs = 0;
+  total.allocations = 0;
+  total.allocatedBytes = 0;
+  total.peakRssKb = 0;
+  for (auto &r : m_records) {
+    total.wallMs += r.wallMs;
+    total.cpuMs += r.cpuMs;
+    total.allocations += r.allocations;
+    total.allocatedBytes += r.allocatedBytes;
+    total.peakRssKb = max(total.peakRssKb, r.peakRssKb);
+  }
+  return total;
+}
+
+static void printRecord(FILE *fp, const PhaseRecord &r, bool allocCounted) {
+  fprintf(fp, "%-10s %-32s %10.3f %12.3f", r.name.c_str(), r.file.c_str(),
+          r.wallMs, r.cpuMs);
+  if (allocCounted) {
+    fprintf(fp, " %12llu %14.1f",
+            static_cast<unsigned long long>(r.allocations),
+            r.allocatedBytes / 1024.0);
+  } else {
+    fprintf(fp, " %12s %14s", "n/a", "n/a");
+  }
+  fprintf(fp, " %12ld\n", r.peakRssKb);
+}
+
+void PhaseTimer::printReport(FILE *fp) const {
+  // the clocks and counters below are of the whole process, so they include
+  // the work of other threads and drivers running at the same time
+  fprintf(fp, "%-10s %-32s %10s %12s %12s %14s %12s\n", "phase", "file",
+          "wall ms", "proc cpu ms", "proc allocs", "proc alloc KB",
+          "peak rss KB");
+  for (auto &r : m_records) {
+    printRecord(fp, r, m_allocCounted);
+  }
+  printRecord(fp, total(), m_allocCounted);
+}
+
+static void writeJsonRecord(OutputSink &sink, const PhaseRecord &r,
+                            bool allocCounted) {
+  sink.write("{\"phase\": ");
+  writeJsonString(sink, r.name);
+  sink.write(", \"file\": ");
+  writeJsonString(sink, r.file);
+  sink.print(", \"wallMs\": %.3f, \"cpuMs\": %.3f, ", r.wallMs, r.cpuMs);
+  if (allocCounted) {
+    sink.print("\"allocations\": %llu, \"allocatedBytes\": %llu, ",
+               static_cast<unsigned long long>(r.allocations),
+               static_cast<unsigned long long>(r.allocatedBytes));
+  } else {
+    sink.write("\"allocations\": null, \"allocatedBytes\": null, ");
+  }
+  sink.print("\"peakRssKb\": %ld}", r.peakRssKb);
+}
+
+void PhaseTimer::writeJson(OutputSink &sink) const {
+  sink.write("{\n  \"processWide\": [\"cpuMs\", \"allocations\", "
+             "\"allocatedBytes\", \"peakRssKb\"],\n  \"phases\": [\n");
+  for (size_t i = 0; i < m_records.size(); i++) {
+    sink.write("    ");
+    writeJsonRecord(sink, m_records[i], m_allocCounted);
+    sink.write(i + 1 < m_records.size() ? ",\n" : "\n");
+  }
+  sink.write("  ],\n  \"total\": ");
+  writeJsonRecord(sink, total(), m_allocCounted);
+  sink.write("\n}\n");
+}
+
+ScopedPhase::ScopedPhase(PhaseTimer *timer, const string &name,
+                         const string &file)
+    : m_timer(timer) {
+  if (m_timer) {
+    m_timer->begin(name, file);
+  }
+}
+
+ScopedPhase::~ScopedPhase() {
+  if (m_timer) {
+    m_timer->end();
+  }
+}
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,112 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "outputsink.h"
+#include "tracewriter.h"
+
+namespace rectangle {
+namespace util {
+
+// allocations through operator new since the start of the process
+struct AllocStats {
+  uint64_t count;
+  uint64_t bytes;
+};
+// Installed by alloccounter.cpp, which programs link to count allocations.
+// Without it allocStats() returns zeros and the phase reports show the
+// allocations as unavailable.
+typedef AllocStats (*AllocStatsHook)();
+// returns the previous hook
+AllocStatsHook setAllocStatsHook(AllocStatsHook hook);
+bool allocStatsAvailable();
+AllocStats allocStats();
+
+struct PhaseRecord {
+  std::string name;
+  // empty for the phases working on all files
+  std::string file;
+  // since the timer was created
+  double startMs;
+  double wallMs;
+  // cpu time and allocations of the whole process, not only of this timer
+  double cpuMs;
+  uint64_t allocations;
+  uint64_t allocatedBytes;
+  // of the process when the phase ended
+  long peakRssKb;
+};
+
+// Measures named phases, one at a time. Nothing is measured while the
+// timer is disabled.
+class PhaseTimer {
+ public:
+  PhaseTimer();
+
+  void setEnabled(bool enabled);
+  bool enabled() const;
+  // every phase is also written to trace as an event, may be null
+  void setTraceWriter(TraceWriter *trace);
+
+  void begin(const std::string &name, const std::string &file = "");
+  void end();
+  void clear();
+
+  const std::vector<PhaseRecord> &records() const;
+  PhaseRecord total() const;
+  // false if no allocation counter is linked
+  bool allocationsCounted() const;
+
+  void printReport(FILE *fp) const;
+  void writeJson(OutputSink &sink) const;
+
+ private:
+  bool m_enabled = false;
+  double m_origin;
+  bool m_allocCounted;
+  bool m_running = false;
+  PhaseRecord m_current;
+  double m_cpuStart = 0;
+  AllocStats m_allocStart = {0, 0};
+  TraceWriter *m_trace = nullptr;
+  double m_traceStart = 0;
+  std::vector<PhaseRecord> m_records;
+};
+
+// begin() on construction and end() on destruction, timer may be null
+class ScopedPhase {
+ public:
+  ScopedPhase(PhaseTimer *timer, const std::string &name,
+              const std::string &file = "");
+  ~ScopedPhase();
+  ScopedPhase(const ScopedPhase &) = delete;
+  ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+ private:
+  PhaseTimer *m_timer;
+};
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,580 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "rasterizer.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+// 5x7 glyphs of ascii 32 to 126, one byte per column, bit 0 is the top
+static const unsigned char kFont[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5f, 0x00, 0x00},
+    {0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7f, 0x14, 0x7f, 0x14},
+    {0x24, 0x2a, 0x7f, 0x2a, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00},
+    {0x00, 0x1c, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1c, 0x00},
+    {0x08, 0x2a, 0x1c, 0x2a, 0x08}, {0x08, 0x08, 0x3e, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08},
+    {0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},
+    {0x3e, 0x51, 0x49, 0x45, 0x3e}, {0x00, 0x42, 0x7f, 0x40, 0x00},
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4b, 0x31},
+    {0x18, 0x14, 0x12, 0x7f, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39},
+    {0x3c, 0x4a, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1e},
+    {0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00},
+    {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06},
+    {0x32, 0x49, 0x79, 0x41, 0x3e}, {0x7e, 0x11, 0x11, 0x11, 0x7e},
+    {0x7f, 0x49, 0x49, 0x49, 0x36}, {0x3e, 0x41, 0x41, 0x41, 0x22},
+    {0x7f, 0x41, 0x41, 0x22, 0x1c}, {0x7f, 0x49, 0x49, 0x49, 0x41},
+    {0x7f, 0x09, 0x09, 0x01, 0x01}, {0x3e, 0x41, 0x41, 0x51, 0x32},
+    {0x7f, 0x08, 0x08, 0x08, 0x7f}, {0x00, 0x41, 0x7f, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3f, 0x01}, {0x7f, 0x08, 0x14, 0x22, 0x41},
+    {0x7f, 0x40, 0x40, 0x40, 0x40}, {0x7f, 0x02, 0x04, 0x02, 0x7f},
+    {0x7f, 0x04, 0x08, 0x10, 0x7f}, {0x3e, 0x41, 0x41, 0x41, 0x3e},
+    {0x7f, 0x09, 0x09, 0x09, 0x06}, {0x3e, 0x41, 0x51, 0x21, 0x5e},
+    {0x7f, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31},
+    {0x01, 0x01, 0x7f, 0x01, 0x01}, {0x3f, 0x40, 0x40, 0x40, 0x3f},
+    {0x1f, 0x20, 0x40, 0x20, 0x1f}, {0x7f, 0x20, 0x18, 0x20, 0x7f},
+    {0x63, 0x14, 0x08, 0x14, 0x63}, {0x03, 0x04, 0x78, 0x04, 0x03},
+    {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7f, 0x41, 0x41, 0x00},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7f, 0x00},
+    {0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},
+    {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+    {0x7f, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20},
+    {0x38, 0x44, 0x44, 0x48, 0x7f}, {0x38, 0x54, 0x54, 0x54, 0x18},
+    {0x08, 0x7e, 0x09, 0x01, 0x02}, {0x08, 0x14, 0x54, 0x54, 0x3c},
+    {0x7f, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7d, 0x40, 0x00},
+    {0x20, 0x40, 0x44, 0x3d, 0x00}, {0x00, 0x7f, 0x10, 0x28, 0x44},
+    {0x00, 0x41, 0x7f, 0x40, 0x00}, {0x7c, 0x04, 0x18, 0x04, 0x78},
+    {0x7c, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},
+    {0x7c, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7c},
+    {0x7c, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3f, 0x44, 0x40, 0x20}, {0x3c, 0x40, 0x40, 0x20, 0x7c},
+    {0x1c, 0x20, 0x40, 0x20, 0x1c}, {0x3c, 0x40, 0x30, 0x40, 0x3c},
+    {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0c, 0x50, 0x50, 0x50, 0x3c},
+    {0x44, 0x64, 0x54, 0x4c, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},
+    {0x00, 0x00, 0x7f, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00},
+    {0x08, 0x04, 0x08, 0x10, 0x08},
+};
+
+// drawn for characters out of the font
+static const unsigned char kMissingGlyph[5] = {0x7f, 0x41, 0x41, 0x41, 0x7f};
+
+struct NamedColor {
+  const char *name;
+  uint32_t rgb;
+};
+
+static const NamedColor kNamedColors[] = {
+    {"black", 0x000000},   {"white", 0xffffff},  {"red", 0xff0000},
+    {"green", 0x008000},   {"blue", 0x0000ff},   {"yellow", 0xffff00},
+    {"cyan", 0x00ffff},    {"aqua", 0x00ffff},   {"magenta", 0xff00ff},
+    {"fuchsia", 0xff00ff}, {"gray", 0x808080},   {"grey", 0x808080},
+    {"silver", 0xc0c0c0},  {"maroon", 0x800000}, {"olive", 0x808000},
+    {"lime", 0x00ff00},    {"navy", 0x000080},   {"purple", 0x800080},
+    {"teal", 0x008080},    {"orange", 0xffa500}, {"pink", 0xffc0cb},
+    {"brown", 0xa52a2a},   {"gold", 0xffd700},   {"violet", 0xee82ee},
+};
+
+static uint32_t premultiply(int r, int g, int b, int a) {
+  return Image::pack((r * a + 127) / 255, (g * a + 127) / 255,
+                     (b * a + 127) / 255, a);
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+bool Rasterizer::parseColor(const string &s, uint32_t &color) {
+  if (s == "none" || s == "transparent") {
+    color = 0;
+    return true;
+  }
+  if (s.size() > 1 && s[0] == '#') {
+    vector<int> digits;
+    for (size_t i = 1; i < s.size(); i++) {
+      int v = hexValue(s[i]);
+      if (v < 0) {
+        return false;
+      }
+      digits.push_back(v);
+    }
+    if (digits.size() == 3 || digits.size() == 4) {
+      int a = digits.size() == 4 ? digits[3] * 17 : 255;
+      color = premultiply(digits[0] * 17, digits[1] * 17, digits[2] * 17, a);
+      return true;
+    }
+    if (digits.size() == 6 || digits.size() == 8) {
+      int a = digits.size() == 8 ? digits[6] * 16 + digits[7] : 255;
+      color = premultiply(digits[0] * 16 + digits[1],
+                          digits[2] * 16 + digits[3],
+                          digits[4] * 16 + digits[5], a);
+      return true;
+    }
+    return false;
+  }
+  int r = 0;
+  int g = 0;
+  int b = 0;
+  float a = 1.0f;
+  if (sscanf(s.c_str(), "rgba(%d,%d,%d,%f)", &r, &g, &b, &a) == 4 ||
+      sscanf(s.c_str(), "rgb(%d,%d,%d)", &r, &g, &b) == 3) {
+    auto clamp255 = [](int v) { return min(max(v, 0), 255); };
+    int alpha = clamp255(static_cast<int>(a * 255 + 0.5f));
+    color = premultiply(clamp255(r), clamp255(g), clamp255(b), alpha);
+    return true;
+  }
+  for (auto &named : kNamedColors) {
+    if (s == named.name) {
+      color = premultiply(named.rgb >> 16 & 0xff, named.rgb >> 8 & 0xff,
+                          named.rgb & 0xff, 255);
+      return true;
+    }
+  }
+  return false;
+}
+
+// unsupported fill colors are black, unsupported strokes are not drawn
+static uint32_t fillColor(const DisplayList &list, const Style &style) {
+  uint32_t color = 0;
+  if (style.fillColor < 0 ||
+      !Rasterizer::parseColor(list.str(style.fillColor), color)) {
+    color = Image::pack(0, 0, 0, 255);
+  }
+  return color;
+}
+
+static uint32_t strokeColor(const DisplayList &list, const Style &style) {
+  uint32_t color = 0;
+  if (style.strokeWidth <= 0 ||
+      !Rasterizer::parseColor(list.str(style.strokeColor), color)) {
+    return 0;
+  }
+  return color;
+}
+
+#ifdef __SSE2__
+static inline __m128i blend4(__m128i dst, __m128i src, __m128i inv) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i half = _mm_set1_epi16(128);
+  __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inv);
+  __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inv);
+  // x / 255 as (x + 128 + ((x + 128) >> 8)) >> 8
+  lo = _mm_add_epi16(lo, half);
+  lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+  hi = _mm_add_epi16(hi, half);
+  hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+  return _mm_adds_epu8(_mm_packus_epi16(lo, hi), src);
+}
+#endif
+
+static inline int div255(int x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+// source over of one premultiplied color on count pixels
+static void blendSpan(uint32_t *dst, int count, uint32_t color) {
+  int a = Image::alpha(color);
+  if (a == 0) {
+    return;
+  }
+  int i = 0;
+  if (a == 255) {
+#ifdef __SSE2__
+    __m128i src = _mm_set1_epi32(static_cast<int>(color));
+    for (; i + 4 <= count; i += 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), src);
+    }
+#endif
+    for (; i < count; i++) {
+      dst[i] = color;
+    }
+    return;
+  }
+
+#ifdef __SSE2__
+  __m128i src = _mm_set1_epi32(static_cast<int>(color));
+  __m128i inv = _mm_set1_epi16(static_cast<short>(255 - a));
+  for (; i + 4 <= count; i += 4) {
+    __m128i *p = reinterpret_cast<__m128i *>(dst + i);
+    _mm_storeu_si128(p, blend4(_mm_loadu_si128(p), src, inv));
+  }
+#endif
+  for (; i < count; i++) {
+    uint32_t d = dst[i];
+    int r = Image::red(color) + div255(Image::red(d) * (255 - a));
+    int g = Image::green(color) + div255(Image::green(d) * (255 - a));
+    int b = Image::blue(color) + div255(Image::blue(d) * (255 - a));
+    int da = a + div255(Image::alpha(d) * (255 - a));
+    dst[i] = Image::pack(min(r, 255), min(g, 255), min(b, 255), min(da, 255));
+  }
+}
+
+Rasterizer::Rasterizer(Image &image)
+    : Rasterizer(image, Rect{0, 0, image.width(), image.height()}) {}
+
+Rasterizer::Rasterizer(Image &image, const Rect &clip)
+    : m_image(image),
+      m_clip{max(clip.left, 0), max(clip.top, 0),
+             min(clip.right, image.width()), min(clip.bottom, image.height())} {
+}
+
+void Rasterizer::draw(const DisplayList &list) {
+  for (auto &item : list.items()) {
+    draw(list, item);
+  }
+}
+
+void Rasterizer::draw(const DisplayList &list, const DisplayItem &item) {
+  switch (item.type) {
+    case ShapeType::Rectangle:
+      drawRectangle(list, list.rectangle(item.index));
+      break;
+    case ShapeType::Text:
+      drawText(list, list.text(item.index));
+      break;
+    case ShapeType::Ellipse:
+      drawEllipse(list, list.ellipse(item.index));
+      break;
+    case ShapeType::Polygon:
+      drawPolygon(list, list.polygon(item.index));
+      break;
+    case ShapeType::Line:
+      drawLine(list, list.line(item.index));
+      break;
+    case ShapeType::Polyline:
+      drawPolyline(list, list.polyline(item.index));
+      break;
+  }
+}
+
+void Rasterizer::drawRectangle(const DisplayList &list,
+                               const RectangleShape &s) {
+  if (s.width <= 0 || s.height <= 0) {
+    return;
+  }
+  const Style &style = list.style(s.style);
+  fillRect(s.x, s.y, s.x + s.width, s.y + s.height, fillColor(list, style));
+
+  uint32_t stroke = strokeColor(list, style);
+  if (Image::alpha(stroke) == 0) {
+    return;
+  }
+  double d = style.strokeWidth / 2.0;
+  double left = s.x;
+  double top = s.y;
+  double right = s.x + s.width;
+  double bottom = s.y + s.height;
+  vector<Contour> contours;
+  contours.push_back({{left - d, top - d},
+                      {right + d, top - d},
+                      {right + d, bottom + d},
+                      {left - d, bottom + d}});
+  if (right - left > 2 * d && bottom - top > 2 * d) {
+    contours.push_back({{left + d, top + d},
+                        {right - d, top + d},
+                        {right - d, bottom - d},
+                        {left + d, bottom - d}});
+  }
+  fillPath(contours, true, stroke);
+}
+
+void Rasterizer::drawText(const DisplayList &list, const TextShape &s) {
+  const string &text = list.str(s.text);
+  uint32_t color = Image::pack(0, 0, 0, 255);
+  // a glyph cell is 6x8 font units and one font size high
+  double unit = s.size / 8.0;
+  int column = 0;
+  for (char c : text) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if ((u & 0xc0) == 0x80) {
+      // utf-8 continuation byte
+      continue;
+    }
+    const unsigned char *glyph =
+        u >= 32 && u < 127 ? kFont[u - 32] : kMissingGlyph;
+    for (int gx = 0; gx < 5; gx++) {
+      int left = s.x + static_cast<int>(lround((column + gx) * unit));
+      int right = s.x + static_cast<int>(lround((column + gx + 1) * unit));
+      for (int gy = 0; gy < 7; gy++) {
+        if (glyph[gx] & (1 << gy)) {
+          int top = s.y + static_cast<int>(lround(gy * unit));
+          int bottom = s.y + static_cast<int>(lround((gy + 1) * unit));
+          fillRect(left, top, right, bottom, color);
+        }
+      }
+    }
+    column += 6;
+  }
+}
+
+void Rasterizer::drawEllipse(const DisplayList &list, const EllipseShape &s) {
+  const Style &style = list.style(s.style);
+  auto ellipse = [](double cx, double cy, double rx, double ry) {
+    int n = static_cast<int>(ceil(M_PI * max(rx, ry)));
+    n = min(max(n, 16), 4096);
+    Contour contour(static_cast<size_t>(n));
+    for (int i = 0; i < n; i++) {
+      double t = 2 * M_PI * i / n;
+      contour[static_cast<size_t>(i)] = {cx + rx * cos(t), cy + ry * sin(t)};
+    }
+    return contour;
+  };
+
+  if (s.rx > 0 && s.ry > 0) {
+    fillPath({ellipse(s.cx, s.cy, s.rx, s.ry)}, false, fillColor(list, style));
+  }
+
+  uint32_t stroke = strokeColor(list, style);
+  if (Image::alpha(stroke) == 0) {
+    return;
+  }
+  double d = style.strokeWidth / 2.0;
+  vector<Contour> contours;
+  contours.push_back(ellipse(s.cx, s.cy, s.rx + d, s.ry + d));
+  if (s.rx > d && s.ry > d) {
+    contours.push_back(ellipse(s.cx, s.cy, s.rx - d, s.ry - d));
+  }
+  fillPath(contours, true, stroke);
+}
+
+void Rasterizer::drawPolygon(const DisplayList &list, const PolygonShape &s) {
+  const Style &style = list.style(s.style);
+  const int32_t *p = list.points(s.pointBegin);
+  Contour contour(static_cast<size_t>(s.pointCount));
+  for (int i = 0; i < s.pointCount; i++) {
+    contour[static_cast<size_t>(i)] = {static_cast<double>(s.x + p[2 * i]),
+                                       static_cast<double>(s.y + p[2 * i + 1])};
+  }
+  bool evenOdd = style.fillRule >= 0 && list.str(style.fillRule) == "evenodd";
+  fillPath({contour}, evenOdd, fillColor(list, style));
+  strokePoints(contour, true, style.strokeWidth, strokeColor(list, style));
+}
+
+void Rasterizer::drawLine(const DisplayList &list, const LineShape &s) {
+  const Style &style = list.style(s.style);
+  vector<PointF> points = {
+      {static_cast<double>(s.x1), static_cast<double>(s.y1)},
+      {static_cast<double>(s.x2), static_cast<double>(s.y2)}};
+  strokePoints(points, false, style.strokeWidth, strokeColor(list, style));
+}
+
+void Rasterizer::drawPolyline(const DisplayList &list,
+                              const PolylineShape &s) {
+  const Style &style = list.style(s.style);
+  const int32_t *p = list.points(s.pointBegin);
+  vector<PointF> points(static_cast<size_t>(s.pointCount));
+  for (int i = 0; i < s.pointCount; i++) {
+    points[static_cast<size_t>(i)] = {static_cast<double>(s.x + p[2 * i]),
+                                      static_cast<double>(s.y + p[2 * i + 1])};
+  }
+  strokePoints(points, false, style.strokeWidth, strokeColor(list, style));
+}
+
+
+void Rasterizer::strokePoints(const vector<PointF> &points, bool closed,
+                              int strokeWidth, uint32_t color) {
+  if (Image::alpha(color) == 0 || points.size() < 2) {
+    return;
+  }
+  // Every segment is a quad and every join a small disc, all counter
+  // clockwise so that the non-zero rule gives their union. Caps are butt.
+  double d = strokeWidth / 2.0;
+  vector<Contour> contours;
+  size_t n = points.size();
+  size_t segments = closed ? n : n - 1;
+  for (size_t i = 0; i < segments; i++) {
+    const PointF &a = points[i];
+    const PointF &b = points[(i + 1) % n];
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double length = sqrt(dx * dx + dy * dy);
+    if (length == 0) {
+      continue;
+    }
+    double nx = -dy / length * d;
+    double ny = dx / length * d;
+    contours.push_back({{a.x - nx, a.y - ny},
+                        {b.x - nx, b.y - ny},
+                        {b.x + nx, b.y + ny},
+                        {a.x + nx, a.y + ny}});
+  }
+  const int discSides = 8;
+  for (size_t i = closed ? 0 : 1; i < (closed ? n : n - 1); i++) {
+    Contour disc(discSides);
+    for (int k = 0; k < discSides; k++) {
+      double t = 2 * M_PI * k / discSides;
+      disc[static_cast<size_t>(k)] = {points[i].x + d * cos(t),
+                                      points[i].y + d * sin(t)};
+    }
+    contours.push_back(disc);
+  }
+  for (auto &contour : contours) {
+    double area = 0;
+    for (size_t i = 0; i < contour.size(); i++) {
+      const PointF &a = contour[i];
+      const PointF &b = contour[(i + 1) % contour.size()];
+      area += a.x * b.y - b.x * a.y;
+    }
+    if (area < 0) {
+      reverse(contour.begin(), contour.end());
+    }
+  }
+  fillPath(contours, false, color);
+}
+
+void Rasterizer::fillRect(int left, int top, int right, int bottom,
+                          uint32_t color) {
+  top = max(top, m_clip.top);
+  bottom = min(bottom, m_clip.bottom);
+  for (int y = top; y < bottom; y++) {
+    fillSpan(y, left, right, color);
+  }
+}
+
+namespace {
+
+struct Edge {
+  double top;
+  double bottom;
+  double x;  // at top
+  double slope;
+  int direction;
+};
+
+struct Crossing {
+  double x;
+  int direction;
+};
+
+}  // namespace
+
+void Rasterizer::fillPath(const vector<Contour> &contours, bool evenOdd,
+                          uint32_t color) {
+  if (Image::alpha(color) == 0) {
+    return;
+  }
+  vector<Edge> edges;
+  for (auto &contour : contours) {
+    for (size_t i = 0; i < contour.size(); i++) {
+      const PointF &a = contour[i];
+      const PointF &b = contour[(i + 1) % contour.size()];
+      if (a.y == b.y) {
+        continue;
+      }
+      Edge e;
+      e.direction = a.y < b.y ? 1 : -1;
+      const PointF &upper = a.y < b.y ? a : b;
+      const PointF &lower = a.y < b.y ? b : a;
+      e.top = upper.y;
+      e.bottom = lower.y;
+      e.x = upper.x;
+      e.slope = (lower.x - upper.x) / (lower.y - upper.y);
+      edges.push_back(e);
+    }
+  }
+  if (edges.empty()) {
+    return;
+  }
+  sort(edges.begin(), edges.end(),
+       [](const Edge &lhs, const Edge &rhs) { return lhs.top < rhs.top; });
+
+  double minY = edges.front().top;
+  double maxY = minY;
+  for (auto &e : edges) {
+    maxY = max(maxY, e.bottom);
+  }
+  // rows whose pixel centers may be inside
+  int top = max(m_clip.top, static_cast<int>(floor(minY - 0.5)));
+  int bottom = min(m_clip.bottom, static_cast<int>(ceil(maxY + 0.5)));
+
+  size_t nextEdge = 0;
+  vector<const Edge *> active;
+  vector<Crossing> crossings;
+  for (int y = top; y < bottom; y++) {
+    double cy = y + 0.5;
+    while (nextEdge < edges.size() && edges[nextEdge].top <= cy) {
+      active.push_back(&edges[nextEdge++]);
+    }
+    active.erase(remove_if(active.begin(), active.end(),
+                           [cy](const Edge *e) { return e->bottom <= cy; }),
+                 active.end());
+
+    crossings.clear();
+    for (const Edge *e : active) {
+      crossings.push_back({e->x + (cy - e->top) * e->slope, e->direction});
+    }
+    sort(crossings.begin(), crossings.end(),
+         [](const Crossing &lhs, const Crossing &rhs) {
+           return lhs.x < rhs.x;
+         });
+
+    int winding = 0;
+    double spanStart = 0;
+    for (auto &c : crossings) {
+      bool wasInside = evenOdd ? (winding & 1) != 0 : winding != 0;
+      winding += c.direction;
+      bool inside = evenOdd ? (winding & 1) != 0 : winding != 0;
+      if (!wasInside && inside) {
+        spanStart = c.x;
+      } else if (wasInside && !inside) {
+        // pixels with centers in [spanStart, c.x)
+        int left = static_cast<int>(ceil(spanStart - 0.5));
+        int right = static_cast<int>(ceil(c.x - 0.5));
+        fillSpan(y, left, right, color);
+      }
+    }
+  }
+}
+
+void Rasterizer::fillSpan(int y, int left, int right, uint32_t color) {
+  if (y < m_clip.top || y >= m_clip.bottom) {
+    return;
+  }
+  left = max(left, m_clip.left);
+  right = min(right, m_clip.right);
+  if (left >= right) {
+    return;
+  }
+  blendSpan(m_image.row(y) + left, right - left, color);
+}
+
+}  // namespace draw
+}  // namespace rectangle
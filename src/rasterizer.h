@@ -0,0 +1,74 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "displaylist.h"
+#include "image.h"
+
+namespace rectangle {
+namespace draw {
+
+// Scan converts the shapes of a display list into an Image. Only the
+// pixels inside the clip rect are written, so rasterizers with disjoint
+// clips can draw into one image at the same time. There is no anti
+// aliasing, pixels are covered when their center is inside the shape.
+class Rasterizer {
+ public:
+  explicit Rasterizer(Image &image);
+  Rasterizer(Image &image, const Rect &clip);
+
+  void draw(const DisplayList &list);
+  void draw(const DisplayList &list, const DisplayItem &item);
+
+  // premultiplied color of a css color, false if it is not supported
+  static bool parseColor(const std::string &s, uint32_t &color);
+
+ private:
+  struct PointF {
+    double x;
+    double y;
+  };
+  typedef std::vector<PointF> Contour;
+
+  void drawRectangle(const DisplayList &list, const RectangleShape &s);
+  void drawText(const DisplayList &list, const TextShape &s);
+  void drawEllipse(const DisplayList &list, const EllipseShape &s);
+  void drawPolygon(const DisplayList &list, const PolygonShape &s);
+  void drawLine(const DisplayList &list, const LineShape &s);
+  void drawPolyline(const DisplayList &list, const PolylineShape &s);
+
+  void strokePoints(const std::vector<PointF> &points, bool closed,
+                    int strokeWidth, uint32_t color);
+  void fillRect(int left, int top, int right, int bottom, uint32_t color);
+  void fillPath(const std::vector<Contour> &contours, bool evenOdd,
+                uint32_t color);
+  void fillSpan(int y, int left, int right, uint32_t color);
+
+ private:
+  Image &m_image;
+  Rect m_clip;
+};
+
+}  // namespace draw
+}  // namespace rectangle
@@ -0,0 +1,426 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "renderserver.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "driver.h"
+#include "outputsink.h"
+#include "sourcefile.h"
+
+using namespace std;
+using namespace rectangle::frontend;
+using namespace rectangle::backend;
+using namespace rectangle::util;
+
+namespace rectangle {
+namespace driver {
+
+// a larger request is taken as a broken stream
+static const uint32_t kMaxRequestSize = 64 * 1024 * 1024;
+
+static uint32_t getU32(const char *p) {
+  const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+  return static_cast<uint32_t>(u[0]) << 24 | static_cast<uint32_t>(u[1]) << 16 |
+         static_cast<uint32_t>(u[2]) << 8 | static_cast<uint32_t>(u[3]);
+}
+
+static void putU32(char *p, uint32_t n) {
+  p[0] = static_cast<char>(n >> 24);
+  p[1] = static_cast<char>(n >> 16);
+  p[2] = static_cast<char>(n >> 8);
+  p[3] = static_cast<char>(n);
+}
+
+// the number of bytes read, less than size at the end of the stream
+static size_t readFull(int fd, char *data, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::read(fd, data + done, size - done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return done;
+}
+
+static bool writeFull(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+struct RenderServer::Connection {
+  Connection(int in_, int out_, bool owned_)
+      : in(in_), out(out_), owned(owned_) {}
+  ~Connection() {
+    if (owned) {
+      close(in);
+    }
+  }
+
+  // wait until fewer than max requests are pending, then add one
+  void addPending(int max) {
+    unique_lock<std::mutex> lock(pendingMutex);
+    drained.wait(lock, [this, max] { return pending < max; });
+    pending++;
+  }
+
+  void removePending() {
+    lock_guard<std::mutex> lock(pendingMutex);
+    pending--;
+    drained.notify_all();
+  }
+
+  void waitDrained() {
+    unique_lock<std::mutex> lock(pendingMutex);
+    drained.wait(lock, [this] { return pending == 0; });
+  }
+
+  // responses of the pool are written one at a time
+  void write(uint32_t id, const Response &r) {
+    char header[12];
+    putU32(header, id);
+    putU32(header + 4, r.status);
+    putU32(header + 8, static_cast<uint32_t>(r.data.size()));
+    lock_guard<std::mutex> lock(mutex);
+    if (!writeFull(out, header, sizeof(header)) ||
+        !writeFull(out, r.data.data(), r.data.size())) {
+      failed = true;
+    }
+  }
+
+  int in;
+  int out;
+  bool owned;
+  std::mutex mutex;
+  bool failed = false;
+
+  std::mutex pendingMutex;
+  std::condition_variable drained;
+  int pending = 0;
+};
+
+RenderServer::RenderServer(const Options &options, const vector<string> &paths)
+    : m_options(options),
+      m_paths(paths),
+      m_maxPending(2 * m_pool.threadCount()) {
+  // the responses may be written to stdout
+  m_options.printToStderr = true;
+}
+
+RenderServer::~RenderServer() {
+  stopWatcher();
+  m_pool.wait();
+}
+
+bool RenderServer::load() {
+  vector<int64_t> stamps = fileStamps();
+  vector<SourceFile> files;
+  bool valid = true;
+  for (auto &path : m_paths) {
+    files.emplace_back(path);
+    if (!files.back().valid()) {
+      fprintf(stderr, "error: open %s failed\n", path.c_str());
+      valid = false;
+      break;
+    }
+  }
+
+  shared_ptr<Module> module;
+  if (valid) {
+    module = Driver(m_options).load(files);
+  }
+
+  lock_guard<mutex> lock(m_moduleMutex);
+  m_stamps = stamps;
+  if (module) {
+    m_module = module;
+  }
+  return module != nullptr;
+}
+
+bool RenderServer::reloadIfChanged() {
+  vector<int64_t> stamps = fileStamps();
+  {
+    lock_guard<mutex> lock(m_moduleMutex);
+    if (stamps == m_stamps) {
+      return false;
+    }
+  }
+  // a failed load keeps the module in use
+  if (!load()) {
+    return false;
+  }
+  fprintf(stderr, "info: reloaded %zu definations\n", m_paths.size());
+  return true;
+}
+
+RenderServer::Response RenderServer::render(const string &document) {
+  Response r;
+  shared_ptr<Module> m = module();
+  if (!m) {
+    r.status = Error;
+    r.data = "error: no definations loaded\n";
+    return r;
+  }
+
+  Driver d(m_options);
+  d.setPrintErrors(false);
+  // --parallel-raster splits the request on the pool it already runs on
+  d.setThreadPool(&m_pool);
+  shared_ptr<const AsmBin> bin = d.build(*m, SourceFile("request", document));
+  if (!bin) {
+    r.status = Error;
+    r.data = d.error();
+    return r;
+  }
+
+  bool ok = false;
+  {
+    StringSink sink(r.data);
+    ok = d.run(*bin, sink);
+  }
+  if (!ok) {
+    r.status = Error;
+    r.data = d.error();
+  }
+  return r;
+}
+
+bool RenderServer::serve(int in, int out) {
+  shared_ptr<Connection> c = make_shared<Connection>(in, out, false);
+  startWatcher();
+  bool ok = readRequests(c);
+  c->waitDrained();
+  stopWatcher();
+  return ok && !c->failed;
+}
+
+bool RenderServer::listen(const string &path) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "error: socket path %s is too long\n", path.c_str());
+    return false;
+  }
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+  // a socket left by an earlier server is replaced, any other file is not
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      fprintf(stderr, "error: %s exists and is not a socket\n", path.c_str());
+      return false;
+    }
+    unlink(path.c_str());
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 ||
+      bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      ::listen(fd, SOMAXCONN) != 0) {
+    fprintf(stderr, "error: listen on %s failed: %s\n", path.c_str(),
+            strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_listenFd = fd;
+    if (m_stopping) {
+      shutdown(fd, SHUT_RDWR);
+    }
+  }
+  fprintf(stderr, "info: serving on %s\n", path.c_str());
+
+  startWatcher();
+  int connections = 0;
+  condition_variable closed;
+  for (;;) {
+    int cfd = accept(fd, nullptr, nullptr);
+    if (cfd < 0 && errno == EINTR) {
+      continue;
+    }
+    lock_guard<mutex> lock(m_mutex);
+    if (cfd < 0 || m_stopping) {
+      if (cfd >= 0) {
+        close(cfd);
+      }
+      break;
+    }
+    m_connectionFds.insert(cfd);
+    connections++;
+    shared_ptr<Connection> c = make_shared<Connection>(cfd, cfd, true);
+    thread([this, c, cfd, &connections, &closed]() {
+      readRequests(c);
+      lock_guard<mutex> lock(m_mutex);
+      m_connectionFds.erase(cfd);
+      connections--;
+      closed.notify_all();
+    }).detach();
+  }
+
+  bool stopped = false;
+  {
+    unique_lock<mutex> lock(m_mutex);
+    stopped = m_stopping;
+    m_listenFd = -1;
+    for (int cfd : m_connectionFds) {
+      shutdown(cfd, SHUT_RDWR);
+    }
+    closed.wait(lock, [&connections] { return connections == 0; });
+  }
+  m_pool.wait();
+  close(fd);
+  unlink(path.c_str());
+  stopWatcher();
+
+  if (!stopped) {
+    fprintf(stderr, "error: accept on %s failed: %s\n", path.c_str(),
+            strerror(errno));
+  }
+  return stopped;
+}
+
+void RenderServer::stop() {
+  lock_guard<mutex> lock(m_mutex);
+  m_stopping = true;
+  if (m_listenFd >= 0) {
+    shutdown(m_listenFd, SHUT_RDWR);
+  }
+}
+
+void RenderServer::setReloadInterval(int ms) { m_reloadInterval = ms; }
+
+void RenderServer::setMaxPendingRequests(int n) { m_maxPending = max(n, 1); }
+
+bool RenderServer::readRequests(const shared_ptr<Connection> &c) {
+  for (;;) {
+    // a client writing faster than the pool renders waits here
+    c->addPending(m_maxPending);
+    char header[8];
+    size_t n = readFull(c->in, header, sizeof(header));
+    if (n < sizeof(header)) {
+      c->removePending();
+      if (n == 0) {
+        return true;
+      }
+      fprintf(stderr, "error: request header cut off\n");
+      return false;
+    }
+    uint32_t id = getU32(header);
+    uint32_t size = getU32(header + 4);
+    if (size > kMaxRequestSize) {
+      c->removePending();
+      fprintf(stderr, "error: request of %u bytes is too large\n", size);
+      return false;
+    }
+    string document(size, '\0');
+    if (readFull(c->in, &document[0], size) < size) {
+      c->removePending();
+      fprintf(stderr, "error: request cut off\n");
+      return false;
+    }
+    m_pool.submit([this, c, id, document]() {
+      c->write(id, render(document));
+      c->removePending();
+    });
+  }
+}
+
+shared_ptr<Module> RenderServer::module() {
+  lock_guard<mutex> lock(m_moduleMutex);
+  return m_module;
+}
+
+vector<int64_t> RenderServer::fileStamps() const {
+  vector<int64_t> stamps;
+  for (auto &path : m_paths) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+      stamps.push_back(-1);
+      stamps.push_back(-1);
+      continue;
+    }
+    stamps.push_back(static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                     st.st_mtim.tv_nsec);
+    stamps.push_back(static_cast<int64_t>(st.st_size));
+  }
+  return stamps;
+}
+
+void RenderServer::startWatcher() {
+  lock_guard<mutex> lock(m_mutex);
+  if (m_watching || m_reloadInterval <= 0) {
+    return;
+  }
+  m_watching = true;
+  m_watcher = thread([this]() {
+    unique_lock<mutex> lock(m_mutex);
+    while (m_watching) {
+      m_cond.wait_for(lock, chrono::milliseconds(m_reloadInterval));
+      if (!m_watching) {
+        break;
+      }
+      lock.unlock();
+      reloadIfChanged();
+      lock.lock();
+    }
+  });
+}
+
+void RenderServer::stopWatcher() {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_watching) {
+      return;
+    }
+    m_watching = false;
+  }
+  m_cond.notify_all();
+  m_watcher.join();
+}
+
+}  // namespace driver
+}  // namespace rectangle
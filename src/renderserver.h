@@ -0,0 +1,112 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "module.h"
+#include "option.h"
+#include "threadpool.h"
+
+namespace rectangle {
+namespace driver {
+
+// Keeps the definations compiled and renders the instance documents of
+// requests against them on a thread pool. The protocol is described in
+// doc/serve.md. The definations are compiled again when one of their files
+// changes. print() of the definations writes to stderr.
+class RenderServer {
+ public:
+  enum Status : uint32_t { Ok = 0, Error = 1 };
+
+  struct Response {
+    uint32_t status = Ok;
+    // the output, or the error message
+    std::string data;
+  };
+
+  RenderServer(const Options &options, const std::vector<std::string> &paths);
+  ~RenderServer();
+
+  // compile the definations, false if they do not compile
+  bool load();
+  // load() again if a file of the definations changed since the last load,
+  // true if a new module is in use
+  bool reloadIfChanged();
+
+  // render document against the current definations
+  Response render(const std::string &document);
+
+  // answer the requests read from in on out until in ends
+  bool serve(int in, int out);
+  // answer the requests of every connection to a unix socket at path, until
+  // stop() is called
+  bool listen(const std::string &path);
+  void stop();
+
+  // check the files of the definations every ms while serving, never if
+  // ms <= 0
+  void setReloadInterval(int ms);
+  // requests of one connection rendered or waiting on the pool at once,
+  // reading stops until one of them is answered, twice the threads of the
+  // pool by default
+  void setMaxPendingRequests(int n);
+
+ private:
+  struct Connection;
+
+  // read requests from c and render them on the pool, false if the stream
+  // was broken
+  bool readRequests(const std::shared_ptr<Connection> &c);
+  std::shared_ptr<Module> module();
+  // modification times and sizes of the definations
+  std::vector<int64_t> fileStamps() const;
+  void startWatcher();
+  void stopWatcher();
+
+ private:
+  Options m_options;
+  std::vector<std::string> m_paths;
+
+  std::mutex m_moduleMutex;
+  std::shared_ptr<Module> m_module;
+  std::vector<int64_t> m_stamps;
+
+  util::ThreadPool m_pool;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_stopping = false;
+  bool m_watching = false;
+  int m_reloadInterval = 500;
+  int m_maxPending;
+  std::thread m_watcher;
+  int m_listenFd = -1;
+  std::set<int> m_connectionFds;
+};
+
+}  // namespace driver
+}  // namespace rectangle
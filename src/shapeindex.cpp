@@ -0,0 +1,243 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "shapeindex.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+static vector<Rect> itemBounds(const DisplayList &list) {
+  vector<Rect> bounds;
+  bounds.reserve(list.items().size());
+  for (auto &item : list.items()) {
+    bounds.push_back(list.bounds(item));
+  }
+  return bounds;
+}
+
+static Rect extentOf(const vector<Rect> &bounds) {
+  if (bounds.empty()) {
+    return Rect{0, 0, 1, 1};
+  }
+  Rect extent = bounds[0];
+  for (auto &r : bounds) {
+    extent.left = min(extent.left, r.left);
+    extent.top = min(extent.top, r.top);
+    extent.right = max(extent.right, r.right);
+    extent.bottom = max(extent.bottom, r.bottom);
+  }
+  return extent;
+}
+
+ShapeIndex::ShapeIndex(const DisplayList &list)
+    : m_list(list),
+      m_bounds(itemBounds(list)),
+      m_grid(extentOf(m_bounds), GridIndex::defaultSide(m_bounds.size()),
+             GridIndex::defaultSide(m_bounds.size())) {
+  for (size_t i = 0; i < m_bounds.size(); i++) {
+    m_grid.insert(m_bounds[i], static_cast<int>(i));
+  }
+}
+
+vector<int> ShapeIndex::itemsAt(int x, int y) const {
+  vector<int> result;
+  for (int item : m_grid.cell(x, y)) {
+    const Rect &b = m_bounds[static_cast<size_t>(item)];
+    if (x >= b.left && x < b.right && y >= b.top && y < b.bottom &&
+        hits(item, x, y)) {
+      result.push_back(item);
+    }
+  }
+  // cells list the items in paint order
+  reverse(result.begin(), result.end());
+  return result;
+}
+
+int ShapeIndex::topmostAt(int x, int y) const {
+  const vector<int> &cell = m_grid.cell(x, y);
+  for (auto it = cell.rbegin(); it != cell.rend(); ++it) {
+    const Rect &b = m_bounds[static_cast<size_t>(*it)];
+    if (x >= b.left && x < b.right && y >= b.top && y < b.bottom &&
+        hits(*it, x, y)) {
+      return *it;
+    }
+  }
+  return -1;
+}
+
+int ShapeIndex::instanceAt(int x, int y) const {
+  int item = topmostAt(x, y);
+  if (item < 0) {
+    return -1;
+  }
+  return m_list.items()[static_cast<size_t>(item)].instance;
+}
+
+vector<int> ShapeIndex::itemsIn(const Rect &r) const {
+  vector<int> result;
+  m_grid.forEach(r, [this, &r, &result](int item) {
+    if (m_bounds[static_cast<size_t>(item)].intersects(r)) {
+      result.push_back(item);
+    }
+  });
+  sort(result.begin(), result.end());
+  result.erase(unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+static double segmentDistance(double x, double y, double x1, double y1,
+                              double x2, double y2) {
+  double dx = x2 - x1;
+  double dy = y2 - y1;
+  double lengthSquare = dx * dx + dy * dy;
+  double t = 0;
+  if (lengthSquare > 0) {
+    t = ((x - x1) * dx + (y - y1) * dy) / lengthSquare;
+    t = min(max(t, 0.0), 1.0);
+  }
+  double px = x1 + t * dx - x;
+  double py = y1 + t * dy - y;
+  return sqrt(px * px + py * py);
+}
+
+static bool nearPoints(double x, double y, const int32_t *p, int count,
+                       int originX, int originY, bool closed, double d) {
+  int segments = closed ? count : count - 1;
+  for (int i = 0; i < segments; i++) {
+    int j = (i + 1) % count;
+    if (segmentDistance(x, y, originX + p[2 * i], originY + p[2 * i + 1],
+                        originX + p[2 * j], originY + p[2 * j + 1]) <= d) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int winding(double x, double y, const int32_t *p, int count,
+                   int originX, int originY) {
+  int w = 0;
+  for (int i = 0; i < count; i++) {
+    int j = (i + 1) % count;
+    double x1 = originX + p[2 * i];
+    double y1 = originY + p[2 * i + 1];
+    double x2 = originX + p[2 * j];
+    double y2 = originY + p[2 * j + 1];
+    if ((y1 <= y) != (y2 <= y)) {
+      double cx = x1 + (y - y1) * (x2 - x1) / (y2 - y1);
+      if (cx > x) {
+        w += y2 > y1 ? 1 : -1;
+      }
+    }
+  }
+  return w;
+}
+
+bool ShapeIndex::hits(int index, double x, double y) const {
+  const DisplayItem &item = m_list.items()[static_cast<size_t>(index)];
+  if (item.type == ShapeType::Text) {
+    return true;
+  }
+
+  int styleId = -1;
+  switch (item.type) {
+    case ShapeType::Rectangle:
+      styleId = m_list.rectangle(item.index).style;
+      break;
+    case ShapeType::Ellipse:
+      styleId = m_list.ellipse(item.index).style;
+      break;
+    case ShapeType::Polygon:
+      styleId = m_list.polygon(item.index).style;
+      break;
+    case ShapeType::Line:
+      styleId = m_list.line(item.index).style;
+      break;
+    case ShapeType::Polyline:
+      styleId = m_list.polyline(item.index).style;
+      break;
+    case ShapeType::Text:
+      break;
+  }
+  const Style &style = m_list.style(styleId);
+  bool filled = style.fillColor >= 0 && m_list.str(style.fillColor) != "none";
+  bool stroked = style.strokeWidth > 0 && style.strokeColor >= 0 &&
+                 m_list.str(style.strokeColor) != "none";
+  double d = style.strokeWidth / 2.0;
+
+  switch (item.type) {
+    case ShapeType::Rectangle: {
+      const RectangleShape &s = m_list.rectangle(item.index);
+      bool inside = x >= s.x && x <= s.x + s.width && y >= s.y &&
+                    y <= s.y + s.height;
+      bool inner = x > s.x + d && x < s.x + s.width - d && y > s.y + d &&
+                   y < s.y + s.height - d;
+      // bounds already hold the outer edge of the stroke
+      return (filled && inside) || (stroked && !inner);
+    }
+    case ShapeType::Ellipse: {
+      const EllipseShape &s = m_list.ellipse(item.index);
+      auto within = [x, y, &s](double rx, double ry) {
+        if (rx <= 0 || ry <= 0) {
+          return false;
+        }
+        double u = (x - s.cx) / rx;
+        double v = (y - s.cy) / ry;
+        return u * u + v * v <= 1;
+      };
+      return (filled && within(s.rx, s.ry)) ||
+             (stroked && within(s.rx + d, s.ry + d) &&
+              !within(s.rx - d, s.ry - d));
+    }
+    case ShapeType::Polygon: {
+      const PolygonShape &s = m_list.polygon(item.index);
+      const int32_t *p = m_list.points(s.pointBegin);
+      if (filled && s.pointCount > 2) {
+        int w = winding(x, y, p, s.pointCount, s.x, s.y);
+        bool evenOdd =
+            style.fillRule >= 0 && m_list.str(style.fillRule) == "evenodd";
+        if (evenOdd ? (w & 1) != 0 : w != 0) {
+          return true;
+        }
+      }
+      return stroked && s.pointCount > 1 &&
+             nearPoints(x, y, p, s.pointCount, s.x, s.y, true, d);
+    }
+    case ShapeType::Line: {
+      const LineShape &s = m_list.line(item.index);
+      return stroked && segmentDistance(x, y, s.x1, s.y1, s.x2, s.y2) <= d;
+    }
+    case ShapeType::Polyline: {
+      const PolylineShape &s = m_list.polyline(item.index);
+      return stroked && s.pointCount > 1 &&
+             nearPoints(x, y, m_list.points(s.pointBegin), s.pointCount, s.x,
+                        s.y, false, d);
+    }
+    case ShapeType::Text:
+      break;
+  }
+  return false;
+}
+
+}  // namespace draw
+}  // namespace rectangle
@@ -0,0 +1,55 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+#include "displaylist.h"
+#include "gridindex.h"
+
+namespace rectangle {
+namespace draw {
+
+// Hit testing over the shapes of a display list. The shape bounds are
+// kept in a uniform grid, so a query only tests the shapes near it. The
+// list must not change while the index is used.
+class ShapeIndex {
+ public:
+  explicit ShapeIndex(const DisplayList &list);
+
+  // items painting (x, y), topmost first; a fill of "none" is not hit
+  std::vector<int> itemsAt(int x, int y) const;
+  // the topmost item painting (x, y), -1 if there is none
+  int topmostAt(int x, int y) const;
+  // instance which drew the topmost item at (x, y), -1 if there is none
+  int instanceAt(int x, int y) const;
+  // items whose bounds intersect r, in paint order
+  std::vector<int> itemsIn(const Rect &r) const;
+
+ private:
+  bool hits(int item, double x, double y) const;
+
+ private:
+  const DisplayList &m_list;
+  std::vector<Rect> m_bounds;
+  GridIndex m_grid;
+};
+
+}  // namespace draw
+}  // namespace rectangle
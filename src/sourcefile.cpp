@@ -36,6 +36,12 @@ SourceFile::SourceFile(const string &path) : m_path(path) {
   }
 }
 
+SourceFile::SourceFile(const string &path, const string &source)
+    : m_path(path),
+      m_valid(true),
+      m_source(source),
+      m_lines(util::splitIntoLines(source)) {}
+
 std::string SourceFile::path() const { return m_path; }
 
 std::string SourceFile::source() const { return m_source; }
@@ -26,6 +26,8 @@ namespace frontend {
 class SourceFile {
  public:
   SourceFile(const std::string &path = "");
+  // source held in memory, path is only used in messages
+  SourceFile(const std::string &path, const std::string &source);
 
   std::string path() const;
   std::string source() const;
@@ -18,6 +18,12 @@
 #include "svgpainter.h"
 
 #include <assert.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "gridindex.h"
 
 using namespace std;
 
@@ -27,7 +33,8 @@ namespace draw {
 SvgPainter::SvgPainter() { clear(); }
 
 void SvgPainter::clear() {
-  m_shapes.clear();
+  m_displayList.clear();
+  m_curInstance = -1;
   m_originStack.clear();
   m_curOrigin.x = 0;
   m_curOrigin.y = 0;
@@ -49,6 +56,12 @@ void SvgPainter::defineScene(const SceneData &d) {
   m_svgHeight = m_topMargin + m_bottomMargin + d.height;
 }
 
+void SvgPainter::load(DisplayList list, int width, int height) {
+  m_displayList = move(list);
+  m_svgWidth = width;
+  m_svgHeight = height;
+}
+
 void SvgPainter::pushOrigin(int x, int y) {
   m_curOrigin.x += x;
   m_curOrigin.y += y;
@@ -62,154 +75,510 @@ void SvgPainter::popOrigin() {
   m_originStack.pop_back();
 }
 
+void SvgPainter::setStyleMode(StyleMode mode) { m_styleMode = mode; }
+
+SvgPainter::StyleMode SvgPainter::styleMode() const { return m_styleMode; }
+
+void SvgPainter::setUseSymbols(bool useSymbols) { m_useSymbols = useSymbols; }
+
+bool SvgPainter::useSymbols() const { return m_useSymbols; }
+
+void SvgPainter::setInstance(int instance) { m_curInstance = instance; }
+
+void SvgPainter::eraseInstances(const set<int> &instances) {
+  m_displayList.filter([&instances](const DisplayItem &item) {
+    return instances.count(item.instance) == 0;
+  });
+}
+
+void SvgPainter::sortByInstance() { m_displayList.sortByInstance(); }
+
+int SvgPainter::cullOutsideScene() {
+  Rect scene{0, 0, m_svgWidth, m_svgHeight};
+  size_t count = m_displayList.items().size();
+  const DisplayList &list = m_displayList;
+  m_displayList.filter([&list, &scene](const DisplayItem &item) {
+    return list.bounds(item).intersects(scene);
+  });
+  return static_cast<int>(count - m_displayList.items().size());
+}
+
+static bool isOpaqueColor(const string &color) {
+  if (color.empty() || color == "none" || color == "transparent") {
+    return false;
+  }
+  if (color.compare(0, 4, "rgba") == 0 || color.compare(0, 4, "hsla") == 0) {
+    return false;
+  }
+  if (color[0] == '#') {
+    // #rgba and #rrggbbaa have an alpha channel
+    return color.size() == 4 || color.size() == 7;
+  }
+  return true;
+}
+
+static bool isSolidDasharray(const string &dasharray) {
+  if (dasharray.empty() || dasharray == "none") {
+    return true;
+  }
+  vector<double> values;
+  const char *p = dasharray.c_str();
+  while (*p) {
+    if (*p == ',' || *p == ' ') {
+      p++;
+      continue;
+    }
+    char *end = nullptr;
+    values.push_back(strtod(p, &end));
+    if (end == p) {
+      return false;
+    }
+    p = end;
+  }
+  // an odd count is repeated, so every value is a dash and a gap once
+  if (values.size() % 2 != 0) {
+    return false;
+  }
+  for (size_t i = 1; i < values.size(); i += 2) {
+    if (values[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// area the shape paints opaquely, false if there is none worth indexing
+static bool occluderRect(const DisplayList &list, const DisplayItem &item,
+                         Rect &r) {
+  if (item.type != ShapeType::Rectangle) {
+    return false;
+  }
+  const RectangleShape &s = list.rectangle(item.index);
+  const Style &style = list.style(s.style);
+  if (s.width <= 0 || s.height <= 0 ||
+      !isOpaqueColor(list.str(style.fillColor))) {
+    return false;
+  }
+  r = Rect{s.x, s.y, s.x + s.width, s.y + s.height};
+  if (style.strokeWidth > 1 && isOpaqueColor(list.str(style.strokeColor)) &&
+      isSolidDasharray(list.str(style.strokeDasharray))) {
+    int d = style.strokeWidth / 2;
+    r = Rect{r.left - d, r.top - d, r.right + d, r.bottom + d};
+  }
+  return true;
+}
+
+int SvgPainter::cullOccluded() {
+  const DisplayList &list = m_displayList;
+  const vector<DisplayItem> &items = list.items();
+  if (items.empty()) {
+    return 0;
+  }
+
+  vector<Rect> bounds(items.size());
+  Rect extent = list.bounds(items[0]);
+  for (size_t i = 0; i < items.size(); i++) {
+    bounds[i] = list.bounds(items[i]);
+    extent.left = min(extent.left, bounds[i].left);
+    extent.top = min(extent.top, bounds[i].top);
+    extent.right = max(extent.right, bounds[i].right);
+    extent.bottom = max(extent.bottom, bounds[i].bottom);
+  }
+
+  // walk back to front, the index holds the occluders painted later. An
+  // occluder over more than kMaxCells cells would make the walk quadratic
+  // in a scene of large rectangles, only the kMaxLarge largest of those are
+  // kept aside and checked first.
+  const int kMaxCells = 16;
+  const size_t kMaxLarge = 16;
+  int side = GridIndex::defaultSide(items.size());
+  GridIndex index(extent, side, side);
+  vector<Rect> occluders;
+  vector<Rect> large;
+  auto area = [](const Rect &r) {
+    return static_cast<long long>(r.right - r.left) * (r.bottom - r.top);
+  };
+  vector<bool> hidden(items.size(), false);
+  int hiddenCount = 0;
+  for (size_t i = items.size(); i-- > 0;) {
+    const Rect &b = bounds[i];
+    bool covered = false;
+    for (const Rect &r : large) {
+      if (r.contains(b)) {
+        covered = true;
+        break;
+      }
+    }
+    if (!covered) {
+      for (int id : index.cell(b.left, b.top)) {
+        if (occluders[static_cast<size_t>(id)].contains(b)) {
+          covered = true;
+          break;
+        }
+      }
+    }
+    if (covered) {
+      hidden[i] = true;
+      hiddenCount++;
+      continue;
+    }
+    Rect r;
+    if (!occluderRect(list, items[i], r)) {
+      continue;
+    }
+    if (index.cellCount(r) <= kMaxCells) {
+      index.insert(r, static_cast<int>(occluders.size()));
+      occluders.push_back(r);
+    } else if (large.size() < kMaxLarge) {
+      large.push_back(r);
+    } else {
+      auto smallest = min_element(
+          large.begin(), large.end(),
+          [&area](const Rect &lhs, const Rect &rhs) {
+            return area(lhs) < area(rhs);
+          });
+      if (area(*smallest) < area(r)) {
+        *smallest = r;
+      }
+    }
+  }
+
+  size_t i = 0;
+  m_displayList.filter(
+      [&hidden, &i](const DisplayItem &) { return !hidden[i++]; });
+  return hiddenCount;
+}
+
 void SvgPainter::draw(const RectangleData &d) {
-  m_shapes.emplace_back(new RectangleShape(d, m_curOrigin.x, m_curOrigin.y));
+  m_displayList.append(d, m_curOrigin.x, m_curOrigin.y, m_curInstance);
 }
 
 void SvgPainter::draw(const TextData &d) {
-  m_shapes.emplace_back(new TextShape(d, m_curOrigin.x, m_curOrigin.y));
+  m_displayList.append(d, m_curOrigin.x, m_curOrigin.y, m_curInstance);
 }
 
 void SvgPainter::draw(const EllipseData &d) {
-  m_shapes.emplace_back(new EllipseShape(d, m_curOrigin.x, m_curOrigin.y));
+  m_displayList.append(d, m_curOrigin.x, m_curOrigin.y, m_curInstance);
 }
 
 void SvgPainter::draw(const PolygonData &d) {
-  m_shapes.emplace_back(new PolygonShape(d, m_curOrigin.x, m_curOrigin.y));
+  m_displayList.append(d, m_curOrigin.x, m_curOrigin.y, m_curInstance);
 }
 
 void SvgPainter::draw(const LineData &d) {
-  m_shapes.emplace_back(new LineShape(d, m_curOrigin.x, m_curOrigin.y));
+  m_displayList.append(d, m_curOrigin.x, m_curOrigin.y, m_curInstance);
 }
 
 void SvgPainter::draw(const PolylineData &d) {
-  m_shapes.emplace_back(new PolylineShape(d, m_curOrigin.x, m_curOrigin.y));
+  m_displayList.append(d, m_curOrigin.x, m_curOrigin.y, m_curInstance);
 }
 
-std::string SvgPainter::generate() const {
-  char buf[512];
-  snprintf(buf, sizeof(buf),
-           "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" "
-           "width=\"%d\" height=\"%d\">\n",
-           m_svgWidth, m_svgHeight);
+static void generatePoints(util::OutputSink &sink, const int32_t *points,
+                           int count, int originX, int originY) {
+  const size_t maxPointLength = 2 * util::kMaxIntLength + 2;
+  for (int i = 0; i < count; i++) {
+    char *p = sink.reserve(maxPointLength);
+    p = util::formatInt(p, originX + points[2 * i]);
+    *p++ = ',';
+    p = util::formatInt(p, originY + points[2 * i + 1]);
+    *p++ = ' ';
+    sink.commit(p);
+  }
+}
+
+static void generateStyleText(util::OutputSink &sink, const DisplayList &list,
+                              const Style &style) {
+  if (style.fillColor >= 0) {
+    sink.write("fill:", 5);
+    sink.write(list.str(style.fillColor));
+    sink.write("; ", 2);
+  }
+  sink.write("stroke-width:", 13);
+  sink.writeInt(style.strokeWidth);
+  sink.write("; stroke:", 9);
+  sink.write(list.str(style.strokeColor));
+  sink.write("; stroke-dasharray:", 19);
+  sink.write(list.str(style.strokeDasharray));
+  if (style.fillRule >= 0) {
+    sink.write("; fill-rule:", 12);
+    sink.write(list.str(style.fillRule));
+  }
+}
+
+// styleClasses maps style ids to class numbers, nullptr for inline styles
+static void generateStyle(util::OutputSink &sink, const DisplayList &list,
+                          int style, const vector<int> *styleClasses) {
+  if (styleClasses) {
+    sink.write(" class=\"s", 9);
+    sink.writeInt((*styleClasses)[static_cast<size_t>(style)]);
+    sink.write("\"/>", 3);
+  } else {
+    sink.write(" style=\"", 8);
+    generateStyleText(sink, list, list.style(style));
+    sink.write("\"/>", 3);
+  }
+}
+
+// (dx, dy) is added to the coordinates of the shape
+static void generateShape(util::OutputSink &sink, const DisplayList &list,
+                          const DisplayItem &item,
+                          const vector<int> *styleClasses, int dx, int dy) {
+  switch (item.type) {
+    case ShapeType::Rectangle: {
+      const RectangleShape &s = list.rectangle(item.index);
+      sink.print("<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"",
+                 s.x + dx, s.y + dy, s.width, s.height);
+      generateStyle(sink, list, s.style, styleClasses);
+      break;
+    }
+    case ShapeType::Text: {
+      const TextShape &s = list.text(item.index);
+      sink.print(
+          "<text x=\"%d\" y=\"%d\" font-size=\"%d\" "
+          "dominant-baseline=\"text-before-edge\">",
+          s.x + dx, s.y + dy, s.size);
+      sink.write(list.str(s.text));
+      sink.write("</text>", 7);
+      break;
+    }
+    case ShapeType::Ellipse: {
+      const EllipseShape &s = list.ellipse(item.index);
+      sink.print("<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\"",
+                 s.cx + dx, s.cy + dy, s.rx, s.ry);
+      generateStyle(sink, list, s.style, styleClasses);
+      break;
+    }
+    case ShapeType::Polygon: {
+      const PolygonShape &s = list.polygon(item.index);
+      sink.write("<polygon points=\"");
+      generatePoints(sink, list.points(s.pointBegin), s.pointCount, s.x + dx,
+                     s.y + dy);
+      sink.write('"');
+      generateStyle(sink, list, s.style, styleClasses);
+      break;
+    }
+    case ShapeType::Line: {
+      const LineShape &s = list.line(item.index);
+      sink.print("<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\"", s.x1 + dx,
+                 s.y1 + dy, s.x2 + dx, s.y2 + dy);
+      generateStyle(sink, list, s.style, styleClasses);
+      break;
+    }
+    case ShapeType::Polyline: {
+      const PolylineShape &s = list.polyline(item.index);
+      sink.write("<polyline points=\"");
+      generatePoints(sink, list.points(s.pointBegin), s.pointCount, s.x + dx,
+                     s.y + dy);
+      sink.write('"');
+      generateStyle(sink, list, s.style, styleClasses);
+      break;
+    }
+  }
+}
+
+static int itemStyle(const DisplayList &list, const DisplayItem &item) {
+  switch (item.type) {
+    case ShapeType::Rectangle:
+      return list.rectangle(item.index).style;
+    case ShapeType::Ellipse:
+      return list.ellipse(item.index).style;
+    case ShapeType::Polygon:
+      return list.polygon(item.index).style;
+    case ShapeType::Line:
+      return list.line(item.index).style;
+    case ShapeType::Polyline:
+      return list.polyline(item.index).style;
+    case ShapeType::Text:
+      break;
+  }
+  return -1;
+}
+
+// the point a symbol of the shape is placed at
+static Point itemAnchor(const DisplayList &list, const DisplayItem &item) {
+  switch (item.type) {
+    case ShapeType::Rectangle:
+      return Point(list.rectangle(item.index).x, list.rectangle(item.index).y);
+    case ShapeType::Text:
+      return Point(list.text(item.index).x, list.text(item.index).y);
+    case ShapeType::Ellipse:
+      return Point(list.ellipse(item.index).cx, list.ellipse(item.index).cy);
+    case ShapeType::Polygon:
+      return Point(list.polygon(item.index).x, list.polygon(item.index).y);
+    case ShapeType::Line:
+      return Point(list.line(item.index).x1, list.line(item.index).y1);
+    case ShapeType::Polyline:
+      return Point(list.polyline(item.index).x, list.polyline(item.index).y);
+  }
+  return Point();
+}
 
-  const std::string BEGIN = buf;
-  const std::string END = "</svg>\n";
+namespace {
 
+// shapes of one instance, items [begin, end) being written
+struct InstanceRun {
+  size_t begin;
+  size_t end;
+  Point anchor;
+  int symbol = -1;
+};
+
+}  // namespace
+
+// <use> of svg 1.1 refers to its symbol through xlink:href
+static const char *xlinkNamespace(bool useSymbols) {
+  return useSymbols ? " xmlns:xlink=\"http://www.w3.org/1999/xlink\"" : "";
+}
+
+void SvgPainter::generate(util::OutputSink &sink) const {
+  sink.print(
+      "<svg xmlns=\"http://www.w3.org/2000/svg\"%s version=\"1.1\" "
+      "width=\"%d\" height=\"%d\">\n",
+      xlinkNamespace(m_useSymbols), m_svgWidth, m_svgHeight);
+  generateItems(sink, m_displayList.items());
+  sink.write("</svg>\n", 7);
+}
+
+void SvgPainter::generate(util::OutputSink &sink,
+                          const vector<DisplayItem> &items, const Rect &view,
+                          int width, int height) const {
+  sink.print(
+      "<svg xmlns=\"http://www.w3.org/2000/svg\"%s version=\"1.1\" "
+      "width=\"%d\" height=\"%d\" viewBox=\"%d %d %d %d\">\n",
+      xlinkNamespace(m_useSymbols), width, height, view.left, view.top,
+      view.right - view.left, view.bottom - view.top);
+  generateItems(sink, items);
+  sink.write("</svg>\n", 7);
+}
+
+void SvgPainter::generateItems(util::OutputSink &sink,
+                               const vector<DisplayItem> &items) const {
+  vector<int> styleClasses;
+  if (m_styleMode == StyleMode::Class) {
+    // number the styles in use by first appearance
+    styleClasses.assign(static_cast<size_t>(m_displayList.styleCount()), -1);
+    vector<int> classStyles;
+    for (auto &item : items) {
+      int style = itemStyle(m_displayList, item);
+      if (style >= 0 && styleClasses[static_cast<size_t>(style)] < 0) {
+        styleClasses[static_cast<size_t>(style)] =
+            static_cast<int>(classStyles.size());
+        classStyles.push_back(style);
+      }
+    }
+    if (!classStyles.empty()) {
+      sink.write("    <style>\n");
+      for (size_t i = 0; i < classStyles.size(); i++) {
+        sink.print("        .s%d {", static_cast<int>(i));
+        generateStyleText(sink, m_displayList,
+                          m_displayList.style(classStyles[i]));
+        sink.write("}\n", 2);
+      }
+      sink.write("    </style>\n");
+    }
+  }
+
+  const vector<int> *classes =
+      m_styleMode == StyleMode::Class ? &styleClasses : nullptr;
+
+  // Instances whose shapes are identical apart from a translation share
+  // one <symbol>, every instance is a <use> of it.
+  vector<InstanceRun> runs;
+  if (m_useSymbols) {
+    unordered_map<string, int> symbolIds;
+    vector<string> symbols;
+    vector<int> symbolUses;
+    for (size_t i = 0; i < items.size();) {
+      size_t end = i + 1;
+      while (end < items.size() && items[end].instance == items[i].instance) {
+        end++;
+      }
+      if (items[i].instance >= 0) {
+        InstanceRun run;
+        run.begin = i;
+        run.end = end;
+        run.anchor = itemAnchor(m_displayList, items[i]);
+        string text;
+        {
+          util::StringSink textSink(text);
+          for (size_t j = i; j < end; j++) {
+            textSink.write("            ", 12);
+            generateShape(textSink, m_displayList, items[j], classes,
+                          -run.anchor.x, -run.anchor.y);
+            textSink.write('\n');
+          }
+        }
+        auto it = symbolIds.find(text);
+        if (it == symbolIds.end()) {
+          it = symbolIds.emplace(text, static_cast<int>(symbols.size())).first;
+          symbols.push_back(move(text));
+          symbolUses.push_back(0);
+        }
+        run.symbol = it->second;
+        symbolUses[static_cast<size_t>(run.symbol)]++;
+        runs.push_back(run);
+      }
+      i = end;
+    }
+
+    // symbols used once are drawn in place
+    vector<int> symbolIndexes(symbols.size(), -1);
+    int symbolCount = 0;
+    for (auto &run : runs) {
+      size_t symbol = static_cast<size_t>(run.symbol);
+      if (symbolUses[symbol] < 2) {
+        run.symbol = -1;
+        continue;
+      }
+      if (symbolIndexes[symbol] < 0) {
+        if (symbolCount == 0) {
+          sink.write("    <defs>\n");
+        }
+        symbolIndexes[symbol] = symbolCount++;
+        sink.print("        <symbol id=\"u%d\" overflow=\"visible\">\n",
+                   symbolIndexes[symbol]);
+        sink.write(symbols[symbol]);
+        sink.write("        </symbol>\n");
+      }
+      run.symbol = symbolIndexes[symbol];
+    }
+    if (symbolCount > 0) {
+      sink.write("    </defs>\n");
+    }
+  }
+
+  size_t nextRun = 0;
+  for (size_t i = 0; i < items.size();) {
+    if (nextRun < runs.size() && runs[nextRun].begin == i) {
+      const InstanceRun &run = runs[nextRun++];
+      if (run.symbol >= 0) {
+        sink.print("    <use xlink:href=\"#u%d\" x=\"%d\" y=\"%d\"/>\n",
+                   run.symbol, run.anchor.x, run.anchor.y);
+        i = run.end;
+        continue;
+      }
+    }
+    sink.write("    ", 4);
+    generateShape(sink, m_displayList, items[i], classes, 0, 0);
+    sink.write('\n');
+    i++;
+  }
+}
+
+std::string SvgPainter::generate() const {
   string result;
-  result += BEGIN;
-  for (auto &shape : m_shapes) {
-    result += "    " + shape->generate() + "\n";
+  {
+    util::StringSink sink(result);
+    generate(sink);
   }
-  result += END;
   return result;
 }
 
-Shape::Shape(int originX, int originY)
-    : m_originX(originX), m_originY(originY) {}
-
-Shape::~Shape() {}
-
-RectangleShape::RectangleShape(const RectangleData &rect, int originX,
-                               int originY)
-    : Shape(originX, originY), m_data(rect) {}
-
-std::string RectangleShape::generate() {
-  char buf[512];
-  snprintf(
-      buf, sizeof(buf),
-      "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" style=\"fill:%s; "
-      "stroke-width:%d; stroke:%s; stroke-dasharray:%s\"/>",
-      m_data.x + m_originX, m_data.y + m_originY, m_data.width, m_data.height,
-      m_data.fill_color.c_str(), m_data.stroke_width,
-      m_data.stroke_color.c_str(), m_data.stroke_dasharray.c_str());
-  return string(buf);
-}
-
-TextShape::TextShape(const TextData &text, int originX, int originY)
-    : Shape(originX, originY), m_data(text) {}
-
-std::string TextShape::generate() {
-  char buf[512];
-  snprintf(buf, sizeof(buf),
-           "<text x=\"%d\" y=\"%d\" font-size=\"%d\" "
-           "dominant-baseline=\"text-before-edge\">%s</text>",
-           m_data.x + m_originX, m_data.y + m_originY, m_data.size,
-           m_data.text.c_str());
-  return string(buf);
-}
-
-EllipseShape::EllipseShape(const EllipseData &ellipse, int originX, int originY)
-    : Shape(originX, originY), m_data(ellipse) {}
-
-string EllipseShape::generate() {
-  char buf[512];
-  snprintf(buf, sizeof(buf),
-           "<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\" style=\"fill:%s; "
-           "stroke-width:%d; stroke:%s; stroke-dasharray:%s\"/>",
-           m_data.x + m_data.x_radius + m_originX,
-           m_data.y + m_data.y_radius + m_originY, m_data.x_radius,
-           m_data.y_radius, m_data.fill_color.c_str(), m_data.stroke_width,
-           m_data.stroke_color.c_str(), m_data.stroke_dasharray.c_str());
-  return string(buf);
-}
-
-PolygonShape::PolygonShape(const PolygonData &polygon, int originX, int originY)
-    : Shape(originX, originY), m_data(polygon) {}
-
-string PolygonShape::generate() {
-  string points;
-  for (auto &point : m_data.points) {
-    assert(point.size() == 2);
-    points += to_string(m_originX + m_data.x + point[0]) + "," +
-              to_string(m_originY + m_data.y + point[1]) + " ";
-  }
-  char buf[4096];
-  snprintf(buf, sizeof(buf),
-           "<polygon points=\"%s\" style=\"fill:%s; stroke-width:%d; "
-           "stroke:%s; stroke-dasharray:%s; fill-rule:%s\"/>",
-           points.c_str(), m_data.fill_color.c_str(), m_data.stroke_width,
-           m_data.stroke_color.c_str(), m_data.stroke_dasharray.c_str(),
-           m_data.fill_rule.c_str());
-  return string(buf);
-}
-
-LineShape::LineShape(const LineData &line, int originX, int originY)
-    : Shape(originX, originY), m_data(line) {}
-
-string LineShape::generate() {
-  char buf[512];
-  int x1 = m_originX + m_data.x + m_data.dx1;
-  int y1 = m_originX + m_data.y + m_data.dy1;
-  int x2 = m_originX + m_data.x + m_data.dx2;
-  int y2 = m_originX + m_data.y + m_data.dy2;
-  snprintf(buf, sizeof(buf),
-           "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" "
-           "style=\"stroke-width:%d; stroke:%s; stroke-dasharray:%s\"/>",
-           x1, y1, x2, y2, m_data.stroke_width, m_data.stroke_color.c_str(),
-           m_data.stroke_dasharray.c_str());
-  return string(buf);
-}
-
-PolylineShape::PolylineShape(const PolylineData &polyline, int originX,
-                             int originY)
-    : Shape(originX, originY), m_data(polyline) {}
-
-string PolylineShape::generate() {
-  string points;
-  for (auto &point : m_data.points) {
-    assert(point.size() == 2);
-    points += to_string(m_originX + m_data.x + point[0]) + "," +
-              to_string(m_originY + m_data.y + point[1]) + " ";
-  }
-  char buf[4096];
-  snprintf(buf, sizeof(buf),
-           "<polyline points=\"%s\" style=\"fill:none; stroke-width:%d; "
-           "stroke:%s; stroke-dasharray:%s\"/>",
-           points.c_str(), m_data.stroke_width, m_data.stroke_color.c_str(),
-           m_data.stroke_dasharray.c_str());
-  return string(buf);
-}
+const DisplayList &SvgPainter::displayList() const { return m_displayList; }
+
+int SvgPainter::width() const { return m_svgWidth; }
+
+int SvgPainter::height() const { return m_svgHeight; }
 
 }  // namespace draw
 }  // namespace rectangle
@@ -17,166 +17,56 @@
 
 #pragma once
 
-#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "displaylist.h"
+#include "outputsink.h"
+
 namespace rectangle {
 namespace draw {
 
-struct Point {
-  Point(int x_ = 0, int y_ = 0) : x(x_), y(y_) {}
-  int x;
-  int y;
-};
-
-struct SceneData {
-  int leftMargin;
-  int topMargin;
-  int rightMargin;
-  int bottomMargin;
-  int width;
-  int height;
-};
-
-struct RectangleData {
-  int x;
-  int y;
-  int width;
-  int height;
-  std::string fill_color;
-  int stroke_width;
-  std::string stroke_color;
-  std::string stroke_dasharray;
-};
-
-struct TextData {
-  int x;
-  int y;
-  int size;
-  std::string text;
-};
-
-struct EllipseData {
-  int x;
-  int y;
-  int x_radius;
-  int y_radius;
-  std::string fill_color;
-  int stroke_width;
-  std::string stroke_color;
-  std::string stroke_dasharray;
-};
-
-struct PolygonData {
-  int x;
-  int y;
-  std::vector<std::vector<int>> points;
-  std::string fill_color;
-  std::string fill_rule;
-  int stroke_width;
-  std::string stroke_color;
-  std::string stroke_dasharray;
-};
-
-struct LineData {
-  int x;
-  int y;
-  int dx1;
-  int dy1;
-  int dx2;
-  int dy2;
-  int stroke_width;
-  std::string stroke_color;
-  std::string stroke_dasharray;
-};
-
-struct PolylineData {
-  int x;
-  int y;
-  std::vector<std::vector<int>> points;
-  int stroke_width;
-  std::string stroke_color;
-  std::string stroke_dasharray;
-};
-
-class Shape {
- public:
-  Shape(int originX = 0, int originY = 0);
-  virtual ~Shape();
-  virtual std::string generate() = 0;
-
- protected:
-  int m_originX;
-  int m_originY;
-};
-
-class RectangleShape : public Shape {
- public:
-  explicit RectangleShape(const RectangleData &rect, int originX, int originY);
-  std::string generate() override;
-
- private:
-  RectangleData m_data;
-};
-
-class TextShape : public Shape {
- public:
-  explicit TextShape(const TextData &text, int originX, int originY);
-  std::string generate() override;
-
- private:
-  TextData m_data;
-};
-
-class EllipseShape : public Shape {
- public:
-  explicit EllipseShape(const EllipseData &ellipse, int originX, int originY);
-  std::string generate() override;
-
- private:
-  EllipseData m_data;
-};
-
-class PolygonShape : public Shape {
- public:
-  explicit PolygonShape(const PolygonData &polygon, int originX, int originY);
-  std::string generate() override;
-
- private:
-  PolygonData m_data;
-};
-
-class LineShape : public Shape {
- public:
-  explicit LineShape(const LineData &line, int originX, int originY);
-  std::string generate() override;
-
- private:
-  LineData m_data;
-};
-
-class PolylineShape : public Shape {
+class SvgPainter {
  public:
-  explicit PolylineShape(const PolylineData &polyline, int originX,
-                         int originY);
-  std::string generate() override;
-
- private:
-  PolylineData m_data;
-};
+  enum class StyleMode {
+    Inline,  // style="..." on every shape
+    Class    // distinct styles in a <style> block, referenced by class
+  };
 
-class SvgPainter {
  public:
   SvgPainter();
 
   void clear();
 
+  // output modes are not reset by clear()
+  void setStyleMode(StyleMode mode);
+  StyleMode styleMode() const;
+  // shapes of instances which only differ in position are written once
+  // as a <symbol>
+  void setUseSymbols(bool useSymbols);
+  bool useSymbols() const;
+
   void defineScene(const SceneData &d);
+  // replace the shapes, e.g. with a display list read from a file; width
+  // and height include the margins
+  void load(DisplayList list, int width, int height);
 
   void pushOrigin(int x, int y);
   void popOrigin();
 
+  // shapes drawn from now on belong to the instance
+  void setInstance(int instance);
+  void eraseInstances(const std::set<int> &instances);
+  // restore paint order after some instances are redrawn
+  void sortByInstance();
+
+  // drop the shapes which do not intersect the scene, returns the count
+  int cullOutsideScene();
+  // drop the shapes covered by a single later opaque rectangle, returns
+  // the count
+  int cullOccluded();
+
   void draw(const RectangleData &d);
   void draw(const TextData &d);
   void draw(const EllipseData &d);
@@ -184,10 +74,26 @@ class SvgPainter {
   void draw(const LineData &d);
   void draw(const PolylineData &d);
 
+  void generate(util::OutputSink &sink) const;
   std::string generate() const;
+  // only the given items, view of the scene is scaled to width x height
+  void generate(util::OutputSink &sink, const std::vector<DisplayItem> &items,
+                const Rect &view, int width, int height) const;
+
+  const DisplayList &displayList() const;
+  // size of the scene including the margins
+  int width() const;
+  int height() const;
+
+ private:
+  void generateItems(util::OutputSink &sink,
+                     const std::vector<DisplayItem> &items) const;
 
  private:
-  std::vector<std::unique_ptr<Shape>> m_shapes;
+  DisplayList m_displayList;
+  int m_curInstance = -1;
+  StyleMode m_styleMode = StyleMode::Inline;
+  bool m_useSymbols = false;
   std::vector<Point> m_originStack;
   Point m_curOrigin;
 
@@ -22,7 +22,6 @@
 #include <utility>
 
 #include "astnode.h"
-#include "option.h"
 #include "typeinfo.h"
 #include "util.h"
 
@@ -33,9 +32,7 @@ namespace backend {
 
 Symbol::Symbol(Category cat, const string &n, std::shared_ptr<TypeInfo> ti,
                ASTNode *ast)
-    : m_category(cat), m_name(n), m_typeInfo(ti), m_astNode(ast) {
-  util::condPrint(option::printSymbolDef, "def: %s\n", symbolString().c_str());
-}
+    : m_category(cat), m_name(n), m_typeInfo(ti), m_astNode(ast) {}
 
 Symbol::~Symbol() {}
 
@@ -20,7 +20,6 @@
 #include <assert.h>
 
 #include "builtinstruct.h"
-#include "option.h"
 #include "symbol.h"
 #include "typeinfo.h"
 #include "util.h"
@@ -32,6 +31,10 @@ namespace backend {
 
 SymbolTable::SymbolTable() { initGlobalScope(); }
 
+SymbolTable::SymbolTable(Scope *curScope) : m_curScope(curScope) {
+  assert(m_curScope != nullptr);
+}
+
 SymbolTable::~SymbolTable() {
   delete m_globalScope;
   m_globalScope = nullptr;
@@ -47,6 +50,11 @@ void SymbolTable::clear() {
   m_curScope = m_globalScope;
 }
 
+void SymbolTable::setOptions(const Options &options) {
+  m_printScopeStack = options.printScopeStack;
+  m_printSymbolDef = options.printSymbolDef;
+}
+
 Scope *SymbolTable::curScope() const { return m_curScope; }
 
 void SymbolTable::pushScope(Scope *scope) {
@@ -55,15 +63,15 @@ void SymbolTable::pushScope(Scope *scope) {
   }
 
   m_curScope = scope;
-  util::condPrint(option::printScopeStack, "pushScope: %p(%s)\n",
-                  static_cast<void *>(m_curScope),
-                  m_curScope->scopeString().c_str());
+  COND_PRINT(m_printScopeStack, "pushScope: %p(%s)\n",
+             static_cast<void *>(m_curScope),
+             m_curScope->scopeString().c_str());
 }
 
 void SymbolTable::popScope() {
-  util::condPrint(option::printScopeStack, "popScope: %p(%s)\n",
-                  static_cast<void *>(m_curScope),
-                  m_curScope->scopeString().c_str());
+  COND_PRINT(m_printScopeStack, "popScope: %p(%s)\n",
+             static_cast<void *>(m_curScope),
+             m_curScope->scopeString().c_str());
   m_curScope = m_curScope->parent();
   assert(m_curScope != nullptr);
 }
@@ -71,6 +79,13 @@ void SymbolTable::popScope() {
 void SymbolTable::define(Symbol *symbol) {
   assert(m_curScope != nullptr);
   m_curScope->define(symbol);
+  COND_PRINT(m_printSymbolDef, "def: %s\n", symbol->symbolString().c_str());
+}
+
+void SymbolTable::adoptScopes(SymbolTable *other) {
+  assert(other != nullptr && other != this);
+  m_scopes.insert(other->m_scopes.begin(), other->m_scopes.end());
+  other->m_scopes.clear();
 }
 
 void SymbolTable::initGlobalScope() {
@@ -19,6 +19,7 @@
 
 #include <set>
 
+#include "option.h"
 #include "symbol.h"
 
 namespace rectangle {
@@ -27,9 +28,13 @@ namespace backend {
 class SymbolTable {
  public:
   SymbolTable();
+  // a table working on scopes of another table, see adoptScopes()
+  explicit SymbolTable(Scope *curScope);
   ~SymbolTable();
 
   void clear();
+  // the print flags used from now on
+  void setOptions(const Options &options);
 
   Scope *curScope() const;
 
@@ -38,6 +43,9 @@ class SymbolTable {
 
   void define(Symbol *symbol);
 
+  // take ownership of the scopes created in other
+  void adoptScopes(SymbolTable *other);
+
  private:
   void initGlobalScope();
 
@@ -45,6 +53,8 @@ class SymbolTable {
   std::set<Scope *> m_scopes;
   Scope *m_globalScope = nullptr;
   Scope *m_curScope = nullptr;
+  bool m_printScopeStack = false;
+  bool m_printSymbolDef = false;
 };
 
 }  // namespace backend
@@ -26,6 +26,7 @@
 #include "exception.h"
 #include "loopdetector.h"
 #include "symboltable.h"
+#include "threadpool.h"
 #include "typeinfo.h"
 
 using namespace std;
@@ -35,17 +36,40 @@ using namespace rectangle::diag;
 namespace rectangle {
 namespace backend {
 
-SymbolVisitor::SymbolVisitor() {}
+SymbolVisitor::SymbolVisitor(const Options &options) : m_options(options) {}
 
 void SymbolVisitor::visit(AST *ast) {
+  visitDefinations(ast);
+
+  vector<DocumentDecl *> instances;
+  for (auto doc : m_ast->documents()) {
+    if (doc && doc->type == DocumentDecl::Type::Instance) {
+      instances.push_back(doc);
+    }
+  }
+
+  if (instances.size() == 0) {
+    throw SyntaxError("No instance document");
+  } else if (instances.size() > 1) {
+    throw SyntaxError("Multiple instance documents");
+  }
+
+  ComponentInstanceDecl *cid =
+      dynamic_cast<ComponentInstanceDecl *>(instances[0]);
+  assert(cid != nullptr);
+  visitTopLevelInstance(cid);
+}
+
+void SymbolVisitor::visitDefinations(AST *ast) {
   m_ast = ast;
+  m_symbolTable = m_ast->symbolTable();
+  m_symbolTable->setOptions(m_options);
   clear();
 
   auto documents = m_ast->documents();
 
   vector<DocumentDecl *> structs;
   vector<DocumentDecl *> definations;
-  vector<DocumentDecl *> instances;
 
   for (auto doc : documents) {
     if (doc) {
@@ -57,7 +81,6 @@ void SymbolVisitor::visit(AST *ast) {
           definations.push_back(doc);
           break;
         case DocumentDecl::Type::Instance:
-          instances.push_back(doc);
           break;
       }
     }
@@ -67,26 +90,41 @@ void SymbolVisitor::visit(AST *ast) {
     m_curFilePath = doc->filepath;
     visit(doc);
   }
-  for (auto doc : definations) {
-    m_curFilePath = doc->filepath;
-    visit(doc);
+  if (m_options.parallelAnalyze) {
+    vector<ComponentDefinationDecl *> cdds;
+    for (auto doc : definations) {
+      ComponentDefinationDecl *cdd =
+          dynamic_cast<ComponentDefinationDecl *>(doc);
+      assert(cdd != nullptr);
+      m_curFilePath = cdd->filepath;
+      visitComponentHeader(cdd);
+      cdds.push_back(cdd);
+    }
+    visitComponentBodies(cdds);
+  } else {
+    for (auto doc : definations) {
+      m_curFilePath = doc->filepath;
+      visit(doc);
+    }
   }
+}
 
-  if (instances.size() == 0) {
-    throw SyntaxError("No instance document");
-  } else if (instances.size() > 1) {
-    throw SyntaxError("Multiple instance documents");
-  }
+void SymbolVisitor::visitInstance(ComponentInstanceDecl *cid,
+                                  SymbolTable *table) {
+  m_symbolTable = table;
+  m_symbolTable->setOptions(m_options);
+  clear();
 
-  ComponentInstanceDecl *cid =
-      dynamic_cast<ComponentInstanceDecl *>(instances[0]);
-  assert(cid != nullptr);
+  visitTopLevelInstance(cid);
+}
+
+void SymbolVisitor::visitTopLevelInstance(ComponentInstanceDecl *cid) {
   m_topLevelInstance = cid;
 
   Scope *mainScope =
-      new Scope(Scope::Category::Function, m_ast->symbolTable()->curScope());
+      new Scope(Scope::Category::Function, m_symbolTable->curScope());
   mainScope->setScopeName("main");
-  m_ast->symbolTable()->pushScope(mainScope);
+  m_symbolTable->pushScope(mainScope);
 
   m_curFilePath = cid->filepath;
 
@@ -96,7 +134,7 @@ void SymbolVisitor::visit(AST *ast) {
 
   calculateOrderedMemberInitList();
 
-  m_ast->symbolTable()->popScope();
+  m_symbolTable->popScope();
 }
 
 void SymbolVisitor::visit(StructDecl *sd) {
@@ -105,31 +143,39 @@ void SymbolVisitor::visit(StructDecl *sd) {
   string name = sd->name;
   Symbol *sym(new ScopeSymbol(Symbol::Category::Struct, name,
                               Scope::Category::Struct,
-                              m_ast->symbolTable()->curScope()));
+                              m_symbolTable->curScope()));
   sym->setAstNode(sd);
-  m_ast->symbolTable()->define(sym);
+  m_symbolTable->define(sym);
 
-  m_ast->symbolTable()->pushScope(dynamic_cast<Scope *>(sym));
+  m_symbolTable->pushScope(dynamic_cast<Scope *>(sym));
   for (size_t i = 0; i < sd->fieldList.size(); i++) {
     visit(sd->fieldList[i].get());
     sd->fieldList[i]->fieldIndex = static_cast<int>(i);
   }
-  m_ast->symbolTable()->popScope();
+  m_symbolTable->popScope();
 }
 
 void SymbolVisitor::visit(ComponentDefinationDecl *cdd) {
   assert(cdd != nullptr);
 
+  visitComponentHeader(cdd);
+  visitComponentBody(cdd);
+}
+
+void SymbolVisitor::visitComponentHeader(ComponentDefinationDecl *cdd) {
+  assert(cdd != nullptr);
+
   string name = cdd->name;
-  Symbol *sym(new ScopeSymbol(Symbol::Category::Component, name,
-                              Scope::Category::Component,
-                              m_ast->symbolTable()->curScope()));
+  ScopeSymbol *sym(new ScopeSymbol(Symbol::Category::Component, name,
+                                   Scope::Category::Component,
+                                   m_symbolTable->curScope()));
   sym->setAstNode(cdd);
   sym->setTypeInfo(shared_ptr<TypeInfo>(new CustomTypeInfo(name)));
+  cdd->scope = sym;
 
-  m_ast->symbolTable()->define(sym);
+  m_symbolTable->define(sym);
 
-  m_ast->symbolTable()->pushScope(dynamic_cast<Scope *>(sym));
+  m_symbolTable->pushScope(sym);
 
   for (auto &e : cdd->enumList) {
     visit(e.get());
@@ -142,28 +188,81 @@ void SymbolVisitor::visit(ComponentDefinationDecl *cdd) {
     visitPropertyDefination(p.get());
   }
 
+  for (auto &f : cdd->methodList) {
+    visitMethodHeader(f.get());
+  }
+
+  m_symbolTable->popScope();
+}
+
+void SymbolVisitor::visitComponentBody(ComponentDefinationDecl *cdd) {
+  assert(cdd != nullptr);
+  assert(cdd->scope != nullptr);
+
+  m_symbolTable->pushScope(cdd->scope);
+
   for (auto &p : cdd->propertyList) {
     visitPropertyInitialization(p.get());
   }
 
-  for (auto &f : cdd->methodList) {
-    visitMethodHeader(f.get());
-  }
   for (auto &f : cdd->methodList) {
     visitMethodBody(f.get());
   }
 
-  m_ast->symbolTable()->popScope();
+  m_symbolTable->popScope();
+}
+
+void SymbolVisitor::visitComponentBodies(
+    const vector<ComponentDefinationDecl *> &cdds) {
+  // Once all headers are declared, the bodies only read the shared scopes
+  // and write to nodes of their own component, so they are checked on a
+  // thread pool. Each body gets its own visitor and symbol table; the
+  // created scopes and the first error are merged in document order.
+  size_t n = cdds.size();
+  if (n == 0) {
+    return;
+  }
+  vector<unique_ptr<SymbolTable>> tables(n);
+  vector<unique_ptr<SyntaxError>> errors(n);
+
+  ThreadPool pool(static_cast<int>(min(
+      n, static_cast<size_t>(ThreadPool::defaultThreadCount()))));
+  pool.parallelFor(static_cast<int>(n), [&](int i) {
+    size_t index = static_cast<size_t>(i);
+    ComponentDefinationDecl *cdd = cdds[index];
+    tables[index].reset(new SymbolTable(m_symbolTable->curScope()));
+    tables[index]->setOptions(m_options);
+
+    SymbolVisitor worker(m_options);
+    worker.m_ast = m_ast;
+    worker.m_symbolTable = tables[index].get();
+    worker.clear();
+    worker.m_curFilePath = cdd->filepath;
+    try {
+      worker.visitComponentBody(cdd);
+    } catch (SyntaxError &e) {
+      errors[index].reset(new SyntaxError(e));
+    }
+  });
+
+  for (auto &table : tables) {
+    m_symbolTable->adoptScopes(table.get());
+  }
+  for (auto &error : errors) {
+    if (error) {
+      throw *error;
+    }
+  }
 }
 
 void SymbolVisitor::visit(ComponentInstanceDecl *cid) {
   assert(cid != nullptr);
 
   Scope *instanceScope =
-      new Scope(Scope::Category::Instance, m_ast->symbolTable()->curScope());
+      new Scope(Scope::Category::Instance, m_symbolTable->curScope());
   instanceScope->setScopeName(cid->instanceId);
   Symbol *componentSymbol =
-      m_ast->symbolTable()->curScope()->resolve(cid->componentName);
+      m_symbolTable->curScope()->resolve(cid->componentName);
   if (!componentSymbol) {
     string msg = "No component named \"" + cid->componentName + "\"";
     throw SyntaxError(msg, cid->token(), m_curFilePath);
@@ -179,13 +278,13 @@ void SymbolVisitor::visit(ComponentInstanceDecl *cid) {
   assert(cdd != nullptr);
   cid->componentDefination = cdd;
 
-  m_ast->symbolTable()->pushScope(instanceScope);
+  m_symbolTable->pushScope(instanceScope);
   if (cid->parent) {
     Symbol *parentSymbol = new Symbol(
         Symbol::Category::InstanceId, "parent",
         shared_ptr<TypeInfo>(new CustomTypeInfo(cid->parent->componentName)),
         cid->parent);
-    m_ast->symbolTable()->define(parentSymbol);
+    m_symbolTable->define(parentSymbol);
   }
 
   pushInstanceStack(cid);
@@ -197,7 +296,7 @@ void SymbolVisitor::visit(ComponentInstanceDecl *cid) {
   }
   popInstanceStack();
 
-  m_ast->symbolTable()->popScope();
+  m_symbolTable->popScope();
 }
 
 static string bindingId(const string &instanceId, int fieldIndex) {
@@ -227,10 +326,10 @@ void SymbolVisitor::calculateOrderedMemberInitList() {
     seq2instance[seq] = cid;
     seq2filepath[seq] = m_topLevelInstance->filepath;
 
-    util::condPrint(option::printBindingDep, "binding: filepath [%d] %s\n", seq,
-                    m_topLevelInstance->filepath.c_str());
-    util::condPrint(option::printBindingDep, "binding: seq [%d] %s(%p)\n", seq,
-                    id.c_str(), astNode);
+    COND_PRINT(m_options.printBindingDep, "binding: filepath [%d] %s\n",
+               seq, m_topLevelInstance->filepath.c_str());
+    COND_PRINT(m_options.printBindingDep, "binding: seq [%d] %s(%p)\n",
+               seq, id.c_str(), astNode);
   }
 
   vector<ComponentInstanceDecl *> instances =
@@ -251,15 +350,16 @@ void SymbolVisitor::calculateOrderedMemberInitList() {
       seq2instance[seq] = instance;
       seq2filepath[seq] = cdd->filepath;
 
-      util::condPrint(option::printBindingDep, "binding: filepath [%d] %s\n",
-                      seq, cdd->filepath.c_str());
-      util::condPrint(option::printBindingDep, "binding: seq [%d] %s(%p)\n",
-                      seq, id.c_str(), astNode);
+      COND_PRINT(m_options.printBindingDep, "binding: filepath [%d] %s\n",
+                 seq, cdd->filepath.c_str());
+      COND_PRINT(m_options.printBindingDep, "binding: seq [%d] %s(%p)\n",
+                 seq, id.c_str(), astNode);
     }
   }
 
   TopologicalSorter sorter(static_cast<int>(id2seq.size()));
   LoopDetector detector;
+  vector<pair<int, int>> edges;
 
   for (auto &p : m_bindingIdDeps) {
     string fromId = p.first;
@@ -274,9 +374,10 @@ void SymbolVisitor::calculateOrderedMemberInitList() {
 
     sorter.addEdge(fromSeq, toSeq);
     detector.addEdge(fromSeq, toSeq);
-    util::condPrint(option::printBindingDep,
-                    "binding: edge %d -> %d(%s -> %s)\n", fromSeq, toSeq,
-                    fromId.c_str(), toId.c_str());
+    edges.emplace_back(fromSeq, toSeq);
+    COND_PRINT(m_options.printBindingDep,
+               "binding: edge %d -> %d(%s -> %s)\n", fromSeq, toSeq,
+               fromId.c_str(), toId.c_str());
   }
 
   for (auto instance : instances) {
@@ -296,9 +397,10 @@ void SymbolVisitor::calculateOrderedMemberInitList() {
         int toSeq = toIter->second;
 
         sorter.addEdge(fromSeq, toSeq);
-        util::condPrint(option::printBindingDep,
-                        "binding: edge %d -> %d(%s -> %s)\n", fromSeq, toSeq,
-                        fromId.c_str(), toId.c_str());
+        edges.emplace_back(fromSeq, toSeq);
+        COND_PRINT(m_options.printBindingDep,
+                   "binding: edge %d -> %d(%s -> %s)\n", fromSeq, toSeq,
+                   fromId.c_str(), toId.c_str());
       }
     }
   }
@@ -313,6 +415,18 @@ void SymbolVisitor::calculateOrderedMemberInitList() {
                       seq2astNode[node]->token(), seq2filepath[node]);
   }
 
+  map<int, int> seq2order;
+  for (int i = 0; i < static_cast<int>(order.size()); i++) {
+    seq2order[order[static_cast<size_t>(i)]] = i;
+  }
+  m_topLevelInstance->orderedMemberInitDeps.resize(order.size());
+  for (auto &e : edges) {
+    int from = seq2order[e.first];
+    int to = seq2order[e.second];
+    m_topLevelInstance->orderedMemberInitDeps[static_cast<size_t>(from)]
+        .insert(to);
+  }
+
   for (int i = 0; i < static_cast<int>(order.size()); i++) {
     int seq = order[static_cast<size_t>(i)];
     string id = seq2id[seq];
@@ -320,9 +434,9 @@ void SymbolVisitor::calculateOrderedMemberInitList() {
     ComponentInstanceDecl *cid = seq2instance[seq];
     m_topLevelInstance->orderedMemberInitList.push_back(
         make_pair(cid, astNode));
-    util::condPrint(option::printBindingDep,
-                    "binding: order [%d] [%d] %s(%p)\n", i, seq, id.c_str(),
-                    astNode);
+    COND_PRINT(m_options.printBindingDep,
+               "binding: order [%d] [%d] %s(%p)\n", i, seq, id.c_str(),
+               astNode);
   }
 }
 
@@ -333,7 +447,7 @@ void SymbolVisitor::visit(BindingDecl *bd) {
     return;
   }
 
-  Scope *componentScope = m_ast->symbolTable()->curScope()->componentScope();
+  Scope *componentScope = m_symbolTable->curScope()->componentScope();
   assert(componentScope != nullptr);
   Symbol *componentSymbol = dynamic_cast<Symbol *>(componentScope);
   assert(componentSymbol != nullptr);
@@ -360,7 +474,7 @@ void SymbolVisitor::visit(BindingDecl *bd) {
 int SymbolVisitor::visitInstanceIndex(ComponentInstanceDecl *cid) {
   assert(cid != nullptr);
 
-  cid->scope = m_ast->symbolTable()->curScope();
+  cid->scope = m_symbolTable->curScope();
   assert(cid->scope != nullptr);
 
   cid->instanceIndex = m_nextInstanceIndex++;
@@ -407,6 +521,8 @@ void SymbolVisitor::visitInstanceId(ComponentInstanceDecl *cid) {
       Symbol::Category::InstanceId, id,
       shared_ptr<TypeInfo>(new CustomTypeInfo(cid->componentName)), cid);
   mainScope->define(symbol);
+  COND_PRINT(m_options.printSymbolDef, "def: %s\n",
+             symbol->symbolString().c_str());
 
   for (auto &c : cid->childrenList) {
     visitInstanceId(c.get());
@@ -632,9 +748,9 @@ void SymbolVisitor::visit(UnaryOperatorExpr *u) {
 void SymbolVisitor::visit(CallExpr *e) {
   assert(e != nullptr);
 
-  e->scope = m_ast->symbolTable()->curScope();
+  e->scope = m_symbolTable->curScope();
 
-  if (m_ast->symbolTable()->curScope()->category() != Scope::Category::Local) {
+  if (m_symbolTable->curScope()->category() != Scope::Category::Local) {
     const string msg = "CallExpr can only be used in a function";
     throw SyntaxError(msg, e->token(), m_curFilePath);
   }
@@ -647,7 +763,7 @@ void SymbolVisitor::visit(CallExpr *e) {
     assert(r != nullptr);
     visit(r);
 
-    Symbol *func = m_ast->symbolTable()->curScope()->resolve(r->name);
+    Symbol *func = m_symbolTable->curScope()->resolve(r->name);
     if (!func) {
       const string msg = "No function named \"" + r->name + "\"";
       throw SyntaxError(msg, e->token(), m_curFilePath);
@@ -668,8 +784,8 @@ void SymbolVisitor::visit(CallExpr *e) {
       throw SyntaxError(msg, e->token(), m_curFilePath);
     }
 
-    util::condPrint(option::printSymbolRef, "ref: %s\n",
-                    func->symbolString().c_str());
+    COND_PRINT(m_options.printSymbolRef, "ref: %s\n",
+               func->symbolString().c_str());
     e->funcExpr->typeInfo = func->typeInfo();
   } else if (e->funcExpr->category == Expr::Category::Member) {
     MemberExpr *m = dynamic_cast<MemberExpr *>(e->funcExpr.get());
@@ -684,7 +800,7 @@ void SymbolVisitor::visit(CallExpr *e) {
     }
 
     Symbol *instanceTypeSymbol =
-        m_ast->symbolTable()->curScope()->resolve(typeName);
+        m_symbolTable->curScope()->resolve(typeName);
     if (!instanceTypeSymbol) {
       const string msg = "No type named \"" + typeName + "\"";
       throw SyntaxError(msg, m->instanceExpr->token(), m_curFilePath);
@@ -715,8 +831,8 @@ void SymbolVisitor::visit(CallExpr *e) {
       throw SyntaxError(msg, m->token(), m_curFilePath);
     }
 
-    util::condPrint(option::printSymbolRef, "ref: %s\n",
-                    method->symbolString().c_str());
+    COND_PRINT(m_options.printSymbolRef, "ref: %s\n",
+               method->symbolString().c_str());
     e->funcExpr->typeInfo = method->typeInfo();
   } else {
     const string msg = "Only f(...) and obj.f(...) is valid";
@@ -780,7 +896,7 @@ void SymbolVisitor::visit(ListSubscriptExpr *e) {
 void SymbolVisitor::visit(MemberExpr *e) {
   assert(e != nullptr);
 
-  e->scope = m_ast->symbolTable()->curScope();
+  e->scope = m_symbolTable->curScope();
 
   visit(e->instanceExpr.get());
 
@@ -789,7 +905,7 @@ void SymbolVisitor::visit(MemberExpr *e) {
 
   Symbol *instanceTypeSymbol;
   if (instanceTypeInfo->category() == TypeInfo::Category::Custom) {
-    instanceTypeSymbol = m_ast->symbolTable()->curScope()->resolve(typeString);
+    instanceTypeSymbol = m_symbolTable->curScope()->resolve(typeString);
     if (!instanceTypeSymbol) {
       const string msg = "No type named \"" + typeString + "\"";
       throw SyntaxError(msg, e->instanceExpr->token(), m_curFilePath);
@@ -816,8 +932,8 @@ void SymbolVisitor::visit(MemberExpr *e) {
     throw SyntaxError(msg, e->token(), m_curFilePath);
   }
 
-  util::condPrint(option::printSymbolRef, "ref: %s\n",
-                  memberSymbol->symbolString().c_str());
+  COND_PRINT(m_options.printSymbolRef, "ref: %s\n",
+             memberSymbol->symbolString().c_str());
   e->typeInfo = memberSymbol->typeInfo();
 
   if (memberSymbol->category() == Symbol::Category::Property &&
@@ -829,8 +945,8 @@ void SymbolVisitor::visit(MemberExpr *e) {
     componentDefinationAnalyzing()
         ->propertyDeps[propertyIndexAnalyzing()]
         .insert(pd->fieldIndex);
-    util::condPrint(option::printPropertyDep, "property: [%d] -> [%d]\n",
-                    propertyIndexAnalyzing(), pd->fieldIndex);
+    COND_PRINT(m_options.printPropertyDep, "property: [%d] -> [%d]\n",
+               propertyIndexAnalyzing(), pd->fieldIndex);
   }
 
   if (analyzingBindingDep()) {
@@ -839,10 +955,10 @@ void SymbolVisitor::visit(MemberExpr *e) {
       PropertyDecl *pd = dynamic_cast<PropertyDecl *>(ast);
       assert(pd != nullptr);
 
-      util::condPrint(
-          option::printBindingDep, "binding: %s[%d](%p) -> %s[%d]\n",
-          curInstanceId().c_str(), bindingIndexAnalyzing(), bindingAnalyzing(),
-          m_curAnalyzingBindingToId.c_str(), pd->fieldIndex);
+      COND_PRINT(m_options.printBindingDep, "binding: %s[%d](%p) -> %s[%d]\n",
+                 curInstanceId().c_str(), bindingIndexAnalyzing(),
+                 bindingAnalyzing(), m_curAnalyzingBindingToId.c_str(),
+                 pd->fieldIndex);
       m_bindingIdDeps.push_back(pair<string, string>(
           bindingId(curInstanceId(), bindingIndexAnalyzing()),
           bindingId(m_curAnalyzingBindingToId, pd->fieldIndex)));
@@ -853,16 +969,16 @@ void SymbolVisitor::visit(MemberExpr *e) {
 void SymbolVisitor::visit(RefExpr *e) {
   assert(e != nullptr);
 
-  e->scope = m_ast->symbolTable()->curScope();
+  e->scope = m_symbolTable->curScope();
 
-  Symbol *sym = m_ast->symbolTable()->curScope()->resolve(e->name);
+  Symbol *sym = m_symbolTable->curScope()->resolve(e->name);
   if (!sym) {
     const string msg = "No symbol named \"" + e->name + "\"";
     throw SyntaxError(msg, e->token(), m_curFilePath);
   }
 
-  util::condPrint(option::printSymbolRef, "ref: %s\n",
-                  sym->symbolString().c_str());
+  COND_PRINT(m_options.printSymbolRef, "ref: %s\n",
+             sym->symbolString().c_str());
   e->typeInfo = sym->typeInfo();
 
   if (sym->category() == Symbol::Category::Property && analyzingPropertyDep()) {
@@ -873,8 +989,8 @@ void SymbolVisitor::visit(RefExpr *e) {
     componentDefinationAnalyzing()
         ->propertyDeps[propertyIndexAnalyzing()]
         .insert(pd->fieldIndex);
-    util::condPrint(option::printPropertyDep, "property: [%d] -> [%d]\n",
-                    propertyIndexAnalyzing(), pd->fieldIndex);
+    COND_PRINT(m_options.printPropertyDep, "property: [%d] -> [%d]\n",
+               propertyIndexAnalyzing(), pd->fieldIndex);
   }
 
   if (analyzingBindingDep()) {
@@ -883,10 +999,9 @@ void SymbolVisitor::visit(RefExpr *e) {
       PropertyDecl *pd = dynamic_cast<PropertyDecl *>(ast);
       assert(pd != nullptr);
 
-      util::condPrint(
-          option::printBindingDep, "binding: %s[%d](%p) -> %s[%d]\n",
-          curInstanceId().c_str(), bindingIndexAnalyzing(), bindingAnalyzing(),
-          curInstanceId().c_str(), pd->fieldIndex);
+      COND_PRINT(m_options.printBindingDep, "binding: %s[%d](%p) -> %s[%d]\n",
+                 curInstanceId().c_str(), bindingIndexAnalyzing(),
+                 bindingAnalyzing(), curInstanceId().c_str(), pd->fieldIndex);
       m_bindingIdDeps.push_back(pair<string, string>(
           bindingId(curInstanceId(), bindingIndexAnalyzing()),
           bindingId(curInstanceId(), pd->fieldIndex)));
@@ -903,15 +1018,15 @@ void SymbolVisitor::visit(RefExpr *e) {
 void SymbolVisitor::visit(VarDecl *vd) {
   assert(vd != nullptr);
 
-  vd->scope = m_ast->symbolTable()->curScope();
+  vd->scope = m_symbolTable->curScope();
 
   Symbol *variableSym =
       new Symbol(Symbol::Category::Variable, vd->name, vd->type, vd);
-  m_ast->symbolTable()->define(variableSym);
+  m_symbolTable->define(variableSym);
 
   if (vd->type->category() == TypeInfo::Category::Custom) {
     Symbol *typeSymbol =
-        m_ast->symbolTable()->curScope()->resolve(vd->type->toString());
+        m_symbolTable->curScope()->resolve(vd->type->toString());
     if (!typeSymbol) {
       // FIXME
       const string msg = "No type named \"" + vd->type->toString() + "\"";
@@ -938,8 +1053,8 @@ void SymbolVisitor::visit(VarDecl *vd) {
   vd->localIndex = m_stackFrameLocals;
   m_stackFrameLocals++;
 
-  util::condPrint(option::printGenAsm, "genAsm: localIndex [%d] %s\n",
-                  vd->localIndex, vd->name.c_str());
+  COND_PRINT(m_options.printGenAsm, "genAsm: localIndex [%d] %s\n",
+             vd->localIndex, vd->name.c_str());
 
   if (vd->expr) {
     visit(vd->expr.get());
@@ -958,7 +1073,7 @@ void SymbolVisitor::visit(FieldDecl *md) {
 
   string name = md->name;
   Symbol *sym = new Symbol(Symbol::Category::Field, name, md->type, md);
-  m_ast->symbolTable()->define(sym);
+  m_symbolTable->define(sym);
 }
 
 void SymbolVisitor::visitPropertyDefination(PropertyDecl *pd) {
@@ -967,10 +1082,10 @@ void SymbolVisitor::visitPropertyDefination(PropertyDecl *pd) {
   string propertyName = pd->name;
   Symbol *propertySym =
       new Symbol(Symbol::Category::Property, propertyName, pd->type, pd);
-  m_ast->symbolTable()->define(propertySym);
+  m_symbolTable->define(propertySym);
 
-  util::condPrint(option::printPropertyDep, "property: [%d] %s\n",
-                  pd->fieldIndex, propertySym->symbolString().c_str());
+  COND_PRINT(m_options.printPropertyDep, "property: [%d] %s\n",
+             pd->fieldIndex, propertySym->symbolString().c_str());
 }
 
 void SymbolVisitor::visitPropertyInitialization(PropertyDecl *pd) {
@@ -988,21 +1103,21 @@ void SymbolVisitor::visit(ParamDecl *pd) {
 
   Symbol *paramSym =
       new Symbol(Symbol::Category::Parameter, pd->name, pd->type, pd);
-  m_ast->symbolTable()->define(paramSym);
+  m_symbolTable->define(paramSym);
 }
 
 void SymbolVisitor::visit(CompoundStmt *cs) {
   assert(cs != nullptr);
 
   Scope *localScope(
-      new Scope(Scope::Category::Local, m_ast->symbolTable()->curScope()));
-  m_ast->symbolTable()->pushScope(localScope);
+      new Scope(Scope::Category::Local, m_symbolTable->curScope()));
+  m_symbolTable->pushScope(localScope);
 
   for (auto &s : cs->stmtList) {
     visit(s.get());
   }
 
-  m_ast->symbolTable()->popScope();
+  m_symbolTable->popScope();
 }
 
 void SymbolVisitor::visit(DeclStmt *ds) {
@@ -1054,9 +1169,9 @@ void SymbolVisitor::visit(ExprStmt *es) {
 void SymbolVisitor::visitMethodHeader(FunctionDecl *fd) {
   assert(fd != nullptr);
 
-  fd->scope = m_ast->symbolTable()->curScope();
+  fd->scope = m_symbolTable->curScope();
 
-  Scope *componentScope = m_ast->symbolTable()->curScope();
+  Scope *componentScope = m_symbolTable->curScope();
   Symbol *componentSymbol = dynamic_cast<Symbol *>(componentScope);
   assert(componentSymbol);
 
@@ -1067,16 +1182,16 @@ void SymbolVisitor::visitMethodHeader(FunctionDecl *fd) {
 
   Symbol *methodSym(
       new MethodSymbol(fd->name, fd->returnType, componentSymbol, paramTypes));
-  m_ast->symbolTable()->define(methodSym);
+  m_symbolTable->define(methodSym);
 }
 
 void SymbolVisitor::visitMethodBody(FunctionDecl *fd) {
   assert(fd != nullptr);
 
   Scope *methodScope(
-      new Scope(Scope::Category::Method, m_ast->symbolTable()->curScope()));
+      new Scope(Scope::Category::Method, m_symbolTable->curScope()));
   methodScope->setScopeName(fd->name);
-  m_ast->symbolTable()->pushScope(methodScope);
+  m_symbolTable->pushScope(methodScope);
 
   for (size_t i = 0; i < fd->paramList.size(); i++) {
     visit(fd->paramList[i].get());
@@ -1092,9 +1207,8 @@ void SymbolVisitor::visitMethodBody(FunctionDecl *fd) {
   }
 
   for (size_t i = 0; i < fd->paramList.size(); i++) {
-    util::condPrint(option::printGenAsm, "genAsm: localIndex [%d] %s\n",
-                    fd->paramList[i]->localIndex,
-                    fd->paramList[i]->name.c_str());
+    COND_PRINT(m_options.printGenAsm, "genAsm: localIndex [%d] %s\n",
+               fd->paramList[i]->localIndex, fd->paramList[i]->name.c_str());
   }
 
   m_stackFrameLocals = args;
@@ -1103,7 +1217,7 @@ void SymbolVisitor::visitMethodBody(FunctionDecl *fd) {
   int locals = m_stackFrameLocals - args;
   fd->locals = locals;
 
-  m_ast->symbolTable()->popScope();
+  m_symbolTable->popScope();
 }
 
 void SymbolVisitor::visit(EnumConstantDecl *ecd) {
@@ -1112,7 +1226,7 @@ void SymbolVisitor::visit(EnumConstantDecl *ecd) {
   Symbol *enumConstantSym =
       new Symbol(Symbol::Category::EnumConstants, ecd->name,
                  make_shared<TypeInfo>(TypeInfo::Category::Int), ecd);
-  m_ast->symbolTable()->define(enumConstantSym);
+  m_symbolTable->define(enumConstantSym);
 }
 
 void SymbolVisitor::visit(EnumDecl *ed) {
@@ -1120,7 +1234,7 @@ void SymbolVisitor::visit(EnumDecl *ed) {
 
   Symbol *enumSym = new Symbol(Symbol::Category::Enum, ed->name,
                                std::shared_ptr<TypeInfo>(), ed);
-  m_ast->symbolTable()->define(enumSym);
+  m_symbolTable->define(enumSym);
 
   for (size_t i = 0; i < ed->constantList.size(); i++) {
     ed->constantList[i]->value = static_cast<int>(i);
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "asmtext.h"
+#include "option.h"
 #include "symbol.h"
 #include "topologicalsorter.h"
 #include "visitor.h"
@@ -27,9 +28,15 @@ namespace backend {
 
 class SymbolVisitor : public Visitor {
  public:
-  SymbolVisitor();
+  explicit SymbolVisitor(const Options &options = Options());
 
   void visit(AST *ast);
+  // only the struct and component documents of ast
+  void visitDefinations(AST *ast);
+  // cid against definations visited before. The scopes created go to table,
+  // which works on their global scope, so instances may be visited on
+  // several threads at once.
+  void visitInstance(ComponentInstanceDecl *cid, SymbolTable *table);
 
  protected:
   void visit(Expr *e) override { Visitor::visit(e); }
@@ -37,7 +44,11 @@ class SymbolVisitor : public Visitor {
   void visit(DocumentDecl *dd) override { Visitor::visit(dd); }
   void visit(StructDecl *sd) override;
   void visit(ComponentDefinationDecl *cdd) override;
+  void visitComponentHeader(ComponentDefinationDecl *cdd);
+  void visitComponentBody(ComponentDefinationDecl *cdd);
+  void visitComponentBodies(const std::vector<ComponentDefinationDecl *> &cdds);
   void visit(ComponentInstanceDecl *cid) override;
+  void visitTopLevelInstance(ComponentInstanceDecl *cid);
   void calculateOrderedMemberInitList();
   void visit(BindingDecl *bd) override;
   int visitInstanceIndex(ComponentInstanceDecl *cid);
@@ -107,7 +118,9 @@ class SymbolVisitor : public Visitor {
   BindingDecl *m_bindingAnalyzing = nullptr;
   std::vector<ComponentInstanceDecl *> m_instanceStack;
 
+  Options m_options;
   AST *m_ast = nullptr;
+  SymbolTable *m_symbolTable = nullptr;
   int m_stackFrameLocals = -1;
 
   int m_nextInstanceIndex = -1;
@@ -0,0 +1,215 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "threadpool.h"
+
+#include <assert.h>
+
+using namespace std;
+
+namespace rectangle {
+namespace util {
+
+namespace {
+
+// the pool and queue of the current thread if it is a worker
+thread_local ThreadPool *t_pool = nullptr;
+thread_local size_t t_worker = 0;
+
+}  // namespace
+
+struct ThreadPool::Batch {
+  std::mutex mutex;
+  std::condition_variable done;
+  int remaining;
+};
+
+ThreadPool::ThreadPool(int threadCount) : m_queued(0), m_stolen(0) {
+  if (threadCount <= 0) {
+    threadCount = defaultThreadCount();
+  }
+  for (int i = 0; i < threadCount; i++) {
+    m_workers.emplace_back(new Worker);
+  }
+  for (int i = 0; i < threadCount; i++) {
+    m_threads.emplace_back(&ThreadPool::workerLoop, this,
+                           static_cast<size_t>(i));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_taskCond.notify_all();
+  for (auto &t : m_threads) {
+    t.join();
+  }
+}
+
+int ThreadPool::threadCount() const {
+  return static_cast<int>(m_threads.size());
+}
+
+void ThreadPool::submit(const function<void()> &task) {
+  size_t worker = 0;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    worker = m_nextWorker++ % m_workers.size();
+  }
+  push(worker, task);
+}
+
+void ThreadPool::wait() {
+  unique_lock<mutex> lock(m_mutex);
+  m_idleCond.wait(lock, [this] { return m_unfinished == 0; });
+}
+
+void ThreadPool::parallelFor(int n, const function<void(int)> &task) {
+  if (n <= 0) {
+    return;
+  }
+  Batch batch;
+  batch.remaining = n;
+  size_t workerCount = m_workers.size();
+  for (int i = 0; i < n; i++) {
+    size_t worker =
+        static_cast<size_t>(i) * workerCount / static_cast<size_t>(n);
+    push(worker,
+         [&task, &batch, i] {
+           task(i);
+           // notified with the lock held, batch is gone once it is released
+           lock_guard<mutex> lock(batch.mutex);
+           if (--batch.remaining == 0) {
+             batch.done.notify_all();
+           }
+         },
+         &batch);
+  }
+
+  // only tasks of this batch, another task may wait for the caller
+  Task queued;
+  while (take(&batch, queued)) {
+    run(queued);
+  }
+  // the rest of the batch is running on other threads
+  unique_lock<mutex> lock(batch.mutex);
+  batch.done.wait(lock, [&batch] { return batch.remaining == 0; });
+}
+
+int ThreadPool::stolenCount() const { return m_stolen; }
+
+int ThreadPool::defaultThreadCount() {
+  int n = static_cast<int>(thread::hardware_concurrency());
+  return n > 0 ? n : 1;
+}
+
+void ThreadPool::push(size_t worker, const function<void()> &task,
+                      const Batch *batch) {
+  // counted first, so that wait() can not see zero before the task ran
+  {
+    lock_guard<mutex> lock(m_mutex);
+    assert(!m_stop);
+    m_queued++;
+    m_unfinished++;
+  }
+  {
+    lock_guard<mutex> lock(m_workers[worker]->mutex);
+    m_workers[worker]->tasks.push_back(Task{task, batch});
+  }
+  m_taskCond.notify_one();
+}
+
+bool ThreadPool::pop(size_t worker, Task &task) {
+  Worker &w = *m_workers[worker];
+  lock_guard<mutex> lock(w.mutex);
+  if (w.tasks.empty()) {
+    return false;
+  }
+  task = move(w.tasks.front());
+  w.tasks.pop_front();
+  m_queued--;
+  return true;
+}
+
+bool ThreadPool::steal(size_t worker, Task &task) {
+  for (size_t i = 1; i < m_workers.size(); i++) {
+    Worker &victim = *m_workers[(worker + i) % m_workers.size()];
+    lock_guard<mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      // take from the other end than the owner does
+      task = move(victim.tasks.back());
+      victim.tasks.pop_back();
+      m_queued--;
+      m_stolen++;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::take(const Batch *batch, Task &task) {
+  bool worker = t_pool == this;
+  size_t first = worker ? t_worker : 0;
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    Worker &w = *m_workers[(first + i) % m_workers.size()];
+    lock_guard<mutex> lock(w.mutex);
+    for (auto it = w.tasks.rbegin(); it != w.tasks.rend(); ++it) {
+      if (it->batch == batch) {
+        task = move(*it);
+        w.tasks.erase(next(it).base());
+        m_queued--;
+        if (worker && i > 0) {
+          m_stolen++;
+        }
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void ThreadPool::run(Task &task) {
+  task.run();
+  lock_guard<mutex> lock(m_mutex);
+  if (--m_unfinished == 0) {
+    m_idleCond.notify_all();
+  }
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+  t_pool = this;
+  t_worker = worker;
+  while (true) {
+    Task task;
+    if (pop(worker, task) || steal(worker, task)) {
+      run(task);
+      continue;
+    }
+
+    unique_lock<mutex> lock(m_mutex);
+    m_taskCond.wait(lock, [this] { return m_stop || m_queued > 0; });
+    if (m_stop && m_queued == 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace util
+}  // namespace rectangle
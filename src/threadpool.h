@@ -0,0 +1,95 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rectangle {
+namespace util {
+
+// Work stealing pool: every worker has its own task queue and takes
+// tasks from the queues of the others when it runs out.
+class ThreadPool {
+ public:
+  // threadCount <= 0 means one thread per hardware thread
+  explicit ThreadPool(int threadCount = 0);
+  ~ThreadPool();
+
+  int threadCount() const;
+
+  void submit(const std::function<void()> &task);
+  // waits for every task of the pool, including those of other callers
+  void wait();
+
+  // Run task(0) ... task(n - 1) on the pool and wait for these tasks only.
+  // Every worker starts with a contiguous block of indexes. The calling
+  // thread runs the queued tasks of the call while it waits, so
+  // parallelFor may be called from a task of the same pool.
+  void parallelFor(int n, const std::function<void(int)> &task);
+
+  // tasks run by worker threads other than the owner of the queue
+  int stolenCount() const;
+
+  static int defaultThreadCount();
+
+ private:
+  // the tasks of one parallelFor call
+  struct Batch;
+  struct Task {
+    std::function<void()> run;
+    // null for the tasks of submit()
+    const Batch *batch;
+  };
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void push(size_t worker, const std::function<void()> &task,
+            const Batch *batch = nullptr);
+  bool pop(size_t worker, Task &task);
+  bool steal(size_t worker, Task &task);
+  // a queued task of batch from any queue, for the thread waiting for it
+  bool take(const Batch *batch, Task &task);
+  void run(Task &task);
+  void workerLoop(size_t worker);
+
+ private:
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_taskCond;
+  std::condition_variable m_idleCond;
+  // queued is only increased with m_mutex held
+  std::atomic<int> m_queued;
+  int m_unfinished = 0;
+  std::atomic<int> m_stolen;
+  size_t m_nextWorker = 0;
+  bool m_stop = false;
+};
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,207 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "tiledsvgwriter.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include "outputsink.h"
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+static bool makeDirectory(const string &path) {
+  if (mkdir(path.c_str(), 0755) == 0 || errno == EEXIST) {
+    return true;
+  }
+  fprintf(stderr, "error: create %s failed\n", path.c_str());
+  return false;
+}
+
+TiledSvgWriter::TiledSvgWriter(int tileSize, int levels)
+    : m_tileSize(max(tileSize, 1)), m_levels(max(levels, 1)) {}
+
+bool TiledSvgWriter::write(const SvgPainter &painter, const string &directory,
+                           util::ThreadPool &pool) {
+  bin(painter);
+
+  if (!makeDirectory(directory)) {
+    return false;
+  }
+  for (int level = 0; level < m_levels; level++) {
+    if (!makeDirectory(directory + "/" + to_string(level))) {
+      return false;
+    }
+  }
+
+  vector<char> written(m_tiles.size(), 0);
+  pool.parallelFor(tileCount(), [&](int index) {
+    const Tile &tile = m_tiles[static_cast<size_t>(index)];
+    FILE *fp = fopen((directory + "/" + tilePath(tile)).c_str(), "wb");
+    if (!fp) {
+      return;
+    }
+    bool failed = false;
+    {
+      util::FileSink sink(fp);
+      painter.generate(sink, tile.items, tile.view, tile.width, tile.height);
+      sink.flush();
+      failed = sink.failed();
+    }
+    written[static_cast<size_t>(index)] = fclose(fp) == 0 && !failed;
+  });
+
+  bool ok = true;
+  for (size_t i = 0; i < m_tiles.size(); i++) {
+    if (!written[i]) {
+      fprintf(stderr, "error: write %s/%s failed\n", directory.c_str(),
+              tilePath(m_tiles[i]).c_str());
+      ok = false;
+    }
+  }
+  return writeIndex(painter, directory) && ok;
+}
+
+int TiledSvgWriter::tileSize() const { return m_tileSize; }
+
+int TiledSvgWriter::levels() const { return m_levels; }
+
+int TiledSvgWriter::tileCount() const {
+  return static_cast<int>(m_tiles.size());
+}
+
+void TiledSvgWriter::bin(const SvgPainter &painter) {
+  int width = painter.width();
+  int height = painter.height();
+  m_levelInfos.clear();
+  m_tiles.clear();
+  for (int level = 0; level < m_levels; level++) {
+    Level info;
+    info.scale = 1 << level;
+    int span = m_tileSize * info.scale;
+    info.columns = max((width + span - 1) / span, 1);
+    info.rows = max((height + span - 1) / span, 1);
+    info.firstTile = m_tiles.size();
+    m_levelInfos.push_back(info);
+
+    for (int row = 0; row < info.rows; row++) {
+      for (int column = 0; column < info.columns; column++) {
+        Tile tile;
+        tile.level = level;
+        tile.column = column;
+        tile.row = row;
+        tile.view.left = column * span;
+        tile.view.top = row * span;
+        tile.view.right = min(tile.view.left + span, max(width, 1));
+        tile.view.bottom = min(tile.view.top + span, max(height, 1));
+        tile.width = (tile.view.right - tile.view.left + info.scale - 1) /
+                     info.scale;
+        tile.height = (tile.view.bottom - tile.view.top + info.scale - 1) /
+                      info.scale;
+        m_tiles.push_back(move(tile));
+      }
+    }
+  }
+
+  const DisplayList &list = painter.displayList();
+  for (auto &item : list.items()) {
+    Rect bounds = list.bounds(item);
+    Rect r = bounds;
+    r.left = max(r.left, 0);
+    r.top = max(r.top, 0);
+    r.right = min(r.right, width);
+    r.bottom = min(r.bottom, height);
+    if (r.left >= r.right || r.top >= r.bottom) {
+      continue;
+    }
+    for (auto &info : m_levelInfos) {
+      // below a pixel at this scale
+      if (bounds.right - bounds.left < info.scale &&
+          bounds.bottom - bounds.top < info.scale) {
+        continue;
+      }
+      int span = m_tileSize * info.scale;
+      int right = (r.right - 1) / span;
+      int bottom = (r.bottom - 1) / span;
+      for (int y = r.top / span; y <= bottom; y++) {
+        for (int x = r.left / span; x <= right; x++) {
+          size_t tile = static_cast<size_t>(y * info.columns + x);
+          m_tiles[info.firstTile + tile].items.push_back(item);
+        }
+      }
+    }
+  }
+}
+
+string TiledSvgWriter::tilePath(const Tile &tile) {
+  return to_string(tile.level) + "/" + to_string(tile.column) + "_" +
+         to_string(tile.row) + ".svg";
+}
+
+bool TiledSvgWriter::writeIndex(const SvgPainter &painter,
+                                const string &directory) const {
+  string path = directory + "/index.json";
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp) {
+    fprintf(stderr, "error: open %s failed\n", path.c_str());
+    return false;
+  }
+
+  bool failed = false;
+  {
+    util::FileSink sink(fp);
+    sink.print("{\n  \"width\": %d,\n  \"height\": %d,\n  \"tileSize\": %d,\n",
+               painter.width(), painter.height(), m_tileSize);
+    sink.write("  \"levels\": [\n");
+    for (size_t i = 0; i < m_levelInfos.size(); i++) {
+      const Level &info = m_levelInfos[i];
+      sink.print(
+          "    {\"level\": %d, \"scale\": %d, \"columns\": %d, "
+          "\"rows\": %d}%s\n",
+          static_cast<int>(i), info.scale, info.columns, info.rows,
+          i + 1 < m_levelInfos.size() ? "," : "");
+    }
+    sink.write("  ],\n  \"tiles\": [\n");
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+      const Tile &tile = m_tiles[i];
+      sink.print(
+          "    {\"level\": %d, \"column\": %d, \"row\": %d, \"file\": \"%s\", "
+          "\"shapes\": %d}%s\n",
+          tile.level, tile.column, tile.row, tilePath(tile).c_str(),
+          static_cast<int>(tile.items.size()),
+          i + 1 < m_tiles.size() ? "," : "");
+    }
+    sink.write("  ]\n}\n");
+    sink.flush();
+    failed = sink.failed();
+  }
+  if (fclose(fp) != 0 || failed) {
+    fprintf(stderr, "error: write %s failed\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace draw
+}  // namespace rectangle
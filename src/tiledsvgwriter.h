@@ -0,0 +1,82 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "displaylist.h"
+#include "svgpainter.h"
+#include "threadpool.h"
+
+namespace rectangle {
+namespace draw {
+
+// Splits the scene of a painter into square tiles, each written as its
+// own svg holding only the shapes intersecting it. Level 0 is the scene
+// at full size, every further level halves the scale and leaves out the
+// shapes smaller than a pixel. index.json lists the levels and tiles.
+class TiledSvgWriter {
+ public:
+  explicit TiledSvgWriter(int tileSize = 512, int levels = 1);
+
+  // tiles go to directory/<level>/<column>_<row>.svg, false if any file
+  // cannot be written
+  bool write(const SvgPainter &painter, const std::string &directory,
+             util::ThreadPool &pool);
+
+  int tileSize() const;
+  int levels() const;
+  // of the last write
+  int tileCount() const;
+
+ private:
+  struct Level {
+    int scale;
+    int columns;
+    int rows;
+    // index of the first tile of the level
+    size_t firstTile;
+  };
+
+  struct Tile {
+    int level;
+    int column;
+    int row;
+    // the part of the scene shown, and the size it is shown at
+    Rect view;
+    int width;
+    int height;
+    std::vector<DisplayItem> items;
+  };
+
+  void bin(const SvgPainter &painter);
+  static std::string tilePath(const Tile &tile);
+  bool writeIndex(const SvgPainter &painter,
+                  const std::string &directory) const;
+
+ private:
+  int m_tileSize;
+  int m_levels;
+  std::vector<Level> m_levelInfos;
+  std::vector<Tile> m_tiles;
+};
+
+}  // namespace draw
+}  // namespace rectangle
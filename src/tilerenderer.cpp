@@ -0,0 +1,79 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "tilerenderer.h"
+
+#include <algorithm>
+
+#include "rasterizer.h"
+
+using namespace std;
+
+namespace rectangle {
+namespace draw {
+
+TileRenderer::TileRenderer(int tileSize) : m_tileSize(max(tileSize, 1)) {}
+
+void TileRenderer::render(const DisplayList &list, Image &image,
+                          util::ThreadPool &pool) {
+  bin(list, image);
+
+  const vector<DisplayItem> &items = list.items();
+  pool.parallelFor(tileCount(), [&](int tile) {
+    int left = tile % m_columns * m_tileSize;
+    int top = tile / m_columns * m_tileSize;
+    Rasterizer rasterizer(
+        image, Rect{left, top, left + m_tileSize, top + m_tileSize});
+    for (int index : m_bins[static_cast<size_t>(tile)]) {
+      rasterizer.draw(list, items[static_cast<size_t>(index)]);
+    }
+  });
+}
+
+int TileRenderer::tileSize() const { return m_tileSize; }
+
+int TileRenderer::tileCount() const { return m_columns * m_rows; }
+
+void TileRenderer::bin(const DisplayList &list, const Image &image) {
+  m_columns = (image.width() + m_tileSize - 1) / m_tileSize;
+  m_rows = (image.height() + m_tileSize - 1) / m_tileSize;
+  m_bins.assign(static_cast<size_t>(m_columns * m_rows), vector<int>());
+
+  const vector<DisplayItem> &items = list.items();
+  for (size_t i = 0; i < items.size(); i++) {
+    Rect r = list.bounds(items[i]);
+    r.left = max(r.left, 0);
+    r.top = max(r.top, 0);
+    r.right = min(r.right, image.width());
+    r.bottom = min(r.bottom, image.height());
+    if (r.left >= r.right || r.top >= r.bottom) {
+      continue;
+    }
+    int right = (r.right - 1) / m_tileSize;
+    int bottom = (r.bottom - 1) / m_tileSize;
+    for (int y = r.top / m_tileSize; y <= bottom; y++) {
+      for (int x = r.left / m_tileSize; x <= right; x++) {
+        m_bins[static_cast<size_t>(y * m_columns + x)].push_back(
+            static_cast<int>(i));
+      }
+    }
+  }
+}
+
+}  // namespace draw
+}  // namespace rectangle
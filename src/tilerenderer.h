@@ -0,0 +1,55 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+#include "displaylist.h"
+#include "image.h"
+#include "threadpool.h"
+
+namespace rectangle {
+namespace draw {
+
+// Bins the shapes of a display list into square screen tiles by their
+// bounds and rasterizes the tiles in parallel. Within a tile the shapes
+// keep their paint order, so the image equals the one of Rasterizer.
+class TileRenderer {
+ public:
+  explicit TileRenderer(int tileSize = 256);
+
+  void render(const DisplayList &list, Image &image, util::ThreadPool &pool);
+
+  int tileSize() const;
+  // of the last render
+  int tileCount() const;
+
+ private:
+  void bin(const DisplayList &list, const Image &image);
+
+ private:
+  int m_tileSize;
+  int m_columns = 0;
+  int m_rows = 0;
+  // item indexes in paint order per tile
+  std::vector<std::vector<int>> m_bins;
+};
+
+}  // namespace draw
+}  // namespace rectangle
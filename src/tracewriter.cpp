@@ -0,0 +1,86 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "tracewriter.h"
+
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace rectangle {
+namespace util {
+
+static double monotonicUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+TraceWriter::TraceWriter()
+    : m_origin(monotonicUs()), m_pid(static_cast<int>(getpid())) {}
+
+double TraceWriter::now() const { return monotonicUs() - m_origin; }
+
+void TraceWriter::complete(const string &name, const char *category,
+                           double startUs, double durationUs,
+                           const string &file) {
+  m_events.push_back(Event{name, category, startUs, durationUs, file});
+}
+
+void TraceWriter::write(OutputSink &sink) const {
+  sink.write("{\"traceEvents\": [\n");
+  for (size_t i = 0; i < m_events.size(); i++) {
+    const Event &e = m_events[i];
+    sink.write("  {\"name\": ");
+    writeJsonString(sink, e.name);
+    sink.print(
+        ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+        "\"pid\": %d, \"tid\": 1",
+        e.category, e.startUs, e.durationUs, m_pid);
+    if (e.file.size()) {
+      sink.write(", \"args\": {\"file\": ");
+      writeJsonString(sink, e.file);
+      sink.write('}');
+    }
+    sink.write(i + 1 < m_events.size() ? "},\n" : "}\n");
+  }
+  sink.write("], \"displayTimeUnit\": \"ms\"}\n");
+}
+
+size_t TraceWriter::eventCount() const { return m_events.size(); }
+
+ScopedTrace::ScopedTrace(TraceWriter *writer, const string &name,
+                         const char *category, const string &file)
+    : m_writer(writer), m_category(category) {
+  if (m_writer) {
+    m_name = name;
+    m_file = file;
+    m_start = m_writer->now();
+  }
+}
+
+ScopedTrace::~ScopedTrace() {
+  if (m_writer) {
+    m_writer->complete(m_name, m_category, m_start,
+                       m_writer->now() - m_start, m_file);
+  }
+}
+
+}  // namespace util
+}  // namespace rectangle
@@ -0,0 +1,78 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "outputsink.h"
+
+namespace rectangle {
+namespace util {
+
+// Collects complete ("X") trace events and writes them in the Chrome
+// trace event format, which chrome://tracing and Perfetto open.
+class TraceWriter {
+ public:
+  TraceWriter();
+
+  // microseconds since the writer was created
+  double now() const;
+
+  void complete(const std::string &name, const char *category,
+                double startUs, double durationUs,
+                const std::string &file = "");
+  void write(OutputSink &sink) const;
+
+  size_t eventCount() const;
+
+ private:
+  struct Event {
+    std::string name;
+    const char *category;
+    double startUs;
+    double durationUs;
+    std::string file;
+  };
+
+ private:
+  double m_origin;
+  int m_pid;
+  std::vector<Event> m_events;
+};
+
+// a complete event from construction to destruction, writer may be null
+class ScopedTrace {
+ public:
+  ScopedTrace(TraceWriter *writer, const std::string &name,
+              const char *category, const std::string &file = "");
+  ~ScopedTrace();
+  ScopedTrace(const ScopedTrace &) = delete;
+  ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+ private:
+  TraceWriter *m_writer;
+  std::string m_name;
+  const char *m_category;
+  std::string m_file;
+  double m_start = 0;
+};
+
+}  // namespace util
+}  // namespace rectangle
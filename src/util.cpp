@@ -22,15 +22,13 @@
 #include <fstream>
 #include <sstream>
 
-#include "option.h"
-
 using namespace std;
 
 namespace rectangle {
 namespace util {
 
 void condPrint(bool cond, const char *const fmt, ...) {
-  if (option::verbose || cond) {
+  if (cond) {
     va_list ap;
     va_start(ap, fmt);
     vfprintf(stderr, fmt, ap);
@@ -22,9 +22,30 @@
 #include <string>
 #include <vector>
 
+// Prints to stderr if cond is set. The format arguments are only evaluated
+// then, so callers may pass costly toString() calls. Callers take cond from
+// their Options, which already fold --verbose in. With RECTANGLE_NO_TRACE
+// defined the print is compiled out.
+#ifdef RECTANGLE_NO_TRACE
+#define COND_PRINT(cond, ...)                        \
+  do {                                               \
+    if (false) {                                     \
+      rectangle::util::condPrint(true, __VA_ARGS__); \
+    }                                                \
+  } while (0)
+#else
+#define COND_PRINT(cond, ...)                        \
+  do {                                               \
+    if (cond) {                                      \
+      rectangle::util::condPrint(true, __VA_ARGS__); \
+    }                                                \
+  } while (0)
+#endif
+
 namespace rectangle {
 namespace util {
 
+// use COND_PRINT, which skips formatting the arguments when disabled
 void condPrint(bool cond, const char *const fmt, ...);
 
 bool fileExists(const std::string &filename);
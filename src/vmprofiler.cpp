@@ -0,0 +1,279 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "vmprofiler.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+#include "asminstruction.h"
+
+using namespace std;
+using namespace rectangle::backend;
+using namespace rectangle::util;
+
+namespace rectangle {
+namespace runtime {
+
+VmProfiler::VmProfiler() : m_opcodes(256) {}
+
+uint64_t VmProfiler::now() {
+  return static_cast<uint64_t>(
+      chrono::duration_cast<chrono::nanoseconds>(
+          chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void VmProfiler::clear() {
+  m_opcodes.assign(256, OpcodeStats());
+  m_functions.clear();
+  m_addresses.clear();
+  m_lines.clear();
+  m_active.clear();
+  m_maxOperands = 0;
+  m_maxFrames = 0;
+}
+
+VmProfiler::FunctionStats &VmProfiler::function(int func) {
+  assert(func >= 0);
+  size_t index = static_cast<size_t>(func);
+  if (index >= m_functions.size()) {
+    m_functions.resize(index + 1);
+    m_active.resize(index + 1);
+  }
+  return m_functions[index];
+}
+
+void VmProfiler::call(const AsmBin::FunctionItem &func) {
+  FunctionStats &stats = function(func.index);
+  stats.name = func.name;
+  stats.calls++;
+  m_active[static_cast<size_t>(func.index)]++;
+}
+
+void VmProfiler::ret(int func, uint64_t ns) {
+  FunctionStats &stats = function(func);
+  int &active = m_active[static_cast<size_t>(func)];
+  if (active > 0 && --active == 0) {
+    stats.totalNs += ns;
+  }
+}
+
+void VmProfiler::instruction(unsigned char instr, int addr, int func,
+                             uint64_t ns, size_t operands, size_t frames) {
+  OpcodeStats &op = m_opcodes[instr];
+  op.count++;
+  op.ns += ns;
+  size_t index = static_cast<size_t>(addr);
+  if (index >= m_addresses.size()) {
+    m_addresses.resize(index + 1);
+  }
+  m_addresses[index].count++;
+  m_addresses[index].ns += ns;
+  if (func >= 0) {
+    FunctionStats &stats = function(func);
+    stats.instructions++;
+    stats.selfNs += ns;
+  }
+  m_maxOperands = max(m_maxOperands, operands);
+  m_maxFrames = max(m_maxFrames, frames);
+}
+
+void VmProfiler::resolveLines(const AsmBin &bin) {
+  m_lines.clear();
+  const vector<string> &files = bin.sourceFiles();
+  vector<AsmBin::SourceLocation> table = bin.lineTable();
+  map<pair<int, int>, size_t> rows;
+  size_t next = 0;
+  AsmBin::SourceLocation loc;
+  for (size_t addr = 0; addr < m_addresses.size(); addr++) {
+    while (next < table.size() &&
+           table[next].addr <= static_cast<int>(addr)) {
+      loc = table[next++];
+    }
+    const OpcodeStats &stats = m_addresses[addr];
+    if (stats.count == 0 || !loc.isValid()) {
+      continue;
+    }
+    auto key = make_pair(loc.file, loc.line);
+    auto it = rows.find(key);
+    if (it == rows.end()) {
+      it = rows.emplace(key, m_lines.size()).first;
+      m_lines.emplace_back();
+      m_lines.back().file = files[static_cast<size_t>(loc.file)];
+      m_lines.back().line = loc.line;
+    }
+    m_lines[it->second].count += stats.count;
+    m_lines[it->second].ns += stats.ns;
+  }
+  sort(m_lines.begin(), m_lines.end(),
+       [](const LineStats &a, const LineStats &b) { return a.ns > b.ns; });
+}
+
+uint64_t VmProfiler::instructions() const {
+  uint64_t result = 0;
+  for (auto &op : m_opcodes) {
+    result += op.count;
+  }
+  return result;
+}
+
+uint64_t VmProfiler::ns() const {
+  uint64_t result = 0;
+  for (auto &op : m_opcodes) {
+    result += op.ns;
+  }
+  return result;
+}
+
+size_t VmProfiler::maxOperands() const { return m_maxOperands; }
+
+size_t VmProfiler::maxFrames() const { return m_maxFrames; }
+
+const VmProfiler::OpcodeStats &VmProfiler::opcode(unsigned char instr) const {
+  return m_opcodes[instr];
+}
+
+vector<VmProfiler::FunctionStats> VmProfiler::functions() const {
+  vector<FunctionStats> result;
+  for (auto &f : m_functions) {
+    if (f.calls > 0) {
+      result.push_back(f);
+    }
+  }
+  return result;
+}
+
+const vector<VmProfiler::LineStats> &VmProfiler::lines() const {
+  return m_lines;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+  return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) /
+                                static_cast<double>(whole);
+}
+
+static double ms(uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+
+void VmProfiler::printReport(FILE *fp, size_t limit) const {
+  uint64_t count = instructions();
+  uint64_t total = ns();
+  fprintf(fp,
+          "vm profile: %llu instructions in %.3f ms, operand stack max %zu, "
+          "frame depth max %zu\n",
+          static_cast<unsigned long long>(count), ms(total), m_maxOperands,
+          m_maxFrames);
+
+  vector<unsigned char> opcodes;
+  for (size_t i = 0; i < m_opcodes.size(); i++) {
+    if (m_opcodes[i].count > 0) {
+      opcodes.push_back(static_cast<unsigned char>(i));
+    }
+  }
+  sort(opcodes.begin(), opcodes.end(),
+       [this](unsigned char a, unsigned char b) {
+         return m_opcodes[a].ns > m_opcodes[b].ns;
+       });
+  fprintf(fp, "\n%-14s %12s %8s %10s %8s %8s\n", "opcode", "count", "count%",
+          "ms", "time%", "ns/op");
+  for (size_t i = 0; i < opcodes.size() && i < limit; i++) {
+    const OpcodeStats &op = m_opcodes[opcodes[i]];
+    fprintf(fp, "%-14s %12llu %7.2f%% %10.3f %7.2f%% %8.1f\n",
+            instr::getAsmName(opcodes[i]).c_str(),
+            static_cast<unsigned long long>(op.count), percent(op.count, count),
+            ms(op.ns), percent(op.ns, total),
+            static_cast<double>(op.ns) / static_cast<double>(op.count));
+  }
+
+  vector<FunctionStats> funcs = functions();
+  sort(funcs.begin(), funcs.end(),
+       [](const FunctionStats &a, const FunctionStats &b) {
+         return a.selfNs > b.selfNs;
+       });
+  fprintf(fp, "\n%-32s %10s %12s %10s %8s %10s\n", "function", "calls",
+          "instructions", "self ms", "self%", "total ms");
+  for (size_t i = 0; i < funcs.size() && i < limit; i++) {
+    const FunctionStats &f = funcs[i];
+    fprintf(fp, "%-32s %10llu %12llu %10.3f %7.2f%% %10.3f\n", f.name.c_str(),
+            static_cast<unsigned long long>(f.calls),
+            static_cast<unsigned long long>(f.instructions), ms(f.selfNs),
+            percent(f.selfNs, total), ms(f.totalNs));
+  }
+
+  if (m_lines.empty()) {
+    return;
+  }
+  fprintf(fp, "\n%-40s %12s %10s %8s\n", "line", "instructions", "ms",
+          "time%");
+  for (size_t i = 0; i < m_lines.size() && i < limit; i++) {
+    const LineStats &l = m_lines[i];
+    string where = l.file + ":" + to_string(l.line);
+    fprintf(fp, "%-40s %12llu %10.3f %7.2f%%\n", where.c_str(),
+            static_cast<unsigned long long>(l.count), ms(l.ns),
+            percent(l.ns, total));
+  }
+}
+
+void VmProfiler::writeJson(OutputSink &sink) const {
+  sink.print(
+      "{\n  \"instructions\": %llu,\n  \"ms\": %.3f,\n"
+      "  \"maxOperands\": %zu,\n  \"maxFrames\": %zu,\n  \"opcodes\": [\n",
+      static_cast<unsigned long long>(instructions()), ms(ns()),
+      m_maxOperands, m_maxFrames);
+  bool first = true;
+  for (size_t i = 0; i < m_opcodes.size(); i++) {
+    const OpcodeStats &op = m_opcodes[i];
+    if (op.count == 0) {
+      continue;
+    }
+    sink.write(first ? "    " : ",\n    ");
+    first = false;
+    sink.print("{\"opcode\": \"%s\", \"count\": %llu, \"ms\": %.3f}",
+               instr::getAsmName(static_cast<unsigned char>(i)).c_str(),
+               static_cast<unsigned long long>(op.count), ms(op.ns));
+  }
+  sink.write("\n  ],\n  \"functions\": [\n");
+  vector<FunctionStats> funcs = functions();
+  for (size_t i = 0; i < funcs.size(); i++) {
+    const FunctionStats &f = funcs[i];
+    sink.write("    {\"function\": ");
+    writeJsonString(sink, f.name);
+    sink.print(
+        ", \"calls\": %llu, \"instructions\": %llu, \"selfMs\": %.3f, "
+        "\"totalMs\": %.3f}",
+        static_cast<unsigned long long>(f.calls),
+        static_cast<unsigned long long>(f.instructions), ms(f.selfNs),
+        ms(f.totalNs));
+    sink.write(i + 1 < funcs.size() ? ",\n" : "\n");
+  }
+  sink.write("  ],\n  \"lines\": [\n");
+  for (size_t i = 0; i < m_lines.size(); i++) {
+    const LineStats &l = m_lines[i];
+    sink.write("    {\"file\": ");
+    writeJsonString(sink, l.file);
+    sink.print(", \"line\": %d, \"instructions\": %llu, \"ms\": %.3f}",
+               l.line, static_cast<unsigned long long>(l.count), ms(l.ns));
+    sink.write(i + 1 < m_lines.size() ? ",\n" : "\n");
+  }
+  sink.write("  ]\n}\n");
+}
+
+}  // namespace runtime
+}  // namespace rectangle
@@ -0,0 +1,102 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "asmbin.h"
+#include "outputsink.h"
+
+namespace rectangle {
+namespace runtime {
+
+// Counts what AsmMachine executes: every instruction per opcode and per
+// function it runs in, the calls of every function and how deep the
+// operand stack and the frames get. Times are steady clock nanoseconds.
+class VmProfiler {
+ public:
+  struct OpcodeStats {
+    uint64_t count = 0;
+    uint64_t ns = 0;
+  };
+  struct FunctionStats {
+    std::string name;
+    uint64_t calls = 0;
+    uint64_t instructions = 0;
+    // spent in the instructions of the function itself
+    uint64_t selfNs = 0;
+    // from call to return, recursive calls are counted once
+    uint64_t totalNs = 0;
+  };
+  struct LineStats {
+    std::string file;
+    int line = -1;
+    uint64_t count = 0;
+    uint64_t ns = 0;
+  };
+
+ public:
+  VmProfiler();
+
+  static uint64_t now();
+
+  void clear();
+
+  void call(const backend::AsmBin::FunctionItem &func);
+  void ret(int func, uint64_t ns);
+  // func is the function of the current frame, -1 outside any
+  void instruction(unsigned char instr, int addr, int func, uint64_t ns,
+                   size_t operands, size_t frames);
+  // sums the instructions per source line with the line table of bin
+  void resolveLines(const backend::AsmBin &bin);
+
+  uint64_t instructions() const;
+  uint64_t ns() const;
+  size_t maxOperands() const;
+  size_t maxFrames() const;
+  const OpcodeStats &opcode(unsigned char instr) const;
+  // the functions that were called, by index
+  std::vector<FunctionStats> functions() const;
+  // after resolveLines, sorted by time
+  const std::vector<LineStats> &lines() const;
+
+  // opcodes and functions sorted by time, limit rows each
+  void printReport(FILE *fp, size_t limit = 20) const;
+  void writeJson(util::OutputSink &sink) const;
+
+ private:
+  FunctionStats &function(int func);
+
+ private:
+  std::vector<OpcodeStats> m_opcodes;
+  std::vector<FunctionStats> m_functions;
+  // by code address
+  std::vector<OpcodeStats> m_addresses;
+  std::vector<LineStats> m_lines;
+  // frames of each function currently on the stack
+  std::vector<int> m_active;
+  size_t m_maxOperands = 0;
+  size_t m_maxFrames = 0;
+};
+
+}  // namespace runtime
+}  // namespace rectangle
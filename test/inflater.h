@@ -0,0 +1,221 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+namespace testhelper
+{
+
+// Minimal inflate to check the deflate output, returns false on a bad
+// stream.
+class Inflater
+{
+public:
+    explicit Inflater(const std::string &in) : m_in(in) {}
+
+    bool run(std::string &out)
+    {
+        static const int lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                           35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const int lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                            2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const int distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257,
+                                         385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193,
+                                         12289, 16385, 24577};
+        static const int order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        bool last = false;
+        while (!last)
+        {
+            last = bits(1) == 1;
+            int type = bits(2);
+            if (type == 0)
+            {
+                m_bitCount = 0;
+                if (m_pos + 4 > m_in.size())
+                {
+                    return false;
+                }
+                size_t len = byte(m_pos) | byte(m_pos + 1) << 8;
+                size_t nlen = byte(m_pos + 2) | byte(m_pos + 3) << 8;
+                m_pos += 4;
+                if (len != (~nlen & 0xffff) || m_pos + len > m_in.size())
+                {
+                    return false;
+                }
+                out.append(m_in, m_pos, len);
+                m_pos += len;
+                continue;
+            }
+            std::vector<int> litLen(288, 0);
+            std::vector<int> dist(30, 0);
+            if (type == 1)
+            {
+                for (int i = 0; i < 288; i++)
+                {
+                    litLen[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+                }
+                dist.assign(30, 5);
+            }
+            else if (type == 2)
+            {
+                int hlit = bits(5) + 257;
+                int hdist = bits(5) + 1;
+                int hclen = bits(4) + 4;
+                std::vector<int> codeLengths(19, 0);
+                for (int i = 0; i < hclen; i++)
+                {
+                    codeLengths[order[i]] = bits(3);
+                }
+                std::vector<int> lengths;
+                while (static_cast<int>(lengths.size()) < hlit + hdist)
+                {
+                    int sym = decode(codeLengths);
+                    if (sym < 16)
+                    {
+                        lengths.push_back(sym);
+                    }
+                    else if (sym == 16 && !lengths.empty())
+                    {
+                        int previous = lengths.back();
+                        lengths.insert(lengths.end(), 3 + bits(2), previous);
+                    }
+                    else if (sym == 17)
+                    {
+                        lengths.insert(lengths.end(), 3 + bits(3), 0);
+                    }
+                    else if (sym == 18)
+                    {
+                        lengths.insert(lengths.end(), 11 + bits(7), 0);
+                    }
+                    else
+                    {
+                        return false;
+                    }
+                }
+                copy(lengths.begin(), lengths.begin() + hlit, litLen.begin());
+                copy(lengths.begin() + hlit, lengths.begin() + hlit + hdist, dist.begin());
+            }
+            else
+            {
+                return false;
+            }
+            for (;;)
+            {
+                int sym = decode(litLen);
+                if (sym < 0 || sym > 285)
+                {
+                    return false;
+                }
+                if (sym < 256)
+                {
+                    out.push_back(static_cast<char>(sym));
+                    continue;
+                }
+                if (sym == 256)
+                {
+                    break;
+                }
+                int len = lengthBase[sym - 257] + bits(lengthExtra[sym - 257]);
+                int d = decode(dist);
+                if (d < 0 || d > 29)
+                {
+                    return false;
+                }
+                int back = distBase[d] + bits(d < 4 ? 0 : d / 2 - 1);
+                if (back > static_cast<int>(out.size()))
+                {
+                    return false;
+                }
+                for (int i = 0; i < len; i++)
+                {
+                    out.push_back(out[out.size() - back]);
+                }
+            }
+            if (m_pos > m_in.size())
+            {
+                return false;
+            }
+        }
+        m_bitCount = 0;
+        return true;
+    }
+
+    size_t end() const { return m_pos; }
+
+private:
+    unsigned byte(size_t i) const { return i < m_in.size() ? static_cast<unsigned char>(m_in[i]) : 0; }
+
+    int bits(int count)
+    {
+        int value = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (m_bitCount == 0)
+            {
+                m_bitBuffer = byte(m_pos++);
+                m_bitCount = 8;
+            }
+            value |= (m_bitBuffer & 1) << i;
+            m_bitBuffer >>= 1;
+            m_bitCount--;
+        }
+        return value;
+    }
+
+    // canonical code, read bit by bit
+    int decode(const std::vector<int> &lengths)
+    {
+        int code = 0;
+        int first = 0;
+        for (int len = 1; len <= 15; len++)
+        {
+            code |= bits(1);
+            int count = 0;
+            for (int l : lengths)
+            {
+                count += l == len;
+            }
+            if (code - first < count)
+            {
+                int n = code - first;
+                for (size_t i = 0; i < lengths.size(); i++)
+                {
+                    if (lengths[i] == len && n-- == 0)
+                    {
+                        return static_cast<int>(i);
+                    }
+                }
+            }
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+private:
+    const std::string &m_in;
+    size_t m_pos = 0;
+    unsigned m_bitBuffer = 0;
+    int m_bitCount = 0;
+};
+
+} // namespace testhelper
@@ -0,0 +1,84 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "deflate.h"
+#include "inflater.h"
+#include "testhelper.h"
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle::util;
+using namespace testhelper;
+
+TEST(deflate, CRC32)
+{
+    EXPECT_EQ(crc32(0, "123456789", 9), 0xcbf43926u);
+    EXPECT_EQ(crc32(crc32(0, "1234", 4), "56789", 5), 0xcbf43926u);
+    EXPECT_EQ(crc32(0, "", 0), 0u);
+}
+
+TEST(deflate, DEFLATE)
+{
+    string text = makeSvgLikeText(300 * 1000);
+    string noise;
+    for (int i = 0; i < 70000; i++)
+    {
+        noise.push_back(static_cast<char>(rand()));
+    }
+    for (const string *input : {&text, &noise})
+    {
+        for (int level : {0, 1, 6, 9})
+        {
+            string out;
+            Deflater deflater(level);
+            for (size_t pos = 0; pos < input->size(); pos += 7777)
+            {
+                deflater.write(input->data() + pos, min<size_t>(7777, input->size() - pos), out);
+            }
+            deflater.finish(out);
+
+            string inflated;
+            Inflater inflater(out);
+            ASSERT_TRUE(inflater.run(inflated)) << level;
+            EXPECT_TRUE(inflated == *input) << level;
+            if (input == &text && level > 0)
+            {
+                EXPECT_LT(out.size(), input->size() / 3) << level;
+            }
+            if (input == &noise)
+            {
+                // stored blocks, a few bytes of framing
+                EXPECT_LT(out.size(), input->size() + 100) << level;
+            }
+        }
+    }
+
+    string empty;
+    Deflater deflater;
+    deflater.finish(empty);
+    string inflated;
+    EXPECT_TRUE(Inflater(empty).run(inflated));
+    EXPECT_TRUE(inflated.empty());
+}
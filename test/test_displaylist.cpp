@@ -0,0 +1,107 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "displaylist.h"
+#include "svgpainter.h"
+#include "testhelper.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace testhelper;
+
+TEST(displaylist, APPEND)
+{
+    DisplayList list;
+    list.append(makeRect(1, "red"), 100, 200, 0);
+    list.append(makePolyline(2), 100, 200, 1);
+    list.append(makeRect(3, "red"), 0, 0, 2);
+
+    ASSERT_EQ(list.items().size(), 3u);
+    EXPECT_EQ(list.items()[0].type, ShapeType::Rectangle);
+    EXPECT_EQ(list.items()[1].type, ShapeType::Polyline);
+    EXPECT_EQ(list.items()[2].index, 1);
+
+    const RectangleShape &r = list.rectangle(0);
+    EXPECT_EQ(r.x, 101);
+    EXPECT_EQ(r.y, 200);
+    EXPECT_EQ(r.style, list.rectangle(1).style);
+    EXPECT_EQ(list.str(list.style(r.style).fillColor), "red");
+    EXPECT_EQ(list.style(r.style).fillRule, -1);
+    // "red", "black", "" and "none"
+    EXPECT_EQ(list.strings().size(), 4);
+    EXPECT_EQ(list.styleCount(), 2);
+
+    const PolylineShape &p = list.polyline(0);
+    EXPECT_EQ(p.x, 102);
+    EXPECT_EQ(p.pointCount, 2);
+    EXPECT_EQ(list.points(p.pointBegin)[2], 2);
+    EXPECT_EQ(list.points(p.pointBegin)[3], 1);
+}
+
+TEST(displaylist, FILTER_AND_SORT)
+{
+    DisplayList list;
+    list.append(makePolyline(1), 0, 0, 2);
+    list.append(makeRect(2, "red"), 0, 0, 1);
+    list.append(makePolyline(3), 0, 0, 1);
+    list.append(makeRect(4, "blue"), 0, 0, 0);
+
+    list.filter([](const DisplayItem &item) { return item.instance != 0; });
+    ASSERT_EQ(list.items().size(), 3u);
+
+    list.sortByInstance();
+    ASSERT_EQ(list.items().size(), 3u);
+    EXPECT_EQ(list.items()[0].instance, 1);
+    EXPECT_EQ(list.items()[0].type, ShapeType::Rectangle);
+    EXPECT_EQ(list.rectangle(list.items()[0].index).x, 2);
+    EXPECT_EQ(list.items()[1].type, ShapeType::Polyline);
+    const PolylineShape &p = list.polyline(list.items()[1].index);
+    EXPECT_EQ(p.x, 3);
+    EXPECT_EQ(list.points(p.pointBegin)[2], 3);
+    EXPECT_EQ(list.items()[2].instance, 2);
+}
+
+TEST(displaylist, LINE_ORIGIN)
+{
+    SvgPainter painter;
+    LineData d;
+    d.x = 1;
+    d.y = 2;
+    d.dx1 = 0;
+    d.dy1 = 0;
+    d.dx2 = 10;
+    d.dy2 = 20;
+    d.stroke_width = 1;
+    d.stroke_color = "black";
+    d.stroke_dasharray = "";
+    painter.pushOrigin(100, 200);
+    painter.draw(d);
+    painter.popOrigin();
+
+    const LineShape &line = painter.displayList().line(0);
+    EXPECT_EQ(line.x1, 101);
+    EXPECT_EQ(line.y1, 202);
+    EXPECT_EQ(line.x2, 111);
+    EXPECT_EQ(line.y2, 222);
+}
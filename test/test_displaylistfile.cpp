@@ -0,0 +1,155 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "displaylistfile.h"
+#include "outputsink.h"
+#include "svgpainter.h"
+#include "testhelper.h"
+
+#include <gtest/gtest.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace testhelper;
+
+// write the display list of painter to path
+static bool writeFile(const SvgPainter &painter, const string &path)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp)
+    {
+        return false;
+    }
+    bool failed = false;
+    {
+        util::FileSink sink(fp);
+        DisplayListFile::write(sink, painter.displayList(), painter.width(), painter.height());
+        sink.flush();
+        failed = sink.failed();
+    }
+    return fclose(fp) == 0 && !failed;
+}
+
+TEST(displaylistfile, WRITE_AND_OPEN)
+{
+    SvgPainter painter;
+    painter.setInstance(3);
+    painter.draw(makeRect(1, "red"));
+    painter.draw(makePolyline(2));
+    TextData t{5, 6, 20, "text"};
+    painter.draw(t);
+
+    TempDir tmp;
+    string path = tmp.file("displaylist.rdl");
+    ASSERT_TRUE(writeFile(painter, path));
+
+    DisplayListFile file;
+    ASSERT_TRUE(file.open(path)) << file.error();
+    EXPECT_EQ(file.width(), painter.width());
+    EXPECT_EQ(file.itemCount(), 3);
+    EXPECT_EQ(file.item(1).type, static_cast<int>(ShapeType::Polyline));
+    EXPECT_EQ(file.item(2).instance, 3);
+    EXPECT_EQ(file.rectangle(0).x, 1);
+    EXPECT_STREQ(file.str(file.style(file.rectangle(0).style).fillColor), "red");
+    EXPECT_STREQ(file.str(file.text(0).text), "text");
+    EXPECT_EQ(file.points(file.polyline(0).pointBegin)[2], 2);
+
+    DisplayList list;
+    file.copyTo(list);
+    SvgPainter copy;
+    copy.load(list, file.width(), file.height());
+    EXPECT_EQ(copy.generate(), painter.generate());
+
+    // truncated
+    FILE *fp = fopen(path.c_str(), "r+b");
+    ASSERT_TRUE(fp != nullptr);
+    ASSERT_EQ(ftruncate(fileno(fp), 80), 0);
+    fclose(fp);
+    EXPECT_FALSE(file.open(path));
+    EXPECT_FALSE(file.open(tmp.file("no_such_file.rdl")));
+}
+
+TEST(displaylistfile, REPEATED_STRING)
+{
+    SvgPainter painter;
+    painter.draw(makeRect(1, "aaa"));
+    TextData t{5, 6, 20, "bbb"};
+    painter.draw(t);
+
+    TempDir tmp;
+    string path = tmp.file("repeated.rdl");
+    ASSERT_TRUE(writeFile(painter, path));
+
+    DisplayListFile file;
+    EXPECT_TRUE(file.open(path)) << file.error();
+    file.close();
+
+    // the same string twice would leave copyTo a pool shorter than the ids
+    string data = readBytes(path);
+    size_t pos = data.find(string("bbb", 4));
+    ASSERT_NE(pos, string::npos);
+    data.replace(pos, 3, "aaa");
+    ASSERT_TRUE(writeBytes(path, data));
+    EXPECT_FALSE(file.open(path));
+    EXPECT_NE(file.error().find("repeated string"), string::npos);
+}
+
+TEST(displaylistfile, MISSING_STROKE)
+{
+    SvgPainter painter;
+    painter.draw(makeRect(1, "aaa"));
+
+    TempDir tmp;
+    string path = tmp.file("stroke.rdl");
+    ASSERT_TRUE(writeFile(painter, path));
+
+    string data = readBytes(path);
+    DisplayListHeader h;
+    ASSERT_GE(data.size(), sizeof(h));
+    memcpy(&h, data.data(), sizeof(h));
+    ASSERT_GE(h.styleCount, 1u);
+
+    // only the fill color and fill rule of a style may be missing
+    size_t style = sizeof(h) + h.itemCount * sizeof(DisplayListRecord);
+    auto missing = [&data, style](size_t field) {
+        const int32_t id = -1;
+        string patched = data;
+        patched.replace(style + field, sizeof(id), reinterpret_cast<const char *>(&id), sizeof(id));
+        return patched;
+    };
+    const size_t required[] = { offsetof(Style, strokeColor), offsetof(Style, strokeDasharray) };
+    for (size_t field : required)
+    {
+        ASSERT_TRUE(writeBytes(path, missing(field)));
+        DisplayListFile file;
+        EXPECT_FALSE(file.open(path));
+        EXPECT_NE(file.error().find("bad style 0"), string::npos);
+    }
+    ASSERT_TRUE(writeBytes(path, missing(offsetof(Style, fillRule))));
+    DisplayListFile file;
+    EXPECT_TRUE(file.open(path)) << file.error();
+}
@@ -15,34 +15,293 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  ********************************************************************************/
 
+#include "asminstruction.h"
 #include "driver.h"
+#include "option.h"
+#include "testhelper.h"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <thread>
 
 using namespace testing;
 using namespace std;
+using namespace rectangle;
 using namespace rectangle::driver;
+using namespace testhelper;
 
 TEST(driver, COMPILE)
 {
-    vector<string> paths = 
-    {
-        "../../template/Scene.rect",
-        "../../template/Rectangle.rect", 
-        "../../template/Text.rect",
-        "../../template/Ellipse.rect",
-        "../../template/Polygon.rect",
-        "../../template/Line.rect",
-        "../../template/Polyline.rect",
-        "../rect/symbol_instance_instance.rect"
-    };
+    vector<string> paths = scenePaths();
 
     Driver d;
     string svg = d.compile(paths);
     printf("%s\n", svg.c_str());
-}
\ No newline at end of file
+}
+
+TEST(driver, PARALLEL_ANALYZE)
+{
+    vector<string> paths = scenePaths();
+
+    Options options;
+    string sequential = Driver(options).compile(paths);
+    options.parallelAnalyze = true;
+    string parallel = Driver(options).compile(paths);
+
+    EXPECT_FALSE(sequential.empty());
+    EXPECT_EQ(sequential, parallel);
+}
+
+TEST(driver, CONCURRENT)
+{
+    vector<string> paths = scenePaths();
+
+    vector<Options> options(4);
+    options[1].cssStyles = true;
+    options[2].parallelAnalyze = true;
+    options[3].useSymbols = true;
+
+    vector<string> expected;
+    for (auto &o : options)
+    {
+        expected.push_back(Driver(o).compile(paths));
+    }
+    EXPECT_NE(expected[0], expected[1]);
+
+    const int rounds = 4;
+    vector<string> results(options.size() * rounds);
+    vector<thread> threads;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            results[i] = Driver(options[i % options.size()]).compile(paths);
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        EXPECT_FALSE(results[i].empty());
+        EXPECT_EQ(results[i], expected[i % options.size()]);
+    }
+}
+
+TEST(driver, MODULE)
+{
+    vector<string> paths = templatePaths();
+    vector<frontend::SourceFile> files(paths.begin(), paths.end());
+    frontend::SourceFile instance(instancePath());
+
+    Driver d;
+    unique_ptr<Module> module = d.load(files);
+    ASSERT_TRUE(module != nullptr);
+
+    shared_ptr<const backend::AsmBin> bin = d.build(*module, instance);
+    ASSERT_TRUE(bin != nullptr);
+    EXPECT_EQ(module->cacheSize(), 1u);
+    EXPECT_EQ(d.build(*module, instance), bin);
+
+    string svg;
+    {
+        util::StringSink sink(svg);
+        EXPECT_TRUE(d.run(*bin, sink));
+    }
+    paths.push_back(instance.path());
+    EXPECT_EQ(svg, d.compile(paths));
+
+    module->setCacheCapacity(0);
+    EXPECT_EQ(module->cacheSize(), 0u);
+
+    // an instance is not a defination
+    d.setPrintErrors(false);
+    files.push_back(instance);
+    EXPECT_TRUE(d.load(files) == nullptr);
+    EXPECT_NE(d.error().find("is an instance document"), string::npos);
+}
+
+TEST(driver, TIME_PHASES)
+{
+    vector<string> paths = scenePaths();
+
+    {
+        Driver d;
+        d.compile(paths);
+        EXPECT_TRUE(d.phases().records().empty());
+    }
+
+    Options options;
+    options.timePhases = true;
+    Driver d(options);
+    string svg = d.compile(paths);
+
+    const vector<util::PhaseRecord> &records = d.phases().records();
+    // read, lex and parse for every file, then symbol, asm, assemble, run and output
+    ASSERT_EQ(records.size(), 3 * paths.size() + 5);
+    EXPECT_EQ(records[0].name, "read");
+    EXPECT_EQ(records[0].file, paths[0]);
+    EXPECT_EQ(records.back().name, "output");
+    EXPECT_TRUE(records.back().file.empty());
+    for (auto &r : records)
+    {
+        EXPECT_GE(r.wallMs, 0);
+        EXPECT_GT(r.peakRssKb, 0);
+    }
+    // parsing builds the ast
+    EXPECT_GT(records[paths.size() + 1].allocations, 0u);
+
+    util::PhaseRecord total = d.phases().total();
+    EXPECT_GT(total.allocatedBytes, 0u);
+
+    string json;
+    {
+        util::StringSink sink(json);
+        d.phases().writeJson(sink);
+    }
+    EXPECT_NE(json.find("{\"phase\": \"symbol\", \"file\": \"\", \"wallMs\": "), string::npos);
+    EXPECT_NE(json.find("\"total\": {\"phase\": \"total\""), string::npos);
+    EXPECT_NE(json.find("\"processWide\": ["), string::npos);
+}
+
+TEST(driver, TIME_PHASES_UNCOUNTED)
+{
+    vector<string> paths = scenePaths();
+
+    // as in a host linking librectangle without alloccounter.cpp
+    util::AllocStatsHook hook = util::setAllocStatsHook(nullptr);
+    EXPECT_FALSE(util::allocStatsAvailable());
+
+    Options options;
+    options.timePhases = true;
+    Driver d(options);
+    d.compile(paths);
+    util::setAllocStatsHook(hook);
+
+    EXPECT_FALSE(d.phases().allocationsCounted());
+    EXPECT_EQ(d.phases().total().allocations, 0u);
+
+    string json;
+    {
+        util::StringSink sink(json);
+        d.phases().writeJson(sink);
+    }
+    EXPECT_NE(json.find("\"allocations\": null, \"allocatedBytes\": null"), string::npos);
+    EXPECT_EQ(json.find("\"allocations\": 0"), string::npos);
+}
+
+TEST(driver, TRACE)
+{
+    vector<string> paths = scenePaths();
+
+    util::TraceWriter trace;
+    Options options;
+    options.traceVm = true;
+    Driver d(options);
+    d.setTraceWriter(&trace);
+    d.compile(paths);
+
+    string json;
+    {
+        util::StringSink sink(json);
+        trace.write(sink);
+    }
+    // a span per phase and per file, then the calls of the vm
+    EXPECT_GT(trace.eventCount(), d.phases().records().size() + paths.size());
+    EXPECT_EQ(json.compare(0, 17, "{\"traceEvents\": ["), 0);
+    EXPECT_NE(json.find("{\"name\": \"parse\", \"cat\": \"phase\", \"ph\": \"X\""), string::npos);
+    EXPECT_NE(json.find("\"cat\": \"file\""), string::npos);
+    EXPECT_NE(json.find("{\"name\": \"Rectangle::draw\", \"cat\": \"vm\""), string::npos);
+    EXPECT_NE(json.find("\"args\": {\"file\": \"../../template/Scene.rect\"}"), string::npos);
+}
+
+TEST(driver, PROFILE_VM)
+{
+    vector<string> paths = scenePaths();
+
+    Options options;
+    options.profileVm = true;
+    Driver d(options);
+    d.compile(paths);
+
+    const runtime::VmProfiler &p = d.profiler();
+    EXPECT_GT(p.instructions(), 0u);
+    EXPECT_GE(p.maxFrames(), 2u);
+    EXPECT_GT(p.maxOperands(), 0u);
+
+    uint64_t calls = 0;
+    uint64_t instructions = 0;
+    bool rectangleDraw = false;
+    for (auto &f : p.functions())
+    {
+        calls += f.calls;
+        instructions += f.instructions;
+        EXPECT_GE(f.totalNs, f.selfNs);
+        if (f.name == "main")
+        {
+            EXPECT_EQ(f.calls, 1u);
+        }
+        rectangleDraw = rectangleDraw || f.name == "Rectangle::draw";
+    }
+    EXPECT_TRUE(rectangleDraw);
+    EXPECT_EQ(instructions, p.instructions());
+    // the call of main is made by the machine itself
+    EXPECT_EQ(p.opcode(backend::instr::CALL).count + 1, calls);
+    EXPECT_EQ(p.opcode(backend::instr::RET).count, calls);
+
+    uint64_t lineInstructions = 0;
+    for (auto &l : p.lines())
+    {
+        EXPECT_GT(l.line, 0);
+        lineInstructions += l.count;
+    }
+    EXPECT_GT(lineInstructions, 0u);
+    EXPECT_LE(lineInstructions, p.instructions());
+}
+
+TEST(driver, LINE_TABLE)
+{
+    vector<string> paths = scenePaths();
+
+    Driver d;
+    unique_ptr<backend::AsmBin> bin = d.build(paths);
+    ASSERT_TRUE(bin != nullptr);
+
+    const vector<string> &files = bin->sourceFiles();
+    EXPECT_NE(find(files.begin(), files.end(), "../../template/Rectangle.rect"), files.end());
+
+    vector<backend::AsmBin::SourceLocation> table = bin->lineTable();
+    ASSERT_GT(table.size(), 0u);
+    int addr = -1;
+    for (auto &row : table)
+    {
+        EXPECT_GT(row.addr, addr);
+        EXPECT_LT(row.addr, bin->codeSize());
+        addr = row.addr;
+        if (row.isValid())
+        {
+            EXPECT_LT(row.file, static_cast<int>(files.size()));
+            EXPECT_GT(row.line, 0);
+            EXPECT_GT(row.column, 0);
+        }
+
+        backend::AsmBin::SourceLocation loc = bin->location(row.addr);
+        EXPECT_EQ(loc.addr, row.addr);
+        EXPECT_EQ(loc.file, row.file);
+        EXPECT_EQ(loc.line, row.line);
+        EXPECT_EQ(loc.column, row.column);
+    }
+
+    // the first statement of draw() is in the file of the component
+    backend::AsmBin::FunctionItem draw = bin->getFunction("Rectangle::draw");
+    backend::AsmBin::SourceLocation loc = bin->location(draw.addr);
+    ASSERT_TRUE(loc.isValid());
+    EXPECT_EQ(files[static_cast<size_t>(loc.file)], "../../template/Rectangle.rect");
+}
@@ -0,0 +1,103 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "framerenderer.h"
+#include "driver.h"
+#include "testhelper.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::backend;
+using namespace rectangle::driver;
+using namespace rectangle::runtime;
+
+static const vector<string> paths = testhelper::scenePaths();
+
+TEST(framerenderer, FIRST_FRAME)
+{
+    Driver d;
+    unique_ptr<AsmBin> bin = d.build(paths);
+    ASSERT_TRUE(bin != nullptr);
+
+    FrameRenderer renderer(*bin);
+    EXPECT_EQ(renderer.render(), d.compile(paths));
+    EXPECT_EQ(renderer.evaluatedBindings(), static_cast<int>(bin->bindings().size()));
+    EXPECT_EQ(renderer.redrawnInstances(), static_cast<int>(bin->instances().size()));
+
+    string svg = renderer.render();
+    EXPECT_EQ(renderer.evaluatedBindings(), 0);
+    EXPECT_EQ(renderer.redrawnInstances(), 0);
+    EXPECT_EQ(svg, d.compile(paths));
+}
+
+TEST(framerenderer, SET_PROPERTY)
+{
+    Driver d;
+    unique_ptr<AsmBin> bin = d.build(paths);
+    ASSERT_TRUE(bin != nullptr);
+
+    FrameRenderer incremental(*bin);
+    incremental.render();
+
+    EXPECT_FALSE(incremental.setProperty("root", "no_such_property", Object(1)));
+    EXPECT_FALSE(incremental.setProperty("root", "width", Object(string("1"))));
+    EXPECT_TRUE(incremental.setProperty("root", "width", Object(400)));
+    string svg = incremental.render();
+
+    // root.width, tl.x, tr.x, bl.x and x of the last rectangle
+    EXPECT_EQ(incremental.property("tl", "x").intData(), 200);
+    EXPECT_EQ(incremental.property("tr", "x").intData(), 300);
+    EXPECT_EQ(incremental.evaluatedBindings(), 5);
+    EXPECT_LT(incremental.redrawnInstances(), static_cast<int>(bin->instances().size()));
+
+    FrameRenderer full(*bin);
+    full.setProperty("root", "width", Object(400));
+    EXPECT_EQ(svg, full.render());
+    EXPECT_NE(svg, d.compile(paths));
+}
+
+TEST(framerenderer, HIT_TEST)
+{
+    Driver d;
+    unique_ptr<AsmBin> bin = d.build(paths);
+    ASSERT_TRUE(bin != nullptr);
+
+    FrameRenderer renderer(*bin);
+    renderer.render();
+    // svg coordinates, the margins are 50
+    EXPECT_EQ(renderer.instanceAt(520, 470), "tl");
+    EXPECT_EQ(renderer.instanceAt(600, 100), "tr");
+    // on the line drawn over tl
+    EXPECT_EQ(renderer.instanceAt(450, 450), "#12");
+    EXPECT_EQ(renderer.instanceAt(-100, -100), "");
+    vector<string> ids = renderer.instancesIn(draw::Rect{560, 60, 640, 140});
+    EXPECT_EQ(ids, vector<string>({"root", "tr", "#12"}));
+
+    // the index follows the next frame
+    renderer.setProperty("root", "width", Object(400));
+    renderer.render();
+    EXPECT_EQ(renderer.instanceAt(270, 470), "tl");
+    EXPECT_NE(renderer.instanceAt(520, 470), "tl");
+}
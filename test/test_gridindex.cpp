@@ -0,0 +1,46 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "gridindex.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+
+TEST(gridindex, INSERT)
+{
+    GridIndex index(Rect{0, 0, 100, 100}, 10, 10);
+    index.insert(Rect{5, 5, 15, 15}, 0);
+    index.insert(Rect{-50, 90, 0, 200}, 1);
+
+    EXPECT_EQ(index.cell(12, 12).size(), 1u);
+    EXPECT_TRUE(index.cell(50, 50).empty());
+    ASSERT_EQ(index.cell(-20, 150).size(), 1u);
+    EXPECT_EQ(index.cell(-20, 150)[0], 1);
+    EXPECT_EQ(index.cellCount(Rect{5, 5, 15, 15}), 4);
+    EXPECT_EQ(index.cellCount(Rect{-50, 90, 0, 200}), 1);
+
+    set<int> ids;
+    index.forEach(Rect{0, 0, 100, 100}, [&ids](int id) { ids.insert(id); });
+    EXPECT_EQ(ids.size(), 2u);
+}
@@ -0,0 +1,66 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "deflate.h"
+#include "gzipsink.h"
+#include "inflater.h"
+#include "outputsink.h"
+#include "testhelper.h"
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+#include <string>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle::util;
+using namespace testhelper;
+
+TEST(gzipsink, COMPRESS)
+{
+    string text = makeSvgLikeText(200 * 1000);
+    string out;
+    {
+        StringSink sink(out);
+        GzipSink gzip(sink, 6);
+        gzip.write(text);
+        gzip.finish();
+    }
+
+    ASSERT_GT(out.size(), 18u);
+    EXPECT_EQ(static_cast<unsigned char>(out[0]), 0x1f);
+    EXPECT_EQ(static_cast<unsigned char>(out[1]), 0x8b);
+    string body = out.substr(10);
+    string inflated;
+    Inflater inflater(body);
+    ASSERT_TRUE(inflater.run(inflated));
+    EXPECT_TRUE(inflated == text);
+
+    ASSERT_EQ(body.size(), inflater.end() + 8);
+    uint32_t crc = 0;
+    uint32_t size = 0;
+    for (int i = 3; i >= 0; i--)
+    {
+        crc = crc << 8 | static_cast<unsigned char>(body[inflater.end() + i]);
+        size = size << 8 | static_cast<unsigned char>(body[inflater.end() + 4 + i]);
+    }
+    EXPECT_EQ(crc, crc32(0, text.data(), text.size()));
+    EXPECT_EQ(size, text.size());
+}
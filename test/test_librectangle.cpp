@@ -0,0 +1,161 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "librectangle.h"
+#include "driver.h"
+#include "testhelper.h"
+#include "util.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace std;
+using namespace rectangle;
+using namespace testhelper;
+
+static rect_module *createModule(vector<string> &codes)
+{
+    vector<string> paths = templatePaths();
+    vector<rect_source> sources;
+    for (auto &path : paths)
+    {
+        codes.push_back(util::readFile(path));
+    }
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        sources.push_back({ paths[i].c_str(), codes[i].data(), codes[i].size() });
+    }
+
+    rect_module *module = nullptr;
+    EXPECT_EQ(rect_module_create(sources.data(), sources.size(), 0, &module), RECT_OK);
+    return module;
+}
+
+TEST(librectangle, RENDER)
+{
+    EXPECT_EQ(rect_api_version(), RECT_API_VERSION);
+
+    vector<string> codes;
+    rect_module *module = createModule(codes);
+    ASSERT_TRUE(module != nullptr);
+
+    string code = util::readFile(instancePath());
+    rect_source instance = { instancePath().c_str(), code.data(), code.size() };
+
+    string expected = driver::Driver(Options()).compile(scenePaths());
+    ASSERT_FALSE(expected.empty());
+
+    size_t size = 0;
+    EXPECT_EQ(rect_render(module, &instance, RECT_FORMAT_SVG, nullptr, 0, &size),
+              RECT_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_EQ(size, expected.size());
+    EXPECT_NE(string(rect_last_error()), "");
+
+    vector<char> buffer(size);
+    EXPECT_EQ(rect_render(module, &instance, RECT_FORMAT_SVG, buffer.data(), buffer.size(), &size),
+              RECT_OK);
+    EXPECT_EQ(string(buffer.data(), size), expected);
+    EXPECT_EQ(string(rect_last_error()), "");
+
+    buffer.resize(64 * 1024);
+    EXPECT_EQ(rect_render(module, &instance, RECT_FORMAT_PPM, buffer.data(), buffer.size(), &size),
+              RECT_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_EQ(string(buffer.data(), 2), "P6");
+
+    rect_module_free(module);
+}
+
+TEST(librectangle, ERRORS)
+{
+    vector<string> codes;
+    rect_module *module = createModule(codes);
+    ASSERT_TRUE(module != nullptr);
+
+    string code = "Rectangle {\n    wdth: 100\n}\n";
+    rect_source instance = { "bad.rect", code.data(), code.size() };
+    char buffer[16];
+    size_t size = 0;
+    EXPECT_EQ(rect_render(module, &instance, RECT_FORMAT_SVG, buffer, sizeof(buffer), &size),
+              RECT_ERROR_COMPILE);
+    string error = rect_last_error();
+    EXPECT_EQ(error.compare(0, 10, "bad.rect:2"), 0);
+    EXPECT_NE(error.find("no property named \"wdth\""), string::npos);
+
+    EXPECT_EQ(rect_render(module, nullptr, RECT_FORMAT_SVG, buffer, sizeof(buffer), &size),
+              RECT_ERROR_INVALID_ARGUMENT);
+    rect_module_free(module);
+
+    rect_source definition = { "Bad.rect", code.data(), code.size() };
+    EXPECT_EQ(rect_module_create(&definition, 1, 0, &module), RECT_ERROR_COMPILE);
+    EXPECT_TRUE(module == nullptr);
+}
+
+TEST(librectangle, CONCURRENT)
+{
+    vector<string> codes;
+    rect_module *module = createModule(codes);
+    ASSERT_TRUE(module != nullptr);
+    rect_module_set_cache_capacity(module, 2);
+
+    vector<string> instances;
+    vector<string> expected;
+    for (int i = 0; i < 4; i++)
+    {
+        string code = "Scene {\n    width: 100\n    height: 100\n"
+                      "    Rectangle {\n        x: " + to_string(i * 10) +
+                      "\n        width: 20\n        height: 20\n    }\n}\n";
+        instances.push_back(code);
+
+        char buffer[4096];
+        size_t size = 0;
+        rect_source instance = { "instance.rect", code.data(), code.size() };
+        EXPECT_EQ(rect_render(module, &instance, RECT_FORMAT_SVG, buffer, sizeof(buffer), &size),
+                  RECT_OK);
+        expected.emplace_back(buffer, size);
+    }
+
+    vector<string> results(32);
+    vector<thread> threads;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            const string &code = instances[i % instances.size()];
+            rect_source instance = { "instance.rect", code.data(), code.size() };
+            char buffer[4096];
+            size_t size = 0;
+            if (rect_render(module, &instance, RECT_FORMAT_SVG, buffer, sizeof(buffer), &size) == RECT_OK)
+            {
+                results[i].assign(buffer, size);
+            }
+        });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        EXPECT_EQ(results[i], expected[i % instances.size()]);
+    }
+    rect_module_free(module);
+}
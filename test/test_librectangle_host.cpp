@@ -0,0 +1,88 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "librectangle.h"
+#include "phasetimer.h"
+#include "testhelper.h"
+#include "util.h"
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace testing;
+using namespace std;
+using namespace rectangle;
+using namespace testhelper;
+
+// the allocator of the host, librectangle must not bring its own
+static atomic<size_t> g_hostAllocations(0);
+
+void *operator new(size_t size)
+{
+    g_hostAllocations.fetch_add(1, memory_order_relaxed);
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p)
+    {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+TEST(librectangle, HOST_ALLOCATOR)
+{
+    EXPECT_FALSE(util::allocStatsAvailable());
+
+    vector<string> paths = templatePaths();
+    vector<string> codes;
+    vector<rect_source> sources;
+    for (auto &path : paths)
+    {
+        codes.push_back(util::readFile(path));
+    }
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        sources.push_back({ paths[i].c_str(), codes[i].data(), codes[i].size() });
+    }
+
+    size_t before = g_hostAllocations.load();
+    rect_module *module = nullptr;
+    ASSERT_EQ(rect_module_create(sources.data(), sources.size(), 0, &module), RECT_OK);
+    EXPECT_GT(g_hostAllocations.load(), before);
+
+    string code = util::readFile(instancePath());
+    rect_source instance = { "instance.rect", code.data(), code.size() };
+    vector<char> buffer(64 * 1024);
+    size_t size = 0;
+    before = g_hostAllocations.load();
+    EXPECT_EQ(rect_render(module, &instance, RECT_FORMAT_SVG, buffer.data(), buffer.size(), &size),
+              RECT_OK);
+    EXPECT_GT(g_hostAllocations.load(), before);
+    EXPECT_EQ(string(buffer.data(), 4), "<svg");
+
+    rect_module_free(module);
+}
@@ -43,14 +43,19 @@ using namespace rectangle::runtime;
 
 TEST(machine, run)
 {
-    option::verbose = true;
+    Options options;
+    options.printSymbolDef = true;
+    options.printLLTry = true;
+    options.printBindingDep = true;
+    options.printAssemble = true;
+    options.printSvgDraw = true;
 
     ifstream t("../rect/test_machine.rect");
     stringstream buffer;
     buffer << t.rdbuf();
     string code = buffer.str();
 
-    Parser p;
+    Parser p(options);
     Lexer l;
     auto tokens = l.scan(code);
     unique_ptr<DocumentDecl> document = p.parse(tokens);
@@ -59,17 +64,17 @@ TEST(machine, run)
     AST ast;
     ast.addDocument(move(document));
 
-    SymbolVisitor sv;
+    SymbolVisitor sv(options);
     sv.visit(&ast);
 
     AsmVisitor av;
     AsmText txt = av.visit(&ast);
     txt.dump();
 
-    AsmBin bin(txt);
+    AsmBin bin(txt, options);
     bin.dump();
 
-    AsmMachine machine;
+    AsmMachine machine(options);
     string svg = machine.run(bin, "Rectangle::main");
 
     printf("%s\n", svg.c_str());
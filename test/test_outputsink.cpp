@@ -0,0 +1,115 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "outputsink.h"
+#include "svgpainter.h"
+
+#include <gtest/gtest.h>
+
+#include <limits.h>
+
+#include <string>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::util;
+using namespace rectangle::draw;
+
+TEST(outputsink, WRITE)
+{
+    string out;
+    {
+        StringSink sink(out);
+        sink.writeInt(0);
+        sink.write(' ');
+        sink.writeInt(-42);
+        sink.write(' ');
+        sink.writeInt(INT_MAX);
+        sink.write(' ');
+        sink.writeInt(INT_MIN);
+        sink.write(" ok");
+    }
+    EXPECT_EQ(out, "0 -42 2147483647 -2147483648 ok");
+}
+
+TEST(outputsink, BUFFER_SINK)
+{
+    char buffer[8];
+    {
+        BufferSink sink(buffer, sizeof(buffer));
+        sink.write("0123");
+        sink.flush();
+        EXPECT_FALSE(sink.truncated());
+        EXPECT_EQ(sink.bytesWritten(), 4u);
+    }
+    EXPECT_EQ(string(buffer, 4), "0123");
+
+    BufferSink sink(buffer, sizeof(buffer));
+    sink.write("0123456789");
+    sink.flush();
+    EXPECT_TRUE(sink.truncated());
+    EXPECT_FALSE(sink.failed());
+    EXPECT_EQ(sink.bytesWritten(), 10u);
+    EXPECT_EQ(string(buffer, sizeof(buffer)), "01234567");
+}
+
+TEST(outputsink, LARGE_WRITE)
+{
+    string out;
+    string expected;
+    {
+        StringSink sink(out);
+        string longText(200000, 'x');
+        sink.print("<%s>", longText.c_str());
+        expected += "<" + longText + ">";
+        for (int i = 0; i < 1000; i++)
+        {
+            sink.writeInt(i);
+            expected += to_string(i);
+        }
+        EXPECT_EQ(sink.bytesWritten(), expected.size());
+    }
+    EXPECT_EQ(out, expected);
+}
+
+TEST(outputsink, LONG_TEXT)
+{
+    SvgPainter painter;
+    TextData d;
+    d.x = 0;
+    d.y = 0;
+    d.size = 10;
+    d.text = string(1000, 'a');
+    painter.draw(d);
+
+    string svg = painter.generate();
+    EXPECT_NE(svg.find(d.text + "</text>"), string::npos);
+}
+
+TEST(outputsink, FORMAT_INT)
+{
+    const int values[] = {0, 9, 10, 99, 100, 12345, 1000000, -1, -10, -99999,
+                          INT_MAX, INT_MIN};
+    for (int n : values)
+    {
+        char buf[kMaxIntLength];
+        char *end = formatInt(buf, n);
+        EXPECT_EQ(string(buf, end), to_string(n));
+    }
+}
@@ -0,0 +1,223 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include "image.h"
+#include "rasterizer.h"
+#include "svgpainter.h"
+#include "threadpool.h"
+#include "tilerenderer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace rectangle::util;
+
+static const uint32_t kRed = Image::pack(255, 0, 0, 255);
+
+static RectangleData makeRect(int x, int y, int width, int height,
+                              const string &color)
+{
+    RectangleData d;
+    d.x = x;
+    d.y = y;
+    d.width = width;
+    d.height = height;
+    d.fill_color = color;
+    d.stroke_width = 0;
+    d.stroke_color = "none";
+    d.stroke_dasharray = "";
+    return d;
+}
+
+TEST(rasterizer, PARSE_COLOR)
+{
+    uint32_t color = 0;
+    EXPECT_TRUE(Rasterizer::parseColor("red", color));
+    EXPECT_EQ(color, kRed);
+    EXPECT_TRUE(Rasterizer::parseColor("#f00", color));
+    EXPECT_EQ(color, kRed);
+    EXPECT_TRUE(Rasterizer::parseColor("#ff000080", color));
+    EXPECT_EQ(Image::red(color), 128);
+    EXPECT_EQ(Image::alpha(color), 128);
+    EXPECT_TRUE(Rasterizer::parseColor("transparent", color));
+    EXPECT_EQ(color, 0u);
+    EXPECT_FALSE(Rasterizer::parseColor("#12", color));
+    EXPECT_FALSE(Rasterizer::parseColor("no-such-color", color));
+}
+
+TEST(rasterizer, RECTANGLE)
+{
+    SvgPainter painter;
+    painter.draw(makeRect(2, 3, 17, 4, "red"));
+    // half transparent blue over the right part
+    painter.draw(makeRect(10, 0, 20, 20, "rgba(0,0,255,0.5)"));
+
+    Image image(32, 16);
+    Rasterizer(image).draw(painter.displayList());
+    EXPECT_EQ(image.pixel(1, 3), 0u);
+    EXPECT_EQ(image.pixel(2, 3), kRed);
+    EXPECT_EQ(image.pixel(9, 6), kRed);
+    EXPECT_EQ(image.pixel(9, 7), 0u);
+    for (int x = 10; x < 19; x++)
+    {
+        uint32_t p = image.pixel(x, 4);
+        EXPECT_EQ(Image::red(p), 127);
+        EXPECT_EQ(Image::blue(p), 128);
+        EXPECT_EQ(Image::alpha(p), 255);
+    }
+    EXPECT_EQ(Image::alpha(image.pixel(25, 4)), 128);
+    EXPECT_EQ(image.pixel(30, 4), 0u);
+}
+
+TEST(rasterizer, FILL_RULE)
+{
+    // a square drawn twice around, the center has winding number 2
+    PolygonData d;
+    d.x = 0;
+    d.y = 0;
+    d.points = {0, 0, 10, 0, 10, 10, 0, 10, 0, 0, 10, 0, 10, 10, 0, 10};
+    d.fill_color = "red";
+    d.stroke_width = 0;
+    d.stroke_color = "none";
+    d.stroke_dasharray = "";
+
+    SvgPainter painter;
+    d.fill_rule = "nonzero";
+    painter.draw(d);
+    d.x = 20;
+    d.fill_rule = "evenodd";
+    painter.draw(d);
+
+    Image image(32, 16);
+    Rasterizer(image).draw(painter.displayList());
+    EXPECT_EQ(image.pixel(5, 5), kRed);
+    EXPECT_EQ(image.pixel(25, 5), 0u);
+}
+
+TEST(rasterizer, CLIP)
+{
+    SvgPainter painter;
+    painter.draw(makeRect(0, 0, 32, 16, "red"));
+
+    Image image(32, 16);
+    Rasterizer(image, Rect{8, 4, 16, 8}).draw(painter.displayList());
+    EXPECT_EQ(image.pixel(7, 5), 0u);
+    EXPECT_EQ(image.pixel(8, 4), kRed);
+    EXPECT_EQ(image.pixel(15, 7), kRed);
+    EXPECT_EQ(image.pixel(16, 7), 0u);
+    EXPECT_EQ(image.pixel(15, 8), 0u);
+}
+
+TEST(rasterizer, STROKE_AND_TEXT)
+{
+    SvgPainter painter;
+    PolylineData line;
+    line.x = 0;
+    line.y = 0;
+    line.points = {2, 2, 20, 2, 20, 12};
+    line.stroke_width = 2;
+    line.stroke_color = "red";
+    line.stroke_dasharray = "";
+    painter.draw(line);
+    TextData text;
+    text.x = 0;
+    text.y = 20;
+    text.size = 8;
+    text.text = "|";
+    painter.draw(text);
+
+    Image image(32, 32);
+    Rasterizer(image).draw(painter.displayList());
+    EXPECT_EQ(image.pixel(10, 1), kRed);
+    EXPECT_EQ(image.pixel(10, 2), kRed);
+    EXPECT_EQ(image.pixel(10, 3), 0u);
+    EXPECT_EQ(image.pixel(20, 7), kRed);
+    // '|' is the middle column of the glyph
+    EXPECT_EQ(image.pixel(2, 23), Image::pack(0, 0, 0, 255));
+    EXPECT_EQ(image.pixel(1, 23), 0u);
+}
+
+TEST(rasterizer, WRITE)
+{
+    Image image(3, 2);
+    image.row(0)[0] = kRed;
+
+    string ppm;
+    {
+        StringSink sink(ppm);
+        image.writePpm(sink);
+    }
+    string header = "P6\n3 2\n255\n";
+    ASSERT_EQ(ppm.size(), header.size() + 18);
+    EXPECT_EQ(ppm.substr(0, header.size()), header);
+    EXPECT_EQ(ppm.substr(header.size(), 6),
+              string("\xff\x00\x00\xff\xff\xff", 6));
+
+    string png;
+    {
+        StringSink sink(png);
+        image.writePng(sink);
+    }
+    EXPECT_EQ(png.substr(0, 8), string("\x89PNG\r\n\x1a\n", 8));
+    EXPECT_EQ(png.substr(12, 4), "IHDR");
+    // IEND chunk with its fixed crc
+    EXPECT_EQ(png.substr(png.size() - 12),
+              string("\x00\x00\x00\x00IEND\xae\x42\x60\x82", 12));
+}
+
+TEST(rasterizer, TILES)
+{
+    SvgPainter painter;
+    for (int i = 0; i < 40; i++)
+    {
+        painter.draw(makeRect(i * 7 % 50, i * 13 % 40, 5 + i % 11, 3 + i % 17,
+                              i % 3 ? "rgba(0,128,255,0.5)" : "#a0a0a0"));
+        EllipseData e;
+        e.x = i * 11 % 60;
+        e.y = i * 5 % 45;
+        e.x_radius = 2 + i % 9;
+        e.y_radius = 3 + i % 5;
+        e.fill_color = "yellow";
+        e.stroke_width = i % 4;
+        e.stroke_color = "black";
+        e.stroke_dasharray = "";
+        painter.draw(e);
+    }
+
+    Image expected(64, 48);
+    Rasterizer(expected).draw(painter.displayList());
+
+    ThreadPool pool(3);
+    Image tiled(64, 48);
+    TileRenderer renderer(7);
+    renderer.render(painter.displayList(), tiled, pool);
+    EXPECT_EQ(renderer.tileCount(), 10 * 7);
+    for (int y = 0; y < 48; y++)
+    {
+        for (int x = 0; x < 64; x++)
+        {
+            ASSERT_EQ(tiled.pixel(x, y), expected.pixel(x, y));
+        }
+    }
+}
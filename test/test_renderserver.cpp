@@ -0,0 +1,360 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "driver.h"
+#include "outputsink.h"
+#include "renderserver.h"
+#include "testhelper.h"
+#include "util.h"
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace rectangle;
+using namespace rectangle::driver;
+using namespace testhelper;
+
+static string u32(uint32_t n)
+{
+    string s(4, '\0');
+    s[0] = static_cast<char>(n >> 24);
+    s[1] = static_cast<char>(n >> 16);
+    s[2] = static_cast<char>(n >> 8);
+    s[3] = static_cast<char>(n);
+    return s;
+}
+
+static uint32_t readU32(const string &s, size_t pos)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(s.data() + pos);
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+           static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+}
+
+struct Answer
+{
+    uint32_t id;
+    uint32_t status;
+    string data;
+};
+
+// the complete responses at the start of data, in the order they came
+static vector<Answer> parseResponses(const string &data, size_t &pos)
+{
+    vector<Answer> answers;
+    pos = 0;
+    while (pos + 12 <= data.size())
+    {
+        uint32_t size = readU32(data, pos + 8);
+        if (pos + 12 + size > data.size())
+        {
+            break;
+        }
+        answers.push_back({ readU32(data, pos), readU32(data, pos + 4), data.substr(pos + 12, size) });
+        pos += 12 + size;
+    }
+    return answers;
+}
+
+// the responses of server.serve() to requests written to a pipe, which is
+// also stdout of the process while serving if asStdout, as with --serve=-
+static string serveOverPipes(RenderServer &server, const string &requests, bool asStdout = false)
+{
+    int in[2];
+    int out[2];
+    EXPECT_EQ(pipe(in), 0);
+    EXPECT_EQ(pipe(out), 0);
+    thread writer([&]()
+    {
+        EXPECT_EQ(write(in[1], requests.data(), requests.size()),
+                  static_cast<ssize_t>(requests.size()));
+        close(in[1]);
+    });
+    string responses;
+    thread reader([&]()
+    {
+        char buffer[4096];
+        ssize_t n = 0;
+        while ((n = read(out[0], buffer, sizeof(buffer))) > 0)
+        {
+            responses.append(buffer, static_cast<size_t>(n));
+        }
+    });
+    int savedStdout = -1;
+    if (asStdout)
+    {
+        fflush(stdout);
+        savedStdout = dup(STDOUT_FILENO);
+        EXPECT_GE(dup2(out[1], STDOUT_FILENO), 0);
+    }
+    EXPECT_TRUE(server.serve(in[0], out[1]));
+    if (asStdout)
+    {
+        fflush(stdout);
+        dup2(savedStdout, STDOUT_FILENO);
+        close(savedStdout);
+    }
+    close(out[1]);
+    writer.join();
+    reader.join();
+    close(in[0]);
+    close(out[0]);
+    return responses;
+}
+
+TEST(renderserver, SERVE)
+{
+    string instance = util::readFile(instancePath());
+    string bad = "Rectangle {\n    wdth: 100\n}\n";
+    string expected = Driver(Options()).compile(scenePaths());
+
+    RenderServer server(Options(), templatePaths());
+    server.setReloadInterval(0);
+    ASSERT_TRUE(server.load());
+
+    const uint32_t count = 16;
+    string requests;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const string &doc = i == 3 ? bad : instance;
+        requests += u32(i) + u32(static_cast<uint32_t>(doc.size())) + doc;
+    }
+    string responses = serveOverPipes(server, requests);
+
+    size_t pos = 0;
+    map<uint32_t, Answer> results;
+    for (auto &a : parseResponses(responses, pos))
+    {
+        results[a.id] = a;
+    }
+    EXPECT_EQ(pos, responses.size());
+    ASSERT_EQ(results.size(), count);
+    for (auto &r : results)
+    {
+        if (r.first == 3)
+        {
+            EXPECT_EQ(r.second.status, RenderServer::Error);
+            EXPECT_EQ(r.second.data.compare(0, 10, "request:2:"), 0);
+        }
+        else
+        {
+            EXPECT_EQ(r.second.status, RenderServer::Ok);
+            EXPECT_EQ(r.second.data, expected);
+        }
+    }
+}
+
+TEST(renderserver, PRINT)
+{
+    // the Rectangle of this defination calls print() in draw()
+    vector<string> definations = templatePaths();
+    definations[1] = "../rect/symbol_instance_defination.rect";
+    string instance = util::readFile(instancePath());
+
+    vector<string> paths = definations;
+    paths.push_back(instancePath());
+    string expected = Driver(Options()).compile(paths);
+
+    RenderServer server(Options(), definations);
+    server.setReloadInterval(0);
+    ASSERT_TRUE(server.load());
+
+    const uint32_t count = 4;
+    string requests;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        requests += u32(i) + u32(static_cast<uint32_t>(instance.size())) + instance;
+    }
+    string responses = serveOverPipes(server, requests, true);
+
+    size_t pos = 0;
+    vector<Answer> answers = parseResponses(responses, pos);
+    EXPECT_EQ(pos, responses.size());
+    ASSERT_EQ(answers.size(), count);
+    for (auto &a : answers)
+    {
+        EXPECT_EQ(a.status, RenderServer::Ok);
+        EXPECT_EQ(a.data, expected);
+    }
+}
+
+TEST(renderserver, MAX_PENDING)
+{
+    string instance = util::readFile(instancePath());
+
+    RenderServer server(Options(), templatePaths());
+    server.setReloadInterval(0);
+    ASSERT_TRUE(server.load());
+    // a request is only read once the one before it is answered
+    server.setMaxPendingRequests(1);
+
+    const uint32_t count = 16;
+    string requests;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        requests += u32(i) + u32(static_cast<uint32_t>(instance.size())) + instance;
+    }
+    string responses = serveOverPipes(server, requests);
+
+    size_t pos = 0;
+    vector<Answer> answers = parseResponses(responses, pos);
+    ASSERT_EQ(answers.size(), count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(answers[i].id, i);
+        EXPECT_EQ(answers[i].status, RenderServer::Ok);
+    }
+}
+
+TEST(renderserver, LISTEN)
+{
+    string instance = util::readFile(instancePath());
+
+    // ppm tiles are rendered on the pool the request already runs on
+    Options options;
+    options.format = "ppm";
+    options.parallelRaster = true;
+    vector<string> paths = scenePaths();
+    Options serial = options;
+    serial.parallelRaster = false;
+    string expected;
+    {
+        util::StringSink sink(expected);
+        ASSERT_TRUE(Driver(serial).compile(paths, sink));
+    }
+    ASSERT_EQ(expected.compare(0, 3, "P6\n"), 0);
+
+    RenderServer server(options, templatePaths());
+    server.setReloadInterval(0);
+    ASSERT_TRUE(server.load());
+
+    TempDir dir;
+    string path = dir.file("serve.sock");
+    bool listened = false;
+    thread listener([&]() { listened = server.listen(path); });
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    int fd = -1;
+    for (int i = 0; i < 500 && fd < 0; i++)
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            close(fd);
+            fd = -1;
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+    }
+    ASSERT_GE(fd, 0);
+
+    const uint32_t count = 2;
+    string requests;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        requests += u32(i) + u32(static_cast<uint32_t>(instance.size())) + instance;
+    }
+    EXPECT_EQ(write(fd, requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+
+    string responses;
+    vector<Answer> answers;
+    size_t pos = 0;
+    char buffer[4096];
+    while (answers.size() < count)
+    {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            break;
+        }
+        responses.append(buffer, static_cast<size_t>(n));
+        answers = parseResponses(responses, pos);
+    }
+    ASSERT_EQ(answers.size(), count);
+    for (auto &a : answers)
+    {
+        EXPECT_EQ(a.status, RenderServer::Ok);
+        EXPECT_EQ(a.data, expected);
+    }
+
+    // stopping closes the connections and removes the socket
+    server.stop();
+    listener.join();
+    EXPECT_TRUE(listened);
+    EXPECT_EQ(read(fd, buffer, sizeof(buffer)), 0);
+    close(fd);
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
+
+TEST(renderserver, RELOAD)
+{
+    TempDir dir;
+    string path = dir.file("Rectangle.rect");
+    string rectangle = util::readFile("../../template/Rectangle.rect");
+    string::size_type pos = rectangle.find("int width: 100");
+    ASSERT_NE(pos, string::npos);
+    {
+        ofstream f(path);
+        f << rectangle;
+    }
+
+    vector<string> paths = templatePaths();
+    paths[1] = path;
+    RenderServer server(Options(), paths);
+    server.setReloadInterval(0);
+    ASSERT_TRUE(server.load());
+    EXPECT_FALSE(server.reloadIfChanged());
+
+    string doc = "Scene {\n    width: 500\n    height: 500\n"
+                 "    Rectangle {\n        x: 5\n    }\n}\n";
+    RenderServer::Response before = server.render(doc);
+    ASSERT_EQ(before.status, RenderServer::Ok) << before.data;
+    EXPECT_NE(before.data.find("width=\"100\""), string::npos);
+
+    {
+        ofstream f(path);
+        f << rectangle.replace(pos, 14, "int width: 1234");
+    }
+    EXPECT_TRUE(server.reloadIfChanged());
+    RenderServer::Response after = server.render(doc);
+    ASSERT_EQ(after.status, RenderServer::Ok) << after.data;
+    EXPECT_NE(after.data.find("width=\"1234\""), string::npos);
+
+    // a broken defination keeps the last module in use
+    {
+        ofstream f(path);
+        f << "def Rectangle {\n";
+    }
+    EXPECT_FALSE(server.reloadIfChanged());
+    EXPECT_EQ(server.render(doc).data, after.data);
+}
@@ -0,0 +1,66 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "shapeindex.h"
+#include "testhelper.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace testhelper;
+
+TEST(shapeindex, HIT_TEST)
+{
+    DisplayList list;
+    list.append(makeRect(0, "red"), 0, 0, 0);
+    // only the stroke of a rectangle without fill is hit
+    list.append(makeRect(0, "none"), 5, 0, 1);
+    EllipseData e{30, 40, 20, 10, "blue", 0, "none", ""};
+    list.append(e, 0, 0, 2);
+    PolygonData p{100, 0, {0, 0, 40, 0, 0, 40}, "green", "nonzero", 0, "none", ""};
+    list.append(p, 0, 0, 3);
+    LineData l{0, 100, 0, 0, 100, 0, 4, "black", ""};
+    list.append(l, 0, 0, 4);
+
+    ShapeIndex index(list);
+    EXPECT_EQ(index.itemsAt(7, 10), vector<int>({0}));
+    EXPECT_EQ(index.itemsAt(5, 10), vector<int>({1, 0}));
+    EXPECT_EQ(index.instanceAt(5, 10), 1);
+    EXPECT_EQ(index.topmostAt(15, 10), 1);
+    EXPECT_EQ(index.topmostAt(12, 10), -1);
+
+    EXPECT_EQ(index.instanceAt(50, 50), 2);
+    EXPECT_EQ(index.instanceAt(69, 50), 2);
+    EXPECT_EQ(index.instanceAt(50, 58), 2);
+    EXPECT_EQ(index.instanceAt(68, 58), -1);
+
+    EXPECT_EQ(index.instanceAt(110, 10), 3);
+    EXPECT_EQ(index.instanceAt(130, 30), -1);
+
+    EXPECT_EQ(index.instanceAt(50, 101), 4);
+    EXPECT_EQ(index.instanceAt(50, 103), -1);
+
+    EXPECT_EQ(index.itemsIn(Rect{0, 0, 200, 200}), vector<int>({0, 1, 2, 3, 4}));
+    EXPECT_EQ(index.itemsIn(Rect{45, 30, 105, 55}), vector<int>({2, 3}));
+    EXPECT_TRUE(index.itemsIn(Rect{300, 300, 400, 400}).empty());
+}
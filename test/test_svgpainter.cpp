@@ -0,0 +1,179 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "svgpainter.h"
+#include "testhelper.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace testing;
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace testhelper;
+
+TEST(svgpainter, POLYLINE_POINTS)
+{
+    SvgPainter painter;
+    PolylineData d;
+    d.x = 5;
+    d.y = -5;
+    d.stroke_width = 1;
+    d.stroke_color = "black";
+    d.stroke_dasharray = "";
+    for (int i = 0; i < 50000; i++)
+    {
+        d.points.push_back(i);
+        d.points.push_back(-i);
+    }
+    painter.draw(d);
+
+    string svg = painter.generate();
+    EXPECT_NE(svg.find("points=\"5,-5 6,-6 7,-7 "), string::npos);
+    EXPECT_NE(svg.find(" 50004,-50004 \""), string::npos);
+}
+
+TEST(svgpainter, CSS_STYLES)
+{
+    SvgPainter painter;
+    painter.setStyleMode(SvgPainter::StyleMode::Class);
+    painter.draw(makeRect(1, "red"));
+    painter.draw(makeRect(2, "blue"));
+    painter.draw(makeRect(3, "red"));
+
+    string svg = painter.generate();
+    EXPECT_NE(svg.find(".s0 {fill:red; stroke-width:1; stroke:black; "
+                       "stroke-dasharray:}\n"),
+              string::npos);
+    EXPECT_NE(svg.find(".s1 {fill:blue;"), string::npos);
+    EXPECT_EQ(svg.find(".s2"), string::npos);
+    EXPECT_NE(svg.find("<rect x=\"3\" y=\"0\" width=\"10\" height=\"20\" "
+                       "class=\"s0\"/>"),
+              string::npos);
+    EXPECT_EQ(svg.find("style=\""), string::npos);
+}
+
+TEST(svgpainter, USE_SYMBOLS)
+{
+    SvgPainter painter;
+    painter.setUseSymbols(true);
+    for (int i = 0; i < 3; i++)
+    {
+        painter.setInstance(i);
+        painter.pushOrigin(100 * i, 50);
+        painter.draw(makeRect(1, i == 2 ? "blue" : "red"));
+        painter.draw(makePolyline(5));
+        painter.popOrigin();
+    }
+    painter.setInstance(-1);
+
+    string svg = painter.generate();
+    EXPECT_EQ(svg.find("<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                       "xmlns:xlink=\"http://www.w3.org/1999/xlink\" version=\"1.1\""),
+              0u);
+    EXPECT_NE(svg.find("    <defs>\n"
+                       "        <symbol id=\"u0\" overflow=\"visible\">\n"
+                       "            <rect x=\"0\" y=\"0\" width=\"10\""),
+              string::npos);
+    EXPECT_NE(svg.find("<polyline points=\"4,0 9,1 \""), string::npos);
+    EXPECT_NE(svg.find("    <use xlink:href=\"#u0\" x=\"1\" y=\"50\"/>\n"
+                       "    <use xlink:href=\"#u0\" x=\"101\" y=\"50\"/>\n"
+                       "    <rect x=\"201\" y=\"50\""),
+              string::npos);
+    EXPECT_EQ(svg.find("u1"), string::npos);
+}
+
+TEST(svgpainter, CULL_OUTSIDE_SCENE)
+{
+    SvgPainter painter;
+    painter.defineScene(SceneData{10, 10, 10, 10, 100, 100});
+    painter.draw(makeRect(50, "red"));
+    painter.draw(makeRect(500, "red"));
+    // only the stroke reaches into the scene
+    painter.draw(makeRect(-10, "red"));
+    painter.draw(makePolyline(200));
+    TextData text;
+    text.x = -30;
+    text.y = 0;
+    text.size = 10;
+    text.text = "abcd";
+    painter.draw(text);
+
+    const DisplayList &list = painter.displayList();
+    Rect r = list.bounds(list.items()[0]);
+    EXPECT_EQ(r.left, 49);
+    EXPECT_EQ(r.right, 61);
+    EXPECT_EQ(r.bottom, 21);
+    r = list.bounds(list.items()[4]);
+    EXPECT_EQ(r.right, 10);
+
+    EXPECT_EQ(painter.cullOutsideScene(), 2);
+    ASSERT_EQ(list.items().size(), 3u);
+    EXPECT_EQ(list.rectangle(list.items()[1].index).x, -10);
+    EXPECT_EQ(list.items()[2].type, ShapeType::Text);
+}
+
+TEST(svgpainter, CULL_OCCLUDED)
+{
+    SvgPainter painter;
+    painter.draw(makeRect(0, "red"));
+    painter.draw(makeRect(100, "red"));
+    painter.draw(makePolyline(3));
+    // covers the first rectangle and the polyline
+    RectangleData cover = makeRect(-5, "#00ff00");
+    cover.y = -5;
+    cover.width = 30;
+    cover.height = 30;
+    painter.draw(cover);
+    // transparent, hides nothing
+    RectangleData glass = makeRect(90, "transparent");
+    glass.width = 50;
+    painter.draw(glass);
+
+    EXPECT_EQ(painter.cullOccluded(), 2);
+    const DisplayList &list = painter.displayList();
+    ASSERT_EQ(list.items().size(), 3u);
+    EXPECT_EQ(list.rectangle(list.items()[0].index).x, 100);
+    EXPECT_EQ(list.rectangle(list.items()[1].index).x, -5);
+}
+
+TEST(svgpainter, CULL_OCCLUDED_LARGE)
+{
+    // opaque rectangles over most of the scene, none covering another
+    const int count = 2000;
+    SvgPainter painter;
+    RectangleData hidden = makeRect(count, "red");
+    hidden.y = count;
+    painter.draw(hidden);
+    for (int i = 0; i < count; i++)
+    {
+        RectangleData r = makeRect(i, "#00ff00");
+        r.y = i;
+        r.width = count;
+        r.height = count;
+        painter.draw(r);
+    }
+    painter.draw(makeRect(3 * count, "red"));
+
+    EXPECT_EQ(painter.cullOccluded(), 1);
+    const DisplayList &list = painter.displayList();
+    ASSERT_EQ(list.items().size(), static_cast<size_t>(count + 1));
+    EXPECT_EQ(list.rectangle(list.items()[0].index).x, 0);
+}
@@ -0,0 +1,99 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#include "svgpainter.h"
+#include "testhelper.h"
+#include "threadpool.h"
+#include "tiledsvgwriter.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <string>
+
+using namespace std;
+
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace testhelper;
+
+static int occurrences(const string &text, const string &s)
+{
+    int n = 0;
+    for (size_t pos = text.find(s); pos != string::npos; pos = text.find(s, pos + 1))
+    {
+        n++;
+    }
+    return n;
+}
+
+TEST(tiledsvgwriter, WRITE)
+{
+    SvgPainter painter;
+    SceneData scene;
+    scene.width = 1000;
+    scene.height = 600;
+    scene.leftMargin = 0;
+    scene.rightMargin = 0;
+    scene.topMargin = 0;
+    scene.bottomMargin = 0;
+    painter.defineScene(scene);
+    painter.draw(makeRect(10, "red"));
+    // spans the first two tiles of level 0
+    RectangleData wide = makeRect(400, "blue");
+    wide.width = 300;
+    painter.draw(wide);
+    RectangleData tiny = makeRect(900, "green");
+    tiny.y = 550;
+    tiny.width = 1;
+    tiny.height = 1;
+    tiny.stroke_width = 0;
+    painter.draw(tiny);
+
+    string dir;
+    {
+        TempDir tmp;
+        ASSERT_FALSE(tmp.path().empty());
+        dir = tmp.path();
+        string tiles = tmp.file("tiled_svg");
+        TiledSvgWriter writer(512, 2);
+        util::ThreadPool pool(2);
+        EXPECT_TRUE(writer.write(painter, tiles, pool));
+        // 2 x 2 tiles, then 1 tile at half scale
+        EXPECT_EQ(writer.tileCount(), 5);
+
+        string first = readBytes(tiles + "/0/0_0.svg");
+        EXPECT_NE(first.find("width=\"512\" height=\"512\" viewBox=\"0 0 512 512\""), string::npos);
+        EXPECT_EQ(occurrences(first, "<rect"), 2);
+        string last = readBytes(tiles + "/0/1_1.svg");
+        EXPECT_NE(last.find("width=\"488\" height=\"88\" viewBox=\"512 512 488 88\""), string::npos);
+        EXPECT_EQ(occurrences(last, "<rect"), 1);
+        EXPECT_EQ(occurrences(readBytes(tiles + "/0/1_0.svg"), "<rect"), 1);
+
+        // the 1 pixel rectangle is left out at half scale
+        string half = readBytes(tiles + "/1/0_0.svg");
+        EXPECT_NE(half.find("width=\"500\" height=\"300\" viewBox=\"0 0 1000 600\""), string::npos);
+        EXPECT_EQ(occurrences(half, "<rect"), 2);
+
+        string index = readBytes(tiles + "/index.json");
+        EXPECT_NE(index.find("{\"level\": 1, \"scale\": 2, \"columns\": 1, \"rows\": 1}"), string::npos);
+        EXPECT_NE(index.find("\"file\": \"0/1_1.svg\", \"shapes\": 1}"), string::npos);
+    }
+    // the tiles went with the directory
+    EXPECT_NE(access(dir.c_str(), F_OK), 0);
+}
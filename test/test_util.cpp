@@ -15,11 +15,18 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  ********************************************************************************/
 
+#include "option.h"
+#include "threadpool.h"
 #include "util.h"
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace testing;
@@ -28,6 +35,40 @@ using namespace std;
 using namespace rectangle;
 using namespace rectangle::util;
 
+TEST(util, COND_PRINT)
+{
+    int evaluated = 0;
+    auto arg = [&evaluated]()
+    {
+        evaluated++;
+        return "";
+    };
+
+    COND_PRINT(false, "%s", arg());
+    EXPECT_EQ(evaluated, 0);
+#ifndef RECTANGLE_NO_TRACE
+    COND_PRINT(true, "%s", arg());
+    EXPECT_EQ(evaluated, 1);
+#endif
+}
+
+TEST(util, OPTIONS_FROM_GLOBALS)
+{
+    bool verbose = option::verbose;
+    bool cssStyles = option::cssStyles;
+    option::verbose = true;
+    option::cssStyles = true;
+    Options options = Options::fromGlobals();
+    option::verbose = verbose;
+    option::cssStyles = cssStyles;
+
+    EXPECT_TRUE(options.printSymbolDef);
+    EXPECT_TRUE(options.printSvgDraw);
+    EXPECT_TRUE(options.cssStyles);
+    EXPECT_FALSE(options.parallelAnalyze);
+    EXPECT_EQ(options.tileSize, 512);
+}
+
 TEST(util, SPLIT_INTO_LINES)
 {
     {
@@ -60,4 +101,85 @@ TEST(util, SPLIT_INTO_LINES)
         vector<string> result = { "aa", "bb" };
         EXPECT_EQ(splitIntoLines(s), result);
     }
-}
\ No newline at end of file
+}
+TEST(util, THREAD_POOL)
+{
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.threadCount(), 4);
+
+    vector<int> done(1000, 0);
+    pool.parallelFor(1000, [&done](int i) { done[static_cast<size_t>(i)]++; });
+    EXPECT_EQ(done, vector<int>(1000, 1));
+
+    atomic<int> count(0);
+    for (int i = 0; i < 100; i++)
+    {
+        pool.submit([&count] { count++; });
+    }
+    pool.wait();
+    EXPECT_EQ(count, 100);
+}
+
+TEST(util, THREAD_POOL_BATCHES)
+{
+    ThreadPool pool(2);
+
+    // a parallelFor waits for its own tasks, not for a blocked one
+    mutex blockMutex;
+    condition_variable blockCond;
+    bool release = false;
+    pool.submit([&]
+    {
+        unique_lock<mutex> lock(blockMutex);
+        blockCond.wait(lock, [&release] { return release; });
+    });
+    atomic<int> count(0);
+    pool.parallelFor(100, [&count](int) { count++; });
+    EXPECT_EQ(count, 100);
+    {
+        lock_guard<mutex> lock(blockMutex);
+        release = true;
+    }
+    blockCond.notify_all();
+    pool.wait();
+
+    // concurrent callers and callers inside tasks of the same pool
+    vector<int> done(8 * 64, 0);
+    vector<thread> callers;
+    for (int c = 0; c < 4; c++)
+    {
+        callers.emplace_back([&pool, &done, c]
+        {
+            pool.parallelFor(2, [&pool, &done, c](int outer)
+            {
+                pool.parallelFor(64, [&done, c, outer](int i)
+                {
+                    done[static_cast<size_t>((c * 2 + outer) * 64 + i)]++;
+                });
+            });
+        });
+    }
+    for (auto &t : callers)
+    {
+        t.join();
+    }
+    EXPECT_EQ(done, vector<int>(8 * 64, 1));
+}
+
+TEST(util, THREAD_POOL_STEALING)
+{
+    ThreadPool pool(4);
+    // every index of the first block is slow, so the other workers run
+    // out of their own tasks and take those of worker 0
+    atomic<int> count(0);
+    pool.parallelFor(64, [&count](int i)
+    {
+        if (i < 16)
+        {
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+        count++;
+    });
+    EXPECT_EQ(count, 64);
+    EXPECT_GT(pool.stolenCount(), 0);
+}
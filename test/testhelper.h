@@ -0,0 +1,167 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+#pragma once
+
+#include "displaylist.h"
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+// Helpers shared by the tests, which run in test/build.
+namespace testhelper
+{
+
+// the component definations of template/
+inline std::vector<std::string> templatePaths()
+{
+    return
+    {
+        "../../template/Scene.rect",
+        "../../template/Rectangle.rect",
+        "../../template/Text.rect",
+        "../../template/Ellipse.rect",
+        "../../template/Polygon.rect",
+        "../../template/Line.rect",
+        "../../template/Polyline.rect"
+    };
+}
+
+// the instance document of test/rect most tests render
+inline std::string instancePath()
+{
+    return "../rect/symbol_instance_instance.rect";
+}
+
+// templatePaths() followed by the instance document, a complete scene
+inline std::vector<std::string> scenePaths(const std::string &instance = instancePath())
+{
+    std::vector<std::string> paths = templatePaths();
+    paths.push_back(instance);
+    return paths;
+}
+
+inline rectangle::draw::RectangleData makeRect(int x, const std::string &color)
+{
+    rectangle::draw::RectangleData d;
+    d.x = x;
+    d.y = 0;
+    d.width = 10;
+    d.height = 20;
+    d.fill_color = color;
+    d.stroke_width = 1;
+    d.stroke_color = "black";
+    d.stroke_dasharray = "";
+    return d;
+}
+
+inline rectangle::draw::PolylineData makePolyline(int x)
+{
+    rectangle::draw::PolylineData d;
+    d.x = x;
+    d.y = 0;
+    d.points = {0, 0, x, 1};
+    d.stroke_width = 1;
+    d.stroke_color = "black";
+    d.stroke_dasharray = "";
+    return d;
+}
+
+// about size bytes of svg elements, the same on every call
+inline std::string makeSvgLikeText(size_t size)
+{
+    std::string text;
+    srand(1);
+    while (text.size() < size)
+    {
+        text += "<rect x=\"" + std::to_string(rand() % 1000) + "\" y=\"" + std::to_string(rand() % 50) +
+                "\" style=\"fill:red\"/>\n";
+    }
+    return text;
+}
+
+// the whole content of the file at path, empty if it can not be read
+inline std::string readBytes(const std::string &path)
+{
+    std::string data;
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp)
+    {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        {
+            data.append(buffer, n);
+        }
+        fclose(fp);
+    }
+    return data;
+}
+
+inline bool writeBytes(const std::string &path, const std::string &data)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp)
+    {
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+    return fclose(fp) == 0 && ok;
+}
+
+// A directory created under /tmp, removed with everything below it when
+// the TempDir goes out of scope.
+class TempDir
+{
+public:
+    TempDir()
+    {
+        char dir[] = "/tmp/rectangle_test_XXXXXX";
+        if (mkdtemp(dir))
+        {
+            m_path = dir;
+        }
+    }
+    ~TempDir()
+    {
+        if (!m_path.empty())
+        {
+            nftw(m_path.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+        }
+    }
+    TempDir(const TempDir &) = delete;
+    TempDir &operator=(const TempDir &) = delete;
+
+    // empty if the directory could not be created
+    const std::string &path() const { return m_path; }
+    std::string file(const std::string &name) const { return m_path + "/" + name; }
+
+private:
+    static int removeEntry(const char *path, const struct stat *, int, struct FTW *)
+    {
+        return remove(path);
+    }
+
+private:
+    std::string m_path;
+};
+
+} // namespace testhelper
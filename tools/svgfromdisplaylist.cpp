@@ -0,0 +1,107 @@
+/*********************************************************************************
+ * Copyright (C) 2020  Jia Lihong
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "argsparser.h"
+#include "displaylistfile.h"
+#include "outputsink.h"
+#include "svgpainter.h"
+
+using namespace std;
+using namespace rectangle;
+using namespace rectangle::draw;
+using namespace rectangle::util;
+
+int main(int argc, char **argv) {
+  bool cssStyles = false;
+  bool useSymbols = false;
+  bool showHelp = false;
+  string output;
+
+  ArgsParser ap;
+  ap.addOnOffLongOption("css-styles",
+                        "Share styles of shapes through css classes",
+                        cssStyles);
+  ap.addOnOffLongOption("use-symbols",
+                        "Write instances drawn alike once as a symbol",
+                        useSymbols);
+  ap.addValueLongOption("output", "Write the svg to a file instead of stdout",
+                        output);
+  ap.addOnOffLongOption("help", "Show help", showHelp);
+
+  vector<string> files;
+  try {
+    files = ap.parse(argc, argv);
+  } catch (ArgsException &e) {
+    fprintf(stderr, "%s\n", e.what());
+    ap.dumpHelp();
+    return EXIT_FAILURE;
+  }
+  if (showHelp || files.size() != 1) {
+    fprintf(stderr, "Usage: svg-from-displaylist [options] <file>\n");
+    ap.dumpHelp();
+    return showHelp ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  DisplayListFile file;
+  if (!file.open(files[0])) {
+    fprintf(stderr, "error: %s\n", file.error().c_str());
+    return EXIT_FAILURE;
+  }
+  DisplayList list;
+  file.copyTo(list);
+
+  SvgPainter painter;
+  if (cssStyles) {
+    painter.setStyleMode(SvgPainter::StyleMode::Class);
+  }
+  painter.setUseSymbols(useSymbols);
+  painter.load(move(list), file.width(), file.height());
+
+  FILE *fp = stdout;
+  if (output.size()) {
+    fp = fopen(output.c_str(), "wb");
+    if (!fp) {
+      fprintf(stderr, "error: open %s failed\n", output.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  bool failed = false;
+  {
+    FileSink sink(fp);
+    painter.generate(sink);
+    sink.write('\n');
+    sink.flush();
+    failed = sink.failed();
+  }
+
+  if (fp != stdout) {
+    fclose(fp);
+  }
+  if (failed) {
+    fprintf(stderr, "error: write output failed\n");
+    return EXIT_FAILURE;
+  }
+  return 0;
+}